@@ -5,6 +5,7 @@
 #include "freertos/task.h"
 #include "esp32_home_ap.h"
 #include "freertos/semphr.h"
+#include "esp_timer.h"
 #include "esp_gpio_handling.h"
 #include "esp_bme680.h"
 
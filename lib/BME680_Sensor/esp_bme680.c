@@ -1,140 +1,673 @@
 #include "esp_bme680.h"
 
-struct bme68x_dev bme;
-struct bme68x_conf bme_conf;
-struct bme68x_heatr_conf heatr_conf;
-struct bme68x_data global_sensor_data; 
+/* Heater temperature in degree Celsius, the profile every sensor starts with */
+const uint16_t temp_prof[BME_HEATER_PROFILE_LEN] = { 200, 240, 280, 320, 360, 360, 320, 280, 240, 200 };
 
-SemaphoreHandle_t sensor_data_mutex;
-/* Heater temperature in degree Celsius */
-uint16_t temp_prof[10] = { 200, 240, 280, 320, 360, 360, 320, 280, 240, 200 };
+/* Heating duration in milliseconds, the profile every sensor starts with */
+const uint16_t dur_prof[BME_HEATER_PROFILE_LEN] = { 100, 100, 100, 100, 100, 100, 100, 100, 100, 100 };
 
-/* Heating duration in milliseconds */
-uint16_t dur_prof[10] = { 100, 100, 100, 100, 100, 100, 100, 100, 100, 100 };
+/* One instance per sensor found on the I2C buses, bme_sensor_count of them in use */
+static struct bme_sensor sensors[BME_MAX_SENSORS];
+static uint8_t bme_sensor_count;
+
+static struct bme_delay_stats delay_stats;
+static portMUX_TYPE delay_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* Wakes the acquisition task when the next field is predicted to be ready. All sensors are read from that one task */
+static struct bme_notify field_notify;
+
+
+static void user_delay_us(uint32_t period, void *intf_ptr);
+static void configHeater(struct bme_sensor* sensor);
+static void configBME(struct bme_sensor* sensor);
 
 
 /**
- * @brief Initialize the BME680 Sensor, including creating the sensor data mutex
- * 
+ * @brief Initialize every BME680 found on the I2C buses, including resetting its published snapshot and allocating its
+ * sample history
+ *
  */
 void initializeBME680(void)
 {
-    ESP_LOGI(tag, "Creating sensor data mutex");
-    sensor_data_mutex = xSemaphoreCreateMutex();
-    if(sensor_data_mutex == NULL)
+    if(bme_notify_init(&field_notify) != ESP_OK)
     {
-        ESP_LOGE(tag, "Failed to create sensor data mutex");
-        return;
+        ESP_LOGE(tag, "Failed to create the measurement completion timer");
     }
 
-    configureBme680Sensor();
+    bme_sensor_count = (bme_i2c_n_devs < BME_MAX_SENSORS) ? bme_i2c_n_devs : BME_MAX_SENSORS;
+    for(uint8_t i = 0; i < bme_sensor_count; i++)
+    {
+        struct bme_sensor* sensor = &sensors[i];
+
+        memset(sensor, 0, sizeof(struct bme_sensor));
+        sensor->index = i;
+        memcpy(sensor->temp_prof, temp_prof, sizeof(temp_prof));
+        memcpy(sensor->dur_prof, dur_prof, sizeof(dur_prof));
+        portMUX_INITIALIZE(&sensor->selftest_lock);
+        bme_snapshot_init(&sensor->snapshot);
+
+        ESP_LOGI(tag, "Allocating sensor %u history", (unsigned)i);
+        if(bme_history_init(&sensor->history, bme_sensor_count) != ESP_OK)
+        {
+            ESP_LOGE(tag, "Failed to allocate sensor %u history", (unsigned)i);
+        }
+
+        setupBmeI2C(&sensor->dev, BME68X_I2C_INTF, &bme_i2c_devs[i]); //We are using I2C for comms
+        configureBme680Sensor(sensor);
+
+        // Fields never come faster than the heater profile runs, so the raw ring reaches back at least this far
+        if(sensor->history.raw.capacity > 0)
+        {
+            uint8_t steps = ((BME_SAMPLE_MODE == BME68X_FORCED_MODE) || (sensor->heatr_conf.profile_len == 0)) ? 1 : sensor->heatr_conf.profile_len;
+            ESP_LOGI(tag, "Sensor %u raw history spans at least %lu min", (unsigned)i,
+                (unsigned long)(((uint64_t)sensor->history.raw.capacity * bmeProfileCycleUs(sensor)) / steps / 60000000));
+        }
+    }
 }
 
 /**
- * @brief Configure the BME680 Sensor. Includes bme structure and setting up heater parameters
- * 
+ * @brief Configure a BME680 Sensor. Includes bme structure and setting up heater parameters
+ *
+ * @param sensor
  */
-void configureBme680Sensor(void)
+void configureBme680Sensor(struct bme_sensor* sensor)
 {
-    setupBmeI2C(&bme, BME68X_I2C_INTF); //We are using I2C for comms
+    int8_t rslt = bme68x_init(&sensor->dev);
+    bme68x_check_rslt("bme68x_init", rslt);
+    if(rslt != BME68X_OK)
+    {
+        ESP_LOGE(tag, "Sensor %u left out of acquisition", (unsigned)sensor->index);
+        return;
+    }
 
+    rslt = bme68x_enable_shadow(BME_SHADOW_CHECK_PERIOD, &sensor->dev);
+    bme68x_check_rslt("bme68x_enable_shadow", rslt);
 
-    int8_t rslt = bme68x_init(&bme);
-    bme68x_check_rslt("bme68x_init", rslt);
-    
-    
-    rslt = bme68x_get_conf(&bme_conf, &bme);
+
+    rslt = bme68x_get_conf(&sensor->conf, &sensor->dev);
     bme68x_check_rslt("bme68x_get_conf", rslt);
 
-    configBME();
+    configBME(sensor);
+    sensor->ready = 1;
 }
 
+/**
+ * @brief Number of sensor instances, one per sensor found on the I2C buses
+ *
+ */
+uint8_t bmeSensorCount(void)
+{
+    return bme_sensor_count;
+}
 
-/** @brief user defined function for a us delay. 
+/**
+ * @brief Sensor instance by position, in the order of bme_i2c_devs
+ *
+ * @param index
+ * @return struct bme_sensor* NULL if there is no such sensor
+ */
+struct bme_sensor* bmeSensor(uint8_t index)
+{
+    return (index < bme_sensor_count) ? &sensors[index] : NULL;
+}
+
+
+/** @brief user defined function for a us delay.
+ *
+ * @details Sleeps whole ticks while at least one tick remains, so it never wakes early, then busy waits the rest if that
+ * is at most BME_DELAY_SPIN_MAX_US. A longer sub tick remainder sleeps one more tick instead of burning the CPU, which
+ * overshoots by less than a tick. Short driver delays such as BME68X_PERIOD_POLL are therefore neither rounded down to
+ * nothing nor stretched to a whole extra tick when a couple of ms would do.
+ *
  * @param period period of time to delay in us
  * @param int_ptr void pointer to extra information
- * 
+ *
  * @return void
 */
-void user_delay_us(uint32_t period, void *intf_ptr)
+static void user_delay_us(uint32_t period, void *intf_ptr)
 {
     (void)intf_ptr;
-    vTaskDelay(pdMS_TO_TICKS(period / 1000));
+    const int64_t tick_us = (int64_t)portTICK_PERIOD_MS * 1000;
+    int64_t start_us = esp_timer_get_time();
+    int64_t end_us = start_us + period;
+    int64_t remaining_us = period;
+    uint8_t spun = 0;
+
+    while(remaining_us > 0)
+    {
+        if(remaining_us <= BME_DELAY_SPIN_MAX_US)
+        {
+            esp_rom_delay_us((uint32_t)remaining_us);
+            spun = 1;
+            break;
+        }
+        // vTaskDelay(n) wakes between n - 1 and n ticks from now, so n = remaining / tick never oversleeps
+        TickType_t ticks = (TickType_t)(remaining_us / tick_us);
+        vTaskDelay((ticks > 0) ? ticks : 1);
+        remaining_us = end_us - esp_timer_get_time();
+    }
+
+    uint32_t actual_us = (uint32_t)(esp_timer_get_time() - start_us);
+    portENTER_CRITICAL(&delay_stats_lock);
+    delay_stats.calls++;
+    delay_stats.spins += spun;
+    delay_stats.requested_us += period;
+    delay_stats.actual_us += actual_us;
+    if((actual_us > period) && ((actual_us - period) > delay_stats.max_overshoot_us))
+    {
+        delay_stats.max_overshoot_us = actual_us - period;
+    }
+    portEXIT_CRITICAL(&delay_stats_lock);
+}
+
+/**
+ * @brief Copy out the statistics of the delay_us calls and of the waits for the sensors to complete a field
+ *
+ * @param stats
+ */
+void bmeGetDelayStats(struct bme_delay_stats* stats)
+{
+    portENTER_CRITICAL(&delay_stats_lock);
+    memcpy(stats, &delay_stats, sizeof(struct bme_delay_stats));
+    portEXIT_CRITICAL(&delay_stats_lock);
+}
+
+/**
+ * @brief Sleep until ready_us on the completion notifier and account the wait in delay_stats
+ *
+ */
+static void waitForField(int64_t ready_us)
+{
+    int64_t start_us = esp_timer_get_time();
+    uint8_t woken = bme_notify_wait_until(&field_notify, ready_us);
+    uint64_t waited_us = (uint64_t)(esp_timer_get_time() - start_us);
+
+    portENTER_CRITICAL(&delay_stats_lock);
+    delay_stats.waits += (woken == BME_NOTIFY_WOKEN) ? 1 : 0;
+    delay_stats.already_ready += (woken == BME_NOTIFY_SKIPPED) ? 1 : 0;
+    delay_stats.timeouts += (woken == BME_NOTIFY_TIMEOUT) ? 1 : 0;
+    delay_stats.waited_us += (woken == BME_NOTIFY_SKIPPED) ? 0 : waited_us;
+    portEXIT_CRITICAL(&delay_stats_lock);
 }
 
 /**
- * @brief Setup I2C communication with the BME680 sensor
- * 
- * @param bme 
- * @param intf 
+ * @brief Setup I2C communication with a BME680 sensor
+ *
+ * @param bme
+ * @param intf
+ * @param intf_ptr the struct bme_i2c_dev of the sensor
  */
-void setupBmeI2C(struct bme68x_dev* bme, uint8_t intf)
+void setupBmeI2C(struct bme68x_dev* bme, uint8_t intf, void* intf_ptr)
 {
     bme->intf = BME68X_I2C_INTF;
     bme->read = bme68x_i2c_read;
     bme->write = bme68x_i2c_write;
     bme->delay_us = user_delay_us;
+    bme->intf_ptr = intf_ptr;
     bme->amb_temp = 25;
 }
 
 /**
- * @brief Configure the heater settings for the BME680 sensor
- * 
+ * @brief Configure the heater settings for a BME680 sensor
+ *
+ * @param sensor
  */
-void configHeater(void)
+static void configHeater(struct bme_sensor* sensor)
 {
     int8_t rslt;
-    heatr_conf.enable = BME68X_ENABLE;
-    heatr_conf.heatr_temp_prof = temp_prof;
-    heatr_conf.heatr_dur_prof = dur_prof;
-    heatr_conf.profile_len = 10;
-    rslt = bme68x_set_heatr_conf(BME_SAMPLE_MODE, &heatr_conf, &bme);
-    bme68x_check_rslt("bme68x_set_heatr_conf", rslt);
+    sensor->heatr_conf.enable = BME68X_ENABLE;
+    sensor->heatr_conf.heatr_temp_prof = sensor->temp_prof;
+    sensor->heatr_conf.heatr_dur_prof = sensor->dur_prof;
+    sensor->heatr_conf.profile_len = BME_HEATER_PROFILE_LEN;
+    sensor->heatr_conf.heatr_temp = sensor->temp_prof[0];      // forced mode heats at the first profile step
+    sensor->heatr_conf.heatr_dur = sensor->dur_prof[0];
+    rslt = bme68x_compile_heatr_conf(BME_SAMPLE_MODE, &sensor->heatr_conf, &sensor->heatr_image, &sensor->dev);
+    bme68x_check_rslt("bme68x_compile_heatr_conf", rslt);
+    if(rslt == BME68X_OK)
+    {
+        rslt = bme68x_set_heatr_image(&sensor->heatr_image, &sensor->dev);
+        bme68x_check_rslt("bme68x_set_heatr_image", rslt);
+    }
 }
 
 /**
- * @brief Configure the BME680 Sensor with desired settings
- * 
+ * @brief Restart the ready time prediction for a profile that starts now
+ *
  */
-void configBME(void)
+static void restartFieldPrediction(struct bme_sensor* sensor)
+{
+    // The first field is heater step 0, starting now. Pretend the step before it just finished
+    sensor->last_gas_index = sensor->heatr_conf.profile_len - 1;
+    sensor->last_ready_us = esp_timer_get_time();
+    sensor->started_us = sensor->last_ready_us;
+}
+
+/**
+ * @brief Configure a BME680 Sensor with desired settings
+ *
+ * @param sensor
+ */
+static void configBME(struct bme_sensor* sensor)
 {
     int8_t rslt;
-    bme_conf.os_temp = BME68X_OS_2X;
-    bme_conf.os_pres = BME68X_OS_16X;
-    bme_conf.os_hum = BME68X_OS_1X;
-    bme_conf.filter = BME68X_FILTER_OFF;
-    bme_conf.odr = BME68X_ODR_NONE;
+    sensor->conf.os_temp = BME68X_OS_2X;
+    sensor->conf.os_pres = BME68X_OS_16X;
+    sensor->conf.os_hum = BME68X_OS_1X;
+    sensor->conf.filter = BME68X_FILTER_OFF;
+    sensor->conf.odr = BME68X_ODR_NONE;
 
-    rslt = bme68x_set_conf(&bme_conf, &bme);
+    rslt = bme68x_set_conf(&sensor->conf, &sensor->dev);
     bme68x_check_rslt("bme68x_set_conf", rslt);
 
-    configHeater();
+    configHeater(sensor);
 
-    rslt = bme68x_set_op_mode(BME_SAMPLE_MODE, &bme);
+    rslt = bme68x_set_op_mode(BME_SAMPLE_MODE, &sensor->dev);
     bme68x_check_rslt("bme68x_set_op_mode", rslt);
+
+    restartFieldPrediction(sensor);
 }
 
-void measureBME680Data(struct bme68x_data* bme_data)
+/**
+ * @brief Time a sensor takes to produce one field with its current configuration
+ *
+ * @details TPH conversion time for the configured oversampling plus the heater duration of the step. Sequential mode heats for
+ * that step's heatr_dur_prof entry, forced mode for heatr_dur and parallel mode for the shared heater duration.
+ *
+ * @param sensor
+ * @param gas_index heater profile step the field is measured at
+ * @return uint32_t duration in us, without any margin
+ */
+uint32_t bmeFieldDurationUs(struct bme_sensor* sensor, uint8_t gas_index)
 {
+    const struct bme68x_heatr_conf* heatr_conf = &sensor->heatr_conf;
+    uint32_t dur_us = bme68x_get_meas_dur(BME_SAMPLE_MODE, &sensor->conf, &sensor->dev);
+
+    if(heatr_conf->enable != BME68X_ENABLE)
+    {
+        return dur_us;
+    }
+    if(BME_SAMPLE_MODE == BME68X_PARALLEL_MODE)
+    {
+        dur_us += (uint32_t)heatr_conf->shared_heatr_dur * 1000;
+    }
+    else if(BME_SAMPLE_MODE == BME68X_FORCED_MODE)
+    {
+        dur_us += (uint32_t)heatr_conf->heatr_dur * 1000;
+    }
+    else if(heatr_conf->profile_len > 0)
+    {
+        dur_us += (uint32_t)heatr_conf->heatr_dur_prof[gas_index % heatr_conf->profile_len] * 1000;
+    }
+    return dur_us;
+}
+
+/**
+ * @brief Time a sensor takes to run through its whole heater profile once
+ *
+ * @param sensor
+ * @return uint32_t duration in us, without any margin
+ */
+uint32_t bmeProfileCycleUs(struct bme_sensor* sensor)
+{
+    uint32_t cycle_us = 0;
+    uint8_t steps = ((BME_SAMPLE_MODE == BME68X_FORCED_MODE) || (sensor->heatr_conf.profile_len == 0)) ? 1 : sensor->heatr_conf.profile_len;
+
+    for(uint8_t i = 0; i < steps; i++)
+    {
+        cycle_us += bmeFieldDurationUs(sensor, i);
+    }
+    return cycle_us;
+}
+
+/**
+ * @brief Heater step that follows gas_index in the sensor's profile
+ *
+ */
+static uint8_t nextGasIndex(const struct bme_sensor* sensor, uint8_t gas_index)
+{
+    if((BME_SAMPLE_MODE == BME68X_FORCED_MODE) || (sensor->heatr_conf.profile_len == 0))
+    {
+        return 0;
+    }
+    return (gas_index + 1) % sensor->heatr_conf.profile_len;
+}
+
+/**
+ * @brief Time the sensor's next field is predicted to be ready, margin included, esp_timer_get_time() us
+ *
+ */
+static int64_t nextFieldReadyUs(struct bme_sensor* sensor)
+{
+    uint32_t dur_us = bmeFieldDurationUs(sensor, nextGasIndex(sensor, sensor->last_gas_index));
+
+    return sensor->last_ready_us + dur_us + BME_WAIT_MARGIN_US + ((dur_us / 1000) * BME_WAIT_MARGIN_PERMILLE);
+}
+
+/**
+ * @brief Advance the ready time prediction over the fields just read
+ *
+ * @details Each field's ready time is the previous one plus its own duration, walking the heater profile step by step
+ * so fields the sensor produced while nobody was reading are accounted for too. A prediction in the future means the
+ * sensor runs fast, so it is pulled back to now.
+ *
+ * @param ready_us receives each field's predicted ready time, clamped the same way
+ */
+static void trackFieldsRead(struct bme_sensor* sensor, const struct bme68x_data* fields, int64_t* ready_us, uint8_t n_fields, int64_t now_us)
+{
+    for(uint8_t i = 0; i < n_fields; i++)
+    {
+        uint8_t steps = 0;
+        do
+        {
+            sensor->last_gas_index = nextGasIndex(sensor, sensor->last_gas_index);
+            sensor->last_ready_us += bmeFieldDurationUs(sensor, sensor->last_gas_index);
+        } while((sensor->last_gas_index != fields[i].gas_index) && (++steps < BME_HEATER_PROFILE_LEN));
+        ready_us[i] = (sensor->last_ready_us > now_us) ? now_us : sensor->last_ready_us;
+    }
+    if(sensor->last_ready_us > now_us)
+    {
+        sensor->last_ready_us = now_us;
+    }
+}
+
+/**
+ * @brief Keep the heater registers calculated for the temperature the sensor is at
+ *
+ * @details res_heat_x depends on the ambient temperature, 25 C until the first measurement. Once the newest field is
+ * BME_HEATER_AMB_DRIFT_C or more away from the temperature the heater image was compiled for, it is compiled again.
+ * Only if any register changed is the image written, which puts the sensor to sleep, so the profile is then started
+ * again from step 0.
+ *
+ * @param sensor
+ * @param newest most recent field read
+ * @return uint8_t 1 if the sensor was put to sleep and started again
+ */
+static uint8_t trackAmbientTemp(struct bme_sensor* sensor, const struct bme68x_data* newest)
+{
+    struct bme68x_heatr_image image;
     int8_t rslt;
-    uint8_t n_fields = 1;
+    int32_t amb_temp;
+    int32_t drift;
+
+    #ifdef BME68X_USE_FPU
+    amb_temp = (int32_t)(newest->temperature + ((newest->temperature < 0) ? -0.5f : 0.5f));
+    #else
+    amb_temp = (newest->temperature + ((newest->temperature < 0) ? -50 : 50)) / 100;
+    #endif
+
+    drift = amb_temp - sensor->heatr_image.amb_temp;
+    if((drift < BME_HEATER_AMB_DRIFT_C) && (drift > -BME_HEATER_AMB_DRIFT_C))
+    {
+        return 0;
+    }
+
+    sensor->dev.amb_temp = (int8_t)((amb_temp > INT8_MAX) ? INT8_MAX : ((amb_temp < INT8_MIN) ? INT8_MIN : amb_temp));
+    rslt = bme68x_compile_heatr_conf(BME_SAMPLE_MODE, &sensor->heatr_conf, &image, &sensor->dev);
+    if(rslt != BME68X_OK)
+    {
+        bme68x_check_rslt("bme68x_compile_heatr_conf", rslt);
+        return 0;
+    }
+    if(memcmp(image.res_heat, sensor->heatr_image.res_heat, image.len) == 0)
+    {
+        sensor->heatr_image.amb_temp = image.amb_temp;
+        return 0;
+    }
 
-    uint32_t del_period = bme68x_get_meas_dur(BME_SAMPLE_MODE, &bme_conf, &bme) + (1000 * 1000); //delay period appears to be in units of us. Dividing this down will decrease the delay
+    ESP_LOGI(tag, "Sensor %u heater registers recalculated for %d C", (unsigned)sensor->index, image.amb_temp);
+    rslt = bme68x_set_heatr_image(&image, &sensor->dev);
+    bme68x_check_rslt("bme68x_set_heatr_image", rslt);
+    if(rslt == BME68X_OK)
+    {
+        memcpy(&sensor->heatr_image, &image, sizeof(struct bme68x_heatr_image));
+    }
 
-    bme.delay_us( (del_period * DELAY_FACTOR) , bme.intf_ptr);
-    
-    rslt = bme68x_get_data(BME_SAMPLE_MODE, bme_data, &n_fields, &bme);
+    rslt = bme68x_set_op_mode(BME_SAMPLE_MODE, &sensor->dev);
+    bme68x_check_rslt("bme68x_set_op_mode", rslt);
+    restartFieldPrediction(sensor);
+    return 1;
+}
+
+/**
+ * @brief Ask the acquisition task to run a sensor's self-test. Safe to call from any task
+ *
+ * @details The test starts on the sensor's next acquisition and takes BME68X_SELFTEST_STEPS forced mode measurements,
+ * about 13 s. The sensor publishes no fields meanwhile, the other sensors keep sampling normally. A request while a
+ * test is running is ignored.
+ *
+ * @param sensor
+ */
+void bmeRequestSelfTest(struct bme_sensor* sensor)
+{
+    portENTER_CRITICAL(&sensor->selftest_lock);
+    if(sensor->selftest_status.state != BME68X_SELFTEST_RUNNING)
+    {
+        sensor->selftest_status.requested = 1;
+    }
+    portEXIT_CRITICAL(&sensor->selftest_lock);
+}
+
+/**
+ * @brief Copy out a sensor's self-test progress. Safe to call from any task
+ *
+ * @param sensor
+ * @param status
+ */
+void bmeGetSelfTestStatus(struct bme_sensor* sensor, struct bme_selftest_status* status)
+{
+    portENTER_CRITICAL(&sensor->selftest_lock);
+    memcpy(status, &sensor->selftest_status, sizeof(struct bme_selftest_status));
+    portEXIT_CRITICAL(&sensor->selftest_lock);
+}
+
+/**
+ * @brief Whether the sensor's acquisitions currently run its self-test
+ *
+ */
+static uint8_t selfTestPending(struct bme_sensor* sensor)
+{
+    portENTER_CRITICAL(&sensor->selftest_lock);
+    uint8_t pending = sensor->selftest_status.requested || (sensor->selftest_status.state == BME68X_SELFTEST_RUNNING);
+    portEXIT_CRITICAL(&sensor->selftest_lock);
+    return pending;
+}
+
+/**
+ * @brief Start the self-test or advance it by one measurement, in place of a normal acquisition
+ *
+ * @details Never waits: if the measurement the test is on has not had its time yet, the call returns without touching
+ * the bus. The test's measurements are never handed back as fields: they heat alternately to the test's high and low
+ * temperature, so publishing them would put spikes into the sensor's gas resistance series. The sensor publishes
+ * nothing until the test is done and the acquisition settings are written back.
+ *
+ * @return int8_t BME68X_W_NO_NEW_DATA, or the error the test step failed with
+ */
+static int8_t runSelfTest(struct bme_sensor* sensor)
+{
+    int8_t rslt;
+    uint8_t n_new = 0;
+
+    if(sensor->selftest.state != BME68X_SELFTEST_RUNNING)
+    {
+        ESP_LOGI(tag, "Starting sensor %u self-test", (unsigned)sensor->index);
+        rslt = bme68x_selftest_start(&sensor->selftest, &sensor->dev);
+        bme68x_check_rslt("bme68x_selftest_start", rslt);
+    }
+    else if(esp_timer_get_time() < sensor->selftest_due_us)
+    {
+        return BME68X_W_NO_NEW_DATA;
+    }
+    else
+    {
+        rslt = bme68x_selftest_step(&sensor->selftest, NULL, &n_new, &sensor->dev);
+    }
+    sensor->selftest_due_us = esp_timer_get_time() + sensor->selftest.wait_us;      // wait_us holds the BME_WAIT_MARGIN_US margin
+
+    if(sensor->selftest.state == BME68X_SELFTEST_DONE)
+    {
+        bme68x_check_rslt("bme68x_selftest", sensor->selftest.rslt);
+        ESP_LOGI(tag, "Sensor %u self-test %s", (unsigned)sensor->index, (sensor->selftest.rslt == BME68X_OK) ? "passed" : "failed");
+        configBME(sensor);
+    }
+
+    portENTER_CRITICAL(&sensor->selftest_lock);
+    sensor->selftest_status.requested = 0;
+    sensor->selftest_status.state = sensor->selftest.state;
+    sensor->selftest_status.step = sensor->selftest.step;
+    if(sensor->selftest.state == BME68X_SELFTEST_DONE)
+    {
+        sensor->selftest_status.rslt = sensor->selftest.rslt;
+        sensor->selftest_status.runs++;
+    }
+    portEXIT_CRITICAL(&sensor->selftest_lock);
+
+    return (rslt < BME68X_OK) ? rslt : BME68X_W_NO_NEW_DATA;
+}
+
+/**
+ * @brief Time the sensor's next acquisition is due, esp_timer_get_time() us
+ *
+ * @details The predicted ready time of its next field, or while it runs its self-test, the time the test's current
+ * measurement completes. A requested self-test is due at once.
+ */
+static int64_t sensorDueUs(struct bme_sensor* sensor)
+{
+    if(!selfTestPending(sensor))
+    {
+        return nextFieldReadyUs(sensor);
+    }
+    return (sensor->selftest.state == BME68X_SELFTEST_RUNNING) ? sensor->selftest_due_us : 0;
+}
+
+/**
+ * @brief Start the next forced mode measurement as soon as the last one was read
+ *
+ * @details Forced mode measures once and sleeps. Triggering again right after the read out keeps the sensor measuring
+ * back to back, at the highest rate its conversion and heater durations allow. Sequential and parallel mode keep
+ * measuring on their own.
+ */
+static void retriggerForced(struct bme_sensor* sensor)
+{
+    if(BME_SAMPLE_MODE == BME68X_FORCED_MODE)
+    {
+        int8_t rslt = bme68x_set_op_mode(BME68X_FORCED_MODE, &sensor->dev);
+        bme68x_check_rslt("bme68x_set_op_mode", rslt);
+        restartFieldPrediction(sensor);
+    }
+}
+
+/**
+ * @brief Read the sensor's field registers exactly once and decode the new fields
+ *
+ * @details In forced mode bme68x_get_data polls a field that is not ready yet up to BME68X_FIELD_READ_TRIES times,
+ * BME68X_PERIOD_POLL apart. The caller has already waited out the measurement, so the field is read once here and a
+ * late one is left to the ready time prediction. Sequential and parallel mode reads never poll.
+ *
+ */
+static int8_t getFieldsOnce(struct bme_sensor* sensor, struct bme68x_data* data, uint8_t* n_data)
+{
+    int8_t rslt;
+
+    if(BME_SAMPLE_MODE == BME68X_FORCED_MODE)
+    {
+        struct bme68x_raw_data raw;
+        rslt = bme68x_get_raw_fields(BME68X_FORCED_MODE, &raw, n_data, &sensor->dev);
+        if(rslt == BME68X_OK)
+        {
+            rslt = bme68x_decode_raw_fields(&raw, data, *n_data, &sensor->dev);
+        }
+    }
+    else
+    {
+        rslt = bme68x_get_data(BME_SAMPLE_MODE, data, n_data, &sensor->dev);
+    }
+    return rslt;
+}
+
+/**
+ * @brief Read every new field a sensor has buffered, or advance its self-test, without waiting
+ *
+ * @details Called once the sensor is due, see sensorDueUs. If the field is not there yet, that single read is all it
+ * costs: the prediction moves one margin past now, so nothing ever polls the sensor. A failed read moves it the same
+ * way. In forced mode a failed read, or a field overdue by BME_FORCED_LOST_FIELDS field durations, triggers the sensor
+ * again instead: the trigger may never have reached it, and a forced mode sensor that is not triggered sleeps for good.
+ *
+ */
+static int8_t readSensorFields(struct bme_sensor* sensor, struct bme68x_data* fields, int64_t* ready_us, uint8_t max_fields, uint8_t* n_fields)
+{
+    int8_t rslt;
+    uint8_t n_new = 0;
+    uint8_t first = 0;
+    struct bme68x_data sensor_fields[BME_MAX_FIELDS];
+    int64_t sensor_ready_us[BME_MAX_FIELDS];
+    #ifdef PRINT_SENSOR_DATA
+    struct bme_i2c_stats bus_before, bus_after;
+    #endif
+
+    *n_fields = 0;
+
+    if(selfTestPending(sensor))
+    {
+        return runSelfTest(sensor);
+    }
+
+    #ifdef PRINT_SENSOR_DATA
+    bme_i2c_get_stats(&bus_before);
+    #endif
+    rslt = getFieldsOnce(sensor, sensor_fields, &n_new);
     bme68x_check_rslt("bme68x_get_data", rslt);
-    
     #ifdef PRINT_SENSOR_DATA
-    if(rslt == BME68X_OK)
+    bme_i2c_get_stats(&bus_after);
+    printf("Sensor %u bme68x_get_data: %lu I2C transfers\n", (unsigned)sensor->index, (long unsigned int)((bus_after.reads + bus_after.writes) - (bus_before.reads + bus_before.writes)));
+    #endif
+    if(rslt == BME68X_W_NO_NEW_DATA)
+    {
+        portENTER_CRITICAL(&delay_stats_lock);
+        delay_stats.not_ready++;
+        portEXIT_CRITICAL(&delay_stats_lock);
+    }
+    if(rslt != BME68X_OK)
     {
+        uint32_t dur_us = bmeFieldDurationUs(sensor, nextGasIndex(sensor, sensor->last_gas_index));
+        int64_t now_us = esp_timer_get_time();
 
+        if((BME_SAMPLE_MODE == BME68X_FORCED_MODE) && ((rslt < BME68X_OK) || ((now_us - sensor->started_us) > ((int64_t)dur_us * BME_FORCED_LOST_FIELDS))))
+        {
+            retriggerForced(sensor);
+        }
+        else
+        {
+            // The sensor runs slow or did not answer. Move the prediction so the next field is expected one margin from now
+            sensor->last_ready_us = now_us - dur_us;
+        }
+        return rslt;
+    }
+    trackFieldsRead(sensor, sensor_fields, sensor_ready_us, n_new, esp_timer_get_time());
+    if((n_new == 0) || !trackAmbientTemp(sensor, &sensor_fields[n_new - 1]))
+    {
+        retriggerForced(sensor);
+    }
 
+    if(n_new > max_fields)
+    {
+        first = n_new - max_fields;
+        n_new = max_fields;
+    }
+    memcpy(fields, &sensor_fields[first], n_new * sizeof(struct bme68x_data));
+    if(ready_us != NULL)
+    {
+        memcpy(ready_us, &sensor_ready_us[first], n_new * sizeof(int64_t));
+    }
+    *n_fields = n_new;
+
+    #ifdef PRINT_SENSOR_DATA
+    for(uint8_t i = 0; i < n_new; i++)
+    {
+    struct bme68x_data* bme_data = &fields[i];
 
     #ifdef BME68X_USE_FPU
-    printf("%lu, %.2f, %.2f, %.2f, %.2f, 0x%x, %d, %d\n",
-        sample_count,
+    printf("%u: %.2f, %.2f, %.2f, %.2f, 0x%x, %d, %d\n",
+        (unsigned)sensor->index,
         bme_data->temperature,
         bme_data->pressure,
         bme_data->humidity,
@@ -143,16 +676,159 @@ void measureBME680Data(struct bme68x_data* bme_data)
         bme_data->gas_index,
         bme_data->meas_index);
     #else
-    printf("Temperature (C): %d | Pressure (Pa): %lu | Humidity (%%): %lu\n",
+    printf("Sensor %u | Temperature (C): %d | Pressure (Pa): %lu | Humidity (%%): %lu | Gas index: %d | Meas index: %d\n",
+        (unsigned)sensor->index,
         (bme_data->temperature / 100),
         (long unsigned int)(bme_data->pressure),
-        (long unsigned int)(bme_data->humidity / 1000)
+        (long unsigned int)(bme_data->humidity / 1000),
+        bme_data->gas_index,
+        bme_data->meas_index
     );
     #endif
 
     }
-    #endif  
+    #endif
+
+    return rslt;
 }
 
+/**
+ * @brief Wait for a sensor and read every new field it has buffered
+ *
+ * @details The wait is derived from the configured oversampling and heater durations: it lasts until the field after
+ * the newest one read so far is predicted to be ready, plus a small margin, and is skipped if that time has passed.
+ * The task blocks on a task notification from a one shot timer for the whole wait, then reads the sensor once. If the
+ * field is not there yet, the prediction moves and the next call waits again. While a self-test is requested or
+ * running, the call advances it instead without waiting, see runSelfTest.
+ * In sequential and parallel mode bme68x_get_data fills up to BME_MAX_FIELDS records per call, sorted oldest first.
+ * All of the new ones are handed back, each still tagged with its gas_index and meas_index. If the caller has fewer
+ * slots than there are new fields, the newest ones are kept. In forced mode the next measurement is triggered right
+ * after the read out.
+ *
+ * @param sensor
+ * @param fields caller array to receive the new fields, oldest first
+ * @param ready_us caller array to receive each field's predicted ready time, esp_timer_get_time() us. May be NULL
+ * @param max_fields number of records fields and ready_us can hold
+ * @param n_fields number of records written to fields
+ * @return int8_t result of bme68x_get_data. BME68X_OK only when new data was read
+ */
+int8_t measureBME680Fields(struct bme_sensor* sensor, struct bme68x_data* fields, int64_t* ready_us, uint8_t max_fields, uint8_t* n_fields)
+{
+    *n_fields = 0;
 
+    if(!sensor->ready)
+    {
+        return BME68X_E_DEV_NOT_FOUND;
+    }
+    if(!selfTestPending(sensor))
+    {
+        waitForField(nextFieldReadyUs(sensor));
+    }
+    return readSensorFields(sensor, fields, ready_us, max_fields, n_fields);
+}
+
+/**
+ * @brief Wait for a sensor and read only the newest measurement into bme_data
+ *
+ * @param sensor
+ * @param bme_data
+ * @return int8_t result of bme68x_get_data. BME68X_OK only when new data was read
+ */
+int8_t measureBME680Data(struct bme_sensor* sensor, struct bme68x_data* bme_data)
+{
+    uint8_t n_fields;
+    return measureBME680Fields(sensor, bme_data, NULL, 1, &n_fields);
+}
+
+/**
+ * @brief Ready sensor due first, esp_timer_get_time() us
+ *
+ * @param pending bit i set if sensors[i] may be picked
+ * @param due_us time the returned sensor is due
+ * @return struct bme_sensor* NULL if none is pending
+ */
+static struct bme_sensor* nextDueSensor(uint32_t pending, int64_t* due_us)
+{
+    struct bme_sensor* next = NULL;
+    *due_us = INT64_MAX;
+
+    for(uint8_t i = 0; i < bme_sensor_count; i++)
+    {
+        int64_t sensor_due_us;
+        if(sensors[i].ready && (pending & (1UL << i)) && ((sensor_due_us = sensorDueUs(&sensors[i])) < *due_us))
+        {
+            next = &sensors[i];
+            *due_us = sensor_due_us;
+        }
+    }
+    return next;
+}
 
+/**
+ * @brief Read every sensor once, each as soon as its next field is ready
+ *
+ * @details The sensors measure on their own clocks, so their waits overlap: the sensor due first is read first, then
+ * the one due next, and so on. A round takes about as long as the longest single wait rather than the sum of them, so
+ * adding sensors does not lower the rate any one of them is read at.
+ *
+ * @param cb called with the new fields of every sensor that had some, from this task
+ * @param arg passed through to cb
+ * @return uint8_t number of sensors that delivered new fields
+ */
+uint8_t measureBME680All(bme_fields_cb_t cb, void* arg)
+{
+    struct bme68x_data fields[BME_MAX_FIELDS];
+    int64_t ready_us[BME_MAX_FIELDS];
+    uint8_t n_fields;
+    uint8_t delivered = 0;
+    uint32_t pending = UINT32_MAX;
+    struct bme_sensor* next;
+    int64_t due_us;
+
+    while((next = nextDueSensor(pending, &due_us)) != NULL)
+    {
+        pending &= ~(1UL << next->index);
+        if(measureBME680Fields(next, fields, ready_us, BME_MAX_FIELDS, &n_fields) == BME68X_OK)
+        {
+            cb(next, fields, ready_us, n_fields, arg);
+            delivered++;
+        }
+    }
+    return delivered;
+}
+
+/**
+ * @brief Collect every field the sensors complete before until_us, each at the time it completes
+ *
+ * @details Completion driven: one timer is armed for the earliest predicted completion across all sensors, that
+ * sensor is read as soon as the timer fires and, in forced mode, triggered again at once, then the timer is armed for
+ * the next earliest one. The order comes from each sensor's bme68x_get_meas_dur plus its heater duration, so the heater
+ * waits of all sensors overlap and the bus is only busy with read outs. Every sensor is read at the rate it measures
+ * at, however many there are, and the task sleeps between completions. A sensor running its self-test is read when
+ * the test's current measurement completes.
+ *
+ * @param until_us esp_timer_get_time() us. Completions predicted later are left for the next call
+ * @param cb called with the new fields of a sensor, from this task, as soon as they were read
+ * @param arg passed through to cb
+ * @return uint32_t number of fields delivered
+ */
+uint32_t measureBME680Until(int64_t until_us, bme_fields_cb_t cb, void* arg)
+{
+    struct bme68x_data fields[BME_MAX_FIELDS];
+    int64_t ready_us[BME_MAX_FIELDS];
+    uint8_t n_fields;
+    uint32_t delivered = 0;
+    struct bme_sensor* next;
+    int64_t due_us;
+
+    while(((next = nextDueSensor(UINT32_MAX, &due_us)) != NULL) && (due_us <= until_us))
+    {
+        waitForField(due_us);
+        if(readSensorFields(next, fields, ready_us, BME_MAX_FIELDS, &n_fields) == BME68X_OK)
+        {
+            cb(next, fields, ready_us, n_fields, arg);
+            delivered += n_fields;
+        }
+    }
+    return delivered;
+}
@@ -1,28 +1,116 @@
 #ifndef __ESP_BME680_H__
 #define __ESP_BME680_H__
 #include <stdint.h>
+#include "esp_rom_sys.h"
 #include "bme68x.h"
 #include "esp_bme_errors.h"
 #include "esp_bme_i2c.h"
+#include "esp_bme_snapshot.h"
+#include "esp_bme_history.h"
+#include "esp_bme_sampler.h"
+#include "esp_bme_notify.h"
 
 
 // #define PRINT_SENSOR_DATA 
 
+#ifndef BME_SAMPLE_MODE
 #define BME_SAMPLE_MODE BME68X_SEQUENTIAL_MODE
-#define DELAY_FACTOR 0.1     //units of sec
+#endif
+#define BME_MAX_FIELDS 3     //sequential and parallel mode report up to 3 fields per read
+#define BME_HEATER_PROFILE_LEN 10       //steps in temp_prof / dur_prof
+#define BME_DELAY_SPIN_MAX_US 2000      //delay remainders up to this are busy waited, longer ones sleep a whole tick
+#define BME_HEATER_AMB_DRIFT_C 3        //recompile the heater registers once the measured temperature is this far from the one they were calculated for
+#define BME_SHADOW_CHECK_PERIOD 256    //register reads served from the driver's shadow copy between checks against the sensor, 0 to never check
+#define BME_MAX_SENSORS BME_I2C_MAX_DEVICES     //sensor instances, one per sensor found on the I2C buses
+#define BME_FORCED_LOST_FIELDS 2        //a forced measurement still not read this many field durations after its trigger is taken as never started
 
 
 
-extern struct bme68x_data global_sensor_data; 
+/**
+ * @brief Time spent waiting on the sensors: requested versus actual time in the driver's delay_us callback, and the
+ * acquisition task's waits for predicted field completion
+ * 
+ */
+struct bme_delay_stats
+{
+    uint32_t calls;
+    uint32_t spins;                 // calls that ended in a busy wait
+    uint64_t requested_us;          // sum of requested periods
+    uint64_t actual_us;             // sum of measured periods, never below requested_us
+    uint32_t max_overshoot_us;
+    uint32_t waits;                 // completion waits that slept until the alarm
+    uint32_t already_ready;         // completion waits skipped because the predicted time had passed
+    uint32_t timeouts;              // completion waits that ended without the alarm, the timer failed or was never armed
+    uint32_t not_ready;             // read outs after a completion wait that found no new data
+    uint64_t waited_us;             // sum of the time slept in completion waits
+};
+#define BME_WAIT_MARGIN_US BME68X_MEAS_MARGIN_US                //fixed margin added to every predicted field ready time, also used by the driver's self-test waits
+#define BME_WAIT_MARGIN_PERMILLE BME68X_MEAS_MARGIN_PERMILLE    //margin for the sensor's own oscillator tolerance, per mille of the field duration
 
+/**
+ * @brief Progress and outcome of the sensor self-test
+ * 
+ */
+struct bme_selftest_status
+{
+    uint8_t state;                  // BME68X_SELFTEST_IDLE, _RUNNING or _DONE
+    uint8_t step;                   // measurements completed, out of BME68X_SELFTEST_STEPS
+    uint8_t requested;              // a start is pending until the acquisition task picks it up
+    int8_t rslt;                    // outcome of the last completed test, BME68X_OK if the sensor passed
+    uint32_t runs;                  // tests completed since boot
+};
 
 
-void measureBME680Data(struct bme68x_data* bme_data);
-void setupBmeI2C(struct bme68x_dev* bme, uint8_t intf);
-void configureBme680Sensor(void);
-static void user_delay_us(uint32_t period, void *intf_ptr);
-static void configHeater(void);
-static void configBME(void);
+/**
+ * @brief One BME680 and everything kept about it: driver state, calibration, heater profile and published data
+ *
+ * @details Owned by the acquisition task. Only the self-test status, the snapshot and the history are read by other
+ * tasks, each through its own lock.
+ */
+struct bme_sensor
+{
+    struct bme68x_dev dev;          // holds the sensor's calibration and its register shadow
+    struct bme68x_conf conf;
+    struct bme68x_heatr_conf heatr_conf;
+    struct bme68x_heatr_image heatr_image;          // heater registers of heatr_conf, calculated for heatr_image.amb_temp
+    uint16_t temp_prof[BME_HEATER_PROFILE_LEN];     // heater temperature in degree Celsius
+    uint16_t dur_prof[BME_HEATER_PROFILE_LEN];      // heating duration in milliseconds
+    int64_t last_ready_us;          // predicted time the newest field read so far became ready, esp_timer_get_time() us
+    uint8_t last_gas_index;         // and its heater step
+    int64_t started_us;             // time the sensor was last set measuring, esp_timer_get_time() us
+    uint8_t index;                  // position in bme_i2c_devs
+    uint8_t ready;                  // initialized and taking part in acquisition
+    struct bme68x_selftest selftest;
+    int64_t selftest_due_us;
+    struct bme_selftest_status selftest_status;
+    portMUX_TYPE selftest_lock;
+    struct bme_snapshot snapshot;
+    struct bme_history history;
+};
+
+/**
+ * @brief Receives the new fields of one sensor, oldest first, with the time each one completed
+ *
+ * @details ready_us[i] is the predicted completion time of fields[i], esp_timer_get_time() us, never later than the
+ * read out
+ */
+typedef void (*bme_fields_cb_t)(struct bme_sensor* sensor, const struct bme68x_data* fields, const int64_t* ready_us, uint8_t n_fields, void* arg);
+
+
+
+int8_t measureBME680Fields(struct bme_sensor* sensor, struct bme68x_data* fields, int64_t* ready_us, uint8_t max_fields, uint8_t* n_fields);
+int8_t measureBME680Data(struct bme_sensor* sensor, struct bme68x_data* bme_data);
+uint8_t measureBME680All(bme_fields_cb_t cb, void* arg);
+uint32_t measureBME680Until(int64_t until_us, bme_fields_cb_t cb, void* arg);
+uint8_t bmeSensorCount(void);
+struct bme_sensor* bmeSensor(uint8_t index);
+uint32_t bmeFieldDurationUs(struct bme_sensor* sensor, uint8_t gas_index);
+void bmeGetDelayStats(struct bme_delay_stats* stats);
+void bmeRequestSelfTest(struct bme_sensor* sensor);
+void bmeGetSelfTestStatus(struct bme_sensor* sensor, struct bme_selftest_status* status);
+uint32_t bmeProfileCycleUs(struct bme_sensor* sensor);
+void setupBmeI2C(struct bme68x_dev* bme, uint8_t intf, void* intf_ptr);
+void configureBme680Sensor(struct bme_sensor* sensor);
 void initializeBME680(void);
 
 
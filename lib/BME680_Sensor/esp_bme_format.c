@@ -0,0 +1,151 @@
+#include "esp_bme_format.h"
+#include <string.h>
+
+static const int64_t pow10_table[] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+
+
+/**
+ * @brief Append len bytes of src at *pos, as long as the terminator still fits in cap
+ *
+ * @return uint8_t 1 if it fit, 0 otherwise
+ */
+static uint8_t append(char* buf, size_t cap, size_t* pos, const char* src, size_t len)
+{
+    if((*pos + len) >= cap)
+    {
+        return 0;
+    }
+    memcpy(&buf[*pos], src, len);
+    *pos += len;
+    return 1;
+}
+
+/**
+ * @brief Render a fixed point number as a decimal string without going through float or printf
+ *
+ * @details value is interpreted as value / 10^in_decimals and printed with out_decimals decimals.
+ * Dropped digits are rounded half away from zero on the exact decimal value, and a result that rounds
+ * to zero is never printed as "-0.00". Both decimal counts are limited to 6.
+ *
+ * @param buf destination, at least BME_FORMAT_DECIMAL_MAX_LEN bytes. NUL terminated
+ * @param value
+ * @param in_decimals decimals implied by value's representation, e.g. 2 for degree celsius x100
+ * @param out_decimals decimals to print
+ * @return size_t length of the rendered string
+ */
+size_t bme_format_decimal(char* buf, int64_t value, uint8_t in_decimals, uint8_t out_decimals)
+{
+    char digits[BME_FORMAT_DECIMAL_MAX_LEN];
+    uint8_t n_digits = 0;
+    size_t len = 0;
+    uint64_t magnitude;
+
+    if(in_decimals > 6) in_decimals = 6;
+    if(out_decimals > 6) out_decimals = 6;
+
+    magnitude = (value < 0) ? (uint64_t)0 - (uint64_t)value : (uint64_t)value;
+    if(in_decimals > out_decimals)
+    {
+        uint64_t div = (uint64_t)pow10_table[in_decimals - out_decimals];
+        magnitude = (magnitude + (div / 2)) / div;
+    }
+    else if(out_decimals > in_decimals)
+    {
+        magnitude *= (uint64_t)pow10_table[out_decimals - in_decimals];
+    }
+
+    // Least significant digit first, padding with zeros so there is always one integer digit
+    do
+    {
+        digits[n_digits++] = (char)('0' + (magnitude % 10));
+        magnitude /= 10;
+    } while((magnitude != 0) || (n_digits <= out_decimals));
+
+    if((value < 0) && (n_digits > 0))
+    {
+        // Only sign the result if a nonzero digit survived rounding
+        for(uint8_t i = 0; i < n_digits; i++)
+        {
+            if(digits[i] != '0')
+            {
+                buf[len++] = '-';
+                break;
+            }
+        }
+    }
+    while(n_digits > 0)
+    {
+        if(n_digits == out_decimals)
+        {
+            buf[len++] = '.';
+        }
+        buf[len++] = digits[--n_digits];
+    }
+    buf[len] = '\0';
+    return len;
+}
+
+/**
+ * @brief Render a sample as the JSON object served by /sensor_data and /events, without float printf
+ *
+ * @details Fields are °C, Pa, % relative humidity and Ohm, each with BME_FORMAT_DECIMALS decimals.
+ * The integer driver build is formatted straight from its fixed point fields. The FPU build is
+ * rounded to fixed point first and then goes through the same integer path.
+ *
+ * @param buf
+ * @param len size of buf
+ * @param data
+ * @return uint16_t length of the rendered string, 0 if it did not fit in buf
+ */
+uint16_t bme_format_json(char* buf, size_t len, const struct bme68x_data* data)
+{
+    struct
+    {
+        const char* key;
+        int64_t value;
+        uint8_t decimals;
+    } fields[4];
+    char number[BME_FORMAT_DECIMAL_MAX_LEN];
+    size_t pos = 0;
+    uint8_t ok;
+
+#ifdef BME68X_USE_FPU
+    fields[0].value = (int64_t)((data->temperature * 100.0f) + ((data->temperature < 0) ? -0.5f : 0.5f));
+    fields[1].value = (int64_t)(((double)data->pressure * 100.0) + 0.5);
+    fields[2].value = (int64_t)((data->humidity * 100.0f) + 0.5f);
+    fields[3].value = (int64_t)(((double)data->gas_resistance * 100.0) + 0.5);
+    fields[0].decimals = fields[1].decimals = fields[2].decimals = fields[3].decimals = 2;
+#else
+    fields[0].value = data->temperature;        // degree celsius x100
+    fields[0].decimals = 2;
+    fields[1].value = data->pressure;           // Pa
+    fields[1].decimals = 0;
+    fields[2].value = data->humidity;           // % relative humidity x1000
+    fields[2].decimals = 3;
+    fields[3].value = data->gas_resistance;     // Ohm
+    fields[3].decimals = 0;
+#endif
+    fields[0].key = "{\"temperature\": ";
+    fields[1].key = ",\"pressure\": ";
+    fields[2].key = ",\"humidity\": ";
+    fields[3].key = ",\"gas\": ";
+
+    ok = (len > 0);
+    for(uint8_t i = 0; (i < 4) && ok; i++)
+    {
+        size_t n = bme_format_decimal(number, fields[i].value, fields[i].decimals, BME_FORMAT_DECIMALS);
+        ok = append(buf, len, &pos, fields[i].key, strlen(fields[i].key)) && append(buf, len, &pos, number, n);
+    }
+    ok = ok && append(buf, len, &pos, "}", 1);
+
+    if(!ok)
+    {
+        if(len > 0)
+        {
+            buf[0] = '\0';
+        }
+        return 0;
+    }
+    buf[pos] = '\0';
+    return (uint16_t)pos;
+}
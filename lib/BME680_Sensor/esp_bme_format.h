@@ -0,0 +1,17 @@
+#ifndef __ESP_BME_FORMAT_H__
+#define __ESP_BME_FORMAT_H__
+#include <stdint.h>
+#include <stddef.h>
+#include "bme68x.h"
+
+
+#define BME_FORMAT_DECIMAL_MAX_LEN  24  // longest rendered int64 with sign and decimal point, plus terminator
+#define BME_FORMAT_DECIMALS         2   // decimals printed for every field of the sensor JSON
+
+
+size_t bme_format_decimal(char* buf, int64_t value, uint8_t in_decimals, uint8_t out_decimals);
+uint16_t bme_format_json(char* buf, size_t len, const struct bme68x_data* data);
+
+
+
+#endif /* __ESP_BME_FORMAT_H__ */
@@ -0,0 +1,397 @@
+#include "esp_bme_history.h"
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "esp_bme_errors.h"
+
+static const uint32_t tier_period_ms[BME_HISTORY_N_TIERS] = { 10 * 1000, 60 * 1000, 15 * 60 * 1000 };
+static const size_t tier_capacity[BME_HISTORY_N_TIERS] = {
+    BME_HISTORY_10S_CAPACITY,
+    BME_HISTORY_1MIN_CAPACITY,
+    BME_HISTORY_15MIN_CAPACITY
+};
+
+/* Size of one history at the full capacities */
+#define BME_HISTORY_FULL_BYTES ((BME_HISTORY_RAW_CAPACITY * sizeof(struct bme_history_sample)) + \
+    ((BME_HISTORY_10S_CAPACITY + BME_HISTORY_1MIN_CAPACITY + BME_HISTORY_15MIN_CAPACITY) * sizeof(struct bme_history_aggregate)))
+
+
+/**
+ * @brief Capacity of a ring scaled down, like every other ring of the history, to fit share bytes
+ *
+ * @details Never above full_capacity, which keeps the span of the ring within what the timestamp comparisons allow.
+ */
+static size_t ring_capacity(size_t full_capacity, size_t share)
+{
+    uint64_t capacity = ((uint64_t)full_capacity * share) / BME_HISTORY_FULL_BYTES;
+
+    if(capacity > full_capacity)
+    {
+        capacity = full_capacity;
+    }
+    return (capacity > 0) ? (size_t)capacity : 1;
+}
+
+/**
+ * @brief Allocate an empty ring from the memory caps given
+ *
+ * @param ring
+ * @param elem_size size of one record in bytes
+ * @param capacity number of records
+ * @param caps heap_caps_calloc capabilities
+ * @return esp_err_t
+ */
+static esp_err_t ring_alloc(struct bme_history_ring* ring, size_t elem_size, size_t capacity, uint32_t caps)
+{
+    ring->elem_size = elem_size;
+    ring->start = 0;
+    ring->count = 0;
+    ring->buf = heap_caps_calloc(capacity, elem_size, caps);
+    ring->capacity = (ring->buf != NULL) ? capacity : 0;
+    return (ring->buf != NULL) ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+static void ring_free(struct bme_history_ring* ring)
+{
+    heap_caps_free(ring->buf);
+    ring->buf = NULL;
+    ring->capacity = 0;
+}
+
+/**
+ * @brief Pointer to the record at logical position i, 0 being the oldest
+ *
+ */
+static inline uint8_t* ring_at(const struct bme_history_ring* ring, size_t i)
+{
+    return ring->buf + (((ring->start + i) % ring->capacity) * ring->elem_size);
+}
+
+/**
+ * @brief Timestamp of the record at logical position i. Every record type starts with its timestamp
+ *
+ */
+static inline uint32_t ring_timestamp(const struct bme_history_ring* ring, size_t i)
+{
+    uint32_t timestamp_ms;
+    memcpy(&timestamp_ms, ring_at(ring, i), sizeof(timestamp_ms));
+    return timestamp_ms;
+}
+
+/**
+ * @brief O(1) append, overwriting the oldest record once the ring is full
+ *
+ */
+static void ring_push(struct bme_history_ring* ring, const void* record)
+{
+    if(ring->capacity == 0)
+    {
+        return;
+    }
+    memcpy(ring->buf + (((ring->start + ring->count) % ring->capacity) * ring->elem_size), record, ring->elem_size);
+    if(ring->count < ring->capacity)
+    {
+        ring->count++;
+    }
+    else
+    {
+        ring->start = (ring->start + 1) % ring->capacity;
+    }
+}
+
+/**
+ * @brief O(log n) search for the first record with a timestamp at or after timestamp_ms
+ *
+ * @details Timestamps are compared as signed differences so the search keeps working across the
+ * 32 bit millisecond wrap, as long as the ring spans less than 2^31 ms.
+ *
+ * @return size_t logical position, ring->count if every record is older
+ */
+static size_t ring_lower_bound(const struct bme_history_ring* ring, uint32_t timestamp_ms)
+{
+    size_t low = 0;
+    size_t high = ring->count;
+
+    while(low < high)
+    {
+        size_t mid = low + ((high - low) / 2);
+        if((int32_t)(ring_timestamp(ring, mid) - timestamp_ms) < 0)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/**
+ * @brief Copy out every record in [from_ms, to_ms], oldest first
+ *
+ */
+static size_t ring_query(const struct bme_history_ring* ring, uint32_t from_ms, uint32_t to_ms, void* out, size_t max_out)
+{
+    size_t n = 0;
+    for(size_t i = ring_lower_bound(ring, from_ms); (i < ring->count) && (n < max_out); i++)
+    {
+        if((int32_t)(ring_timestamp(ring, i) - to_ms) > 0)
+        {
+            break;
+        }
+        memcpy((uint8_t*)out + (n * ring->elem_size), ring_at(ring, i), ring->elem_size);
+        n++;
+    }
+    return n;
+}
+
+/**
+ * @brief Convert a driver sample into the compact history representation
+ *
+ */
+static void sample_from_data(struct bme_history_sample* sample, const struct bme68x_data* data, uint32_t timestamp_ms)
+{
+    sample->timestamp_ms = timestamp_ms;
+#ifdef BME68X_USE_FPU
+    sample->temperature = (int16_t)(data->temperature * 100.0f);
+    sample->humidity = (uint16_t)(data->humidity * 100.0f);
+    sample->pressure = (uint32_t)data->pressure;
+    sample->gas_resistance = (uint32_t)data->gas_resistance;
+#else
+    sample->temperature = data->temperature;
+    sample->humidity = (uint16_t)(data->humidity / 10);
+    sample->pressure = data->pressure;
+    sample->gas_resistance = data->gas_resistance;
+#endif
+}
+
+/**
+ * @brief Close the period being accumulated and push its aggregate to the tier ring
+ *
+ */
+static void accum_flush(struct bme_history_accum* accum, struct bme_history_ring* ring)
+{
+    if(accum->agg.count == 0)
+    {
+        return;
+    }
+    int32_t n = accum->agg.count;
+    accum->agg.temperature_mean = (int16_t)(accum->temperature_sum / n);
+    accum->agg.humidity_mean = (uint16_t)(accum->humidity_sum / n);
+    accum->agg.pressure_mean = (uint32_t)(accum->pressure_sum / n);
+    accum->agg.gas_mean = (uint32_t)(accum->gas_sum / n);
+    ring_push(ring, &accum->agg);
+
+    accum->agg.count = 0;
+    accum->temperature_sum = 0;
+    accum->humidity_sum = 0;
+    accum->pressure_sum = 0;
+    accum->gas_sum = 0;
+}
+
+/**
+ * @brief Fold one raw sample into a tier, closing the previous period if the sample starts a new one
+ *
+ */
+static void accum_add(struct bme_history_accum* accum, struct bme_history_ring* ring, const struct bme_history_sample* sample)
+{
+    uint32_t bucket = sample->timestamp_ms / accum->period_ms;
+    struct bme_history_aggregate* agg = &accum->agg;
+
+    if((bucket != accum->bucket) || (agg->count == UINT16_MAX))
+    {
+        accum_flush(accum, ring);
+        accum->bucket = bucket;
+    }
+
+    if(agg->count == 0)
+    {
+        agg->timestamp_ms = bucket * accum->period_ms;
+        agg->temperature_min = agg->temperature_max = sample->temperature;
+        agg->humidity_min = agg->humidity_max = sample->humidity;
+        agg->pressure_min = agg->pressure_max = sample->pressure;
+        agg->gas_min = agg->gas_max = sample->gas_resistance;
+    }
+    else
+    {
+        if(sample->temperature < agg->temperature_min) agg->temperature_min = sample->temperature;
+        if(sample->temperature > agg->temperature_max) agg->temperature_max = sample->temperature;
+        if(sample->humidity < agg->humidity_min) agg->humidity_min = sample->humidity;
+        if(sample->humidity > agg->humidity_max) agg->humidity_max = sample->humidity;
+        if(sample->pressure < agg->pressure_min) agg->pressure_min = sample->pressure;
+        if(sample->pressure > agg->pressure_max) agg->pressure_max = sample->pressure;
+        if(sample->gas_resistance < agg->gas_min) agg->gas_min = sample->gas_resistance;
+        if(sample->gas_resistance > agg->gas_max) agg->gas_max = sample->gas_resistance;
+    }
+
+    agg->count++;
+    accum->temperature_sum += sample->temperature;
+    accum->humidity_sum += sample->humidity;
+    accum->pressure_sum += sample->pressure;
+    accum->gas_sum += sample->gas_resistance;
+}
+
+
+/**
+ * @brief Allocate every ring of a history in share bytes or less, from one kind of memory. All or nothing
+ *
+ */
+static esp_err_t history_alloc(struct bme_history* hist, size_t share, uint32_t caps)
+{
+    esp_err_t err = ring_alloc(&hist->raw, sizeof(struct bme_history_sample), ring_capacity(BME_HISTORY_RAW_CAPACITY, share), caps);
+
+    for(uint8_t t = 0; (t < BME_HISTORY_N_TIERS) && (err == ESP_OK); t++)
+    {
+        err = ring_alloc(&hist->tiers[t], sizeof(struct bme_history_aggregate), ring_capacity(tier_capacity[t], share), caps);
+    }
+    if(err != ESP_OK)
+    {
+        ring_free(&hist->raw);
+        for(uint8_t t = 0; t < BME_HISTORY_N_TIERS; t++)
+        {
+            ring_free(&hist->tiers[t]);
+        }
+    }
+    return err;
+}
+
+/**
+ * @brief Allocate the raw and tier rings for the sample history of one of n_sensors sensors, and log how far back they
+ * reach
+ *
+ * @details Each sensor gets an equal share of BME_HISTORY_PSRAM_BUDGET, all of its rings scaled down alike if the share
+ * is below the full capacities. Without PSRAM, or once it is full, the history gets its share of
+ * BME_HISTORY_INTERNAL_BUDGET in internal RAM instead, with a warning.
+ *
+ * @param hist
+ * @param n_sensors number of sensors sharing the budget, each with its own history
+ * @return esp_err_t ESP_OK, or ESP_ERR_NO_MEM if the history could not be allocated at all. It then holds nothing,
+ * appends are dropped and queries return no records
+ */
+esp_err_t bme_history_init(struct bme_history* hist, uint8_t n_sensors)
+{
+    esp_err_t err = ESP_ERR_NO_MEM;
+    size_t bytes;
+    uint8_t in_psram = 0;
+
+    memset(hist, 0, sizeof(struct bme_history));
+    hist->lock = xSemaphoreCreateMutex();
+    if(hist->lock == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    for(uint8_t t = 0; t < BME_HISTORY_N_TIERS; t++)
+    {
+        hist->accum[t].period_ms = tier_period_ms[t];
+    }
+    n_sensors = (n_sensors > 0) ? n_sensors : 1;
+
+    if(heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0)
+    {
+        err = history_alloc(hist, BME_HISTORY_PSRAM_BUDGET / n_sensors, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        in_psram = (err == ESP_OK);
+    }
+    if(err != ESP_OK)
+    {
+        ESP_LOGW(tag, "No PSRAM left for the sensor history, keeping a %u kB one in internal RAM",
+            (unsigned)(BME_HISTORY_INTERNAL_BUDGET / n_sensors / 1024));
+        err = history_alloc(hist, BME_HISTORY_INTERNAL_BUDGET / n_sensors, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    if(err != ESP_OK)
+    {
+        vSemaphoreDelete(hist->lock);
+        hist->lock = NULL;
+        return err;
+    }
+
+    bytes = hist->raw.capacity * hist->raw.elem_size;
+    for(uint8_t t = 0; t < BME_HISTORY_N_TIERS; t++)
+    {
+        bytes += hist->tiers[t].capacity * hist->tiers[t].elem_size;
+    }
+    ESP_LOGI(tag, "Sensor history: %u raw samples, 10 s tier %lu h, 1 min tier %lu h, 15 min tier %lu h, %u kB of %s",
+        (unsigned)hist->raw.capacity,
+        (unsigned long)(((uint64_t)hist->tiers[BME_HISTORY_TIER_10S].capacity * tier_period_ms[BME_HISTORY_TIER_10S]) / 3600000),
+        (unsigned long)(((uint64_t)hist->tiers[BME_HISTORY_TIER_1MIN].capacity * tier_period_ms[BME_HISTORY_TIER_1MIN]) / 3600000),
+        (unsigned long)(((uint64_t)hist->tiers[BME_HISTORY_TIER_15MIN].capacity * tier_period_ms[BME_HISTORY_TIER_15MIN]) / 3600000),
+        (unsigned)(bytes / 1024), in_psram ? "PSRAM" : "internal RAM");
+    return ESP_OK;
+}
+
+/**
+ * @brief Store a sample and roll it up into every tier. O(1)
+ *
+ * @param hist
+ * @param data sample to store
+ * @param timestamp_ms time the sample was taken, ms since boot. Must not go backwards
+ */
+void bme_history_append(struct bme_history* hist, const struct bme68x_data* data, uint32_t timestamp_ms)
+{
+    struct bme_history_sample sample;
+    sample_from_data(&sample, data, timestamp_ms);
+
+    if(hist->lock == NULL)
+    {
+        return;     // bme_history_init failed, there is nowhere to keep it
+    }
+    if(xSemaphoreTake(hist->lock, pdMS_TO_TICKS(BME_HISTORY_LOCK_TIMEOUT_MS)) != pdTRUE)
+    {
+        ESP_LOGW(tag, "Sensor history busy, dropping sample");
+        return;
+    }
+
+    ring_push(&hist->raw, &sample);
+    for(uint8_t t = 0; t < BME_HISTORY_N_TIERS; t++)
+    {
+        accum_add(&hist->accum[t], &hist->tiers[t], &sample);
+    }
+
+    xSemaphoreGive(hist->lock);
+}
+
+/**
+ * @brief Copy out the raw samples taken in [from_ms, to_ms], oldest first. O(log n) to locate the range
+ *
+ * @param hist
+ * @param from_ms
+ * @param to_ms
+ * @param out
+ * @param max_out capacity of out
+ * @return size_t number of samples copied
+ */
+size_t bme_history_query_raw(struct bme_history* hist, uint32_t from_ms, uint32_t to_ms, struct bme_history_sample* out, size_t max_out)
+{
+    size_t n = 0;
+    if((hist->lock != NULL) && (xSemaphoreTake(hist->lock, pdMS_TO_TICKS(BME_HISTORY_LOCK_TIMEOUT_MS)) == pdTRUE))
+    {
+        n = ring_query(&hist->raw, from_ms, to_ms, out, max_out);
+        xSemaphoreGive(hist->lock);
+    }
+    return n;
+}
+
+/**
+ * @brief Copy out the completed tier periods starting in [from_ms, to_ms], oldest first. O(log n) to locate the range
+ *
+ * @param hist
+ * @param tier
+ * @param from_ms
+ * @param to_ms
+ * @param out
+ * @param max_out capacity of out
+ * @return size_t number of aggregates copied
+ */
+size_t bme_history_query_tier(struct bme_history* hist, enum bme_history_tier tier, uint32_t from_ms, uint32_t to_ms, struct bme_history_aggregate* out, size_t max_out)
+{
+    size_t n = 0;
+    if((tier >= BME_HISTORY_N_TIERS) || (hist->lock == NULL))
+    {
+        return 0;
+    }
+    if(xSemaphoreTake(hist->lock, pdMS_TO_TICKS(BME_HISTORY_LOCK_TIMEOUT_MS)) == pdTRUE)
+    {
+        n = ring_query(&hist->tiers[tier], from_ms, to_ms, out, max_out);
+        xSemaphoreGive(hist->lock);
+    }
+    return n;
+}
@@ -0,0 +1,102 @@
+#ifndef __ESP_BME_HISTORY_H__
+#define __ESP_BME_HISTORY_H__
+#include <stdint.h>
+#include <stddef.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_err.h"
+#include "bme68x.h"
+
+
+/* Full ring capacities of one sensor, ~1.4 MB. Timestamps are compared as signed 32 bit ms differences, so every ring
+ * must span < ~24 days. When the budget share of a sensor is smaller, all of its rings are scaled down alike */
+#define BME_HISTORY_RAW_CAPACITY        32768   // ~1.5 h of sequential mode fields, 16 B each
+#define BME_HISTORY_10S_CAPACITY        8640    // 1 day
+#define BME_HISTORY_1MIN_CAPACITY       10080   // 7 days
+#define BME_HISTORY_15MIN_CAPACITY      2016    // 21 days
+#define BME_HISTORY_PSRAM_BUDGET        (2560 * 1024)   // PSRAM shared by the histories of all sensors, of the WROVER's 4 MB
+#define BME_HISTORY_INTERNAL_BUDGET     (48 * 1024)     // internal RAM shared by them instead, when PSRAM is missing or full
+
+#define BME_HISTORY_LOCK_TIMEOUT_MS     100
+
+
+enum bme_history_tier
+{
+    BME_HISTORY_TIER_10S = 0,
+    BME_HISTORY_TIER_1MIN,
+    BME_HISTORY_TIER_15MIN,
+    BME_HISTORY_N_TIERS
+};
+
+/**
+ * @brief Compact timestamped raw sample
+ *
+ */
+struct bme_history_sample
+{
+    uint32_t timestamp_ms;      // ms since boot, must stay the first member
+    uint32_t pressure;          // Pa
+    uint32_t gas_resistance;    // Ohm
+    int16_t temperature;        // degree celsius x100
+    uint16_t humidity;          // % relative humidity x100
+};
+
+/**
+ * @brief Min/max/mean roll up of the raw samples that fell into one tier period
+ *
+ */
+struct bme_history_aggregate
+{
+    uint32_t timestamp_ms;      // start of the period, must stay the first member
+    uint16_t count;
+    int16_t temperature_min, temperature_max, temperature_mean;
+    uint16_t humidity_min, humidity_max, humidity_mean;
+    uint32_t pressure_min, pressure_max, pressure_mean;
+    uint32_t gas_min, gas_max, gas_mean;
+};
+
+/**
+ * @brief Fixed capacity ring of timestamp ordered records
+ *
+ */
+struct bme_history_ring
+{
+    uint8_t* buf;
+    size_t elem_size;
+    size_t capacity;
+    size_t start;   //index of the oldest record
+    size_t count;
+};
+
+/**
+ * @brief Running sums for the tier period currently being filled
+ *
+ */
+struct bme_history_accum
+{
+    uint32_t period_ms;
+    uint32_t bucket;    //timestamp_ms / period_ms of the samples being accumulated
+    struct bme_history_aggregate agg;
+    int64_t temperature_sum;
+    int64_t humidity_sum;
+    int64_t pressure_sum;
+    int64_t gas_sum;
+};
+
+struct bme_history
+{
+    struct bme_history_ring raw;
+    struct bme_history_ring tiers[BME_HISTORY_N_TIERS];
+    struct bme_history_accum accum[BME_HISTORY_N_TIERS];
+    SemaphoreHandle_t lock;
+};
+
+
+esp_err_t bme_history_init(struct bme_history* hist, uint8_t n_sensors);
+void bme_history_append(struct bme_history* hist, const struct bme68x_data* data, uint32_t timestamp_ms);
+size_t bme_history_query_raw(struct bme_history* hist, uint32_t from_ms, uint32_t to_ms, struct bme_history_sample* out, size_t max_out);
+size_t bme_history_query_tier(struct bme_history* hist, enum bme_history_tier tier, uint32_t from_ms, uint32_t to_ms, struct bme_history_aggregate* out, size_t max_out);
+
+
+
+#endif /* __ESP_BME_HISTORY_H__ */
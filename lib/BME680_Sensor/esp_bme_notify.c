@@ -0,0 +1,74 @@
+#include "esp_bme_notify.h"
+#include <string.h>
+#include "esp_bme_errors.h"
+
+
+/**
+ * @brief esp_timer callback, runs in the esp_timer task when the measurement should be complete
+ *
+ */
+static void notify_timer_cb(void* arg)
+{
+    struct bme_notify* notify = (struct bme_notify*)arg;
+    xTaskNotifyGiveIndexed(notify->task, BME_NOTIFY_INDEX);
+}
+
+
+/**
+ * @brief Create the completion timer
+ *
+ * @param notify
+ * @return esp_err_t
+ */
+esp_err_t bme_notify_init(struct bme_notify* notify)
+{
+    const esp_timer_create_args_t timer_args = {
+        .callback = notify_timer_cb,
+        .arg = notify,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "bme_notify",
+        .skip_unhandled_events = false
+    };
+
+    memset(notify, 0, sizeof(struct bme_notify));
+    return esp_timer_create(&timer_args, &notify->timer);
+}
+
+/**
+ * @brief Block the calling task until ready_us, woken by the completion timer
+ *
+ * @details Returns at once if ready_us has passed. An alarm that does not fire is given up BME_NOTIFY_SLACK_TICKS after
+ * it should have, rather than hanging the task. Without an alarm, because bme_notify_init failed or the timer could not
+ * be armed, the task sleeps whole ticks until ready_us instead, up to a tick late, so the caller never polls the sensor.
+ *
+ * @param notify
+ * @param ready_us predicted completion time, esp_timer_get_time() microseconds
+ * @return uint8_t BME_NOTIFY_SKIPPED, BME_NOTIFY_WOKEN, or BME_NOTIFY_TIMEOUT if there was no alarm to wake the task
+ */
+uint8_t bme_notify_wait_until(struct bme_notify* notify, int64_t ready_us)
+{
+    int64_t wait_us = ready_us - esp_timer_get_time();
+    uint32_t woken = 0;
+
+    if(wait_us <= 0)
+    {
+        return BME_NOTIFY_SKIPPED;
+    }
+
+    notify->task = xTaskGetCurrentTaskHandle();
+    ulTaskNotifyTakeIndexed(BME_NOTIFY_INDEX, pdTRUE, 0);      // drop an alarm left over from an abandoned wait
+    if((notify->timer != NULL) && (esp_timer_start_once(notify->timer, (uint64_t)wait_us) == ESP_OK))
+    {
+        woken = ulTaskNotifyTakeIndexed(BME_NOTIFY_INDEX, pdTRUE, pdMS_TO_TICKS(wait_us / 1000) + BME_NOTIFY_SLACK_TICKS);
+        if(woken == 0)
+        {
+            esp_timer_stop(notify->timer);
+            ESP_LOGW(tag, "Measurement completion alarm did not fire");
+        }
+    }
+    else
+    {
+        vTaskDelay((TickType_t)((wait_us + (portTICK_PERIOD_MS * 1000) - 1) / (portTICK_PERIOD_MS * 1000)));
+    }
+    return (woken > 0) ? BME_NOTIFY_WOKEN : BME_NOTIFY_TIMEOUT;
+}
@@ -0,0 +1,42 @@
+#ifndef __ESP_BME_NOTIFY_H__
+#define __ESP_BME_NOTIFY_H__
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_err.h"
+#include "esp_timer.h"
+
+
+#define BME_NOTIFY_INDEX        1       // task notification slot, index 0 belongs to the sampler
+#define BME_NOTIFY_SLACK_TICKS  2       // a wait gives up this many ticks after the alarm should have fired
+
+#define BME_NOTIFY_SKIPPED      0       // bme_notify_wait_until found the time already passed
+#define BME_NOTIFY_WOKEN        1       // slept until the alarm
+#define BME_NOTIFY_TIMEOUT      2       // no alarm woke the task, it slept out the wait on ticks or gave up
+
+#if configTASK_NOTIFICATION_ARRAY_ENTRIES <= BME_NOTIFY_INDEX
+#error "Set CONFIG_FREERTOS_TASK_NOTIFICATION_ARRAY_ENTRIES to at least 2 in sdkconfig"
+#endif
+
+
+/**
+ * @brief Wakes a task once at the predicted completion time of a measurement
+ *
+ * @details A one shot esp_timer gives the waiting task a notification on slot BME_NOTIFY_INDEX, so the task sleeps
+ * in a single blocking call for the whole wait and wakes once, with neither tick rounding nor a busy wait at the end.
+ * Only one task may wait on a notifier at a time. What the waits cost is accounted by the caller, in
+ * struct bme_delay_stats together with the driver's delays.
+ */
+struct bme_notify
+{
+    esp_timer_handle_t timer;
+    TaskHandle_t task;      // task blocked in bme_notify_wait_until
+};
+
+
+esp_err_t bme_notify_init(struct bme_notify* notify);
+uint8_t bme_notify_wait_until(struct bme_notify* notify, int64_t ready_us);
+
+
+
+#endif /* __ESP_BME_NOTIFY_H__ */
@@ -0,0 +1,154 @@
+#include "esp_bme_sampler.h"
+#include <string.h>
+#include "esp_bme_errors.h"
+
+
+/**
+ * @brief esp_timer callback, runs in the esp_timer task at every deadline
+ *
+ */
+static void sampler_timer_cb(void* arg)
+{
+    struct bme_sampler* sampler = (struct bme_sampler*)arg;
+    xTaskNotifyGive(sampler->task);
+}
+
+
+/**
+ * @brief Create the deadline timer and start releasing task every period_ms
+ *
+ * @param sampler
+ * @param task task that calls bme_sampler_wait
+ * @param period_ms
+ * @return esp_err_t
+ */
+esp_err_t bme_sampler_start(struct bme_sampler* sampler, TaskHandle_t task, uint32_t period_ms)
+{
+    esp_err_t err;
+    const esp_timer_create_args_t timer_args = {
+        .callback = sampler_timer_cb,
+        .arg = sampler,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "bme_sampler",
+        .skip_unhandled_events = false
+    };
+
+    if(period_ms < BME_SAMPLE_PERIOD_MIN_MS)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(sampler, 0, sizeof(struct bme_sampler));
+    portMUX_INITIALIZE(&sampler->lock);
+    sampler->task = task;
+    sampler->period_us = period_ms * 1000;
+
+    err = esp_timer_create(&timer_args, &sampler->timer);
+    if(err == ESP_OK)
+    {
+        sampler->base_us = esp_timer_get_time();
+        err = esp_timer_start_periodic(sampler->timer, sampler->period_us);
+    }
+    return err;
+}
+
+/**
+ * @brief Change the acquisition period. The deadline grid restarts one new period from now
+ *
+ * @details Must be called from the sampled task itself, since it discards that task's pending deadlines.
+ *
+ * @param sampler
+ * @param period_ms
+ * @return esp_err_t
+ */
+esp_err_t bme_sampler_set_period(struct bme_sampler* sampler, uint32_t period_ms)
+{
+    esp_err_t err;
+
+    if(period_ms < BME_SAMPLE_PERIOD_MIN_MS)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_timer_stop(sampler->timer);
+    ulTaskNotifyTake(pdTRUE, 0);    // drop deadlines of the old grid that have not been waited on yet
+
+    portENTER_CRITICAL(&sampler->lock);
+    sampler->period_us = period_ms * 1000;
+    sampler->base_us = esp_timer_get_time();
+    sampler->deadline_idx = 0;
+    portEXIT_CRITICAL(&sampler->lock);
+
+    err = esp_timer_start_periodic(sampler->timer, sampler->period_us);
+    if(err == ESP_OK)
+    {
+        ESP_LOGI(tag, "Sample period set to %lu ms", (unsigned long)period_ms);
+    }
+    return err;
+}
+
+/**
+ * @brief Block until the next deadline and account for how late the task was released
+ *
+ * @details If more than one deadline passed since the previous call, the task was still busy when they fired.
+ * Those are counted as missed and the task resumes on the latest one, so it never runs back to back to catch up.
+ * Must be called from the task given to bme_sampler_start, and from that task only, so that is also the only
+ * task that ever calls bme_sampler_set_period.
+ *
+ * @param sampler
+ * @return int64_t the deadline that released the task, esp_timer_get_time() microseconds. Successive values are
+ * exact multiples of the period apart, so use it rather than the wake up time to timestamp the acquisition
+ */
+int64_t bme_sampler_wait(struct bme_sampler* sampler)
+{
+    uint32_t released = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    int64_t now_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&sampler->lock);
+    sampler->deadline_idx += released;
+    int64_t deadline_us = sampler->base_us + ((int64_t)sampler->deadline_idx * sampler->period_us);
+    int32_t jitter_us = (int32_t)(now_us - deadline_us);
+
+    sampler->stats.samples++;
+    sampler->stats.missed_deadlines += (released > 1) ? (released - 1) : 0;
+    sampler->stats.last_jitter_us = jitter_us;
+    if(jitter_us > sampler->stats.max_jitter_us)
+    {
+        sampler->stats.max_jitter_us = jitter_us;
+    }
+    sampler->stats.jitter_sum_us += jitter_us;
+    portEXIT_CRITICAL(&sampler->lock);
+
+    if(released > 1)
+    {
+        ESP_LOGW(tag, "Sampler missed %lu deadline(s)", (unsigned long)(released - 1));
+    }
+    return deadline_us;
+}
+
+/**
+ * @brief Deadline after the one bme_sampler_wait returned last, esp_timer_get_time() us
+ *
+ * @param sampler
+ * @return int64_t
+ */
+int64_t bme_sampler_next_deadline(struct bme_sampler* sampler)
+{
+    portENTER_CRITICAL(&sampler->lock);
+    int64_t deadline_us = sampler->base_us + ((int64_t)(sampler->deadline_idx + 1) * sampler->period_us);
+    portEXIT_CRITICAL(&sampler->lock);
+    return deadline_us;
+}
+
+/**
+ * @brief Copy out the timing statistics. Safe to call from any task
+ *
+ * @param sampler
+ * @param stats
+ */
+void bme_sampler_get_stats(struct bme_sampler* sampler, struct bme_sampler_stats* stats)
+{
+    portENTER_CRITICAL(&sampler->lock);
+    memcpy(stats, &sampler->stats, sizeof(struct bme_sampler_stats));
+    portEXIT_CRITICAL(&sampler->lock);
+}
@@ -0,0 +1,54 @@
+#ifndef __ESP_BME_SAMPLER_H__
+#define __ESP_BME_SAMPLER_H__
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_err.h"
+#include "esp_timer.h"
+
+
+#define BME_SAMPLE_PERIOD_MS    250     // default acquisition period
+#define BME_SAMPLE_PERIOD_MIN_MS 10
+
+
+/**
+ * @brief Timing statistics of the acquisitions released so far
+ *
+ */
+struct bme_sampler_stats
+{
+    uint32_t samples;           // acquisitions released to the task
+    uint32_t missed_deadlines;  // deadlines that passed while the task was still busy with an earlier one
+    int32_t last_jitter_us;     // wake up time minus deadline of the latest acquisition
+    int32_t max_jitter_us;
+    int64_t jitter_sum_us;      // divide by samples for the mean
+};
+
+/**
+ * @brief Releases a task at absolute, evenly spaced deadlines
+ *
+ * @details A periodic esp_timer notifies the task at base_us + k * period_us. esp_timer schedules every alarm
+ * from the previous alarm rather than from when its callback ran, so the deadlines never drift however long
+ * the task takes per acquisition.
+ */
+struct bme_sampler
+{
+    esp_timer_handle_t timer;
+    TaskHandle_t task;
+    uint32_t period_us;
+    int64_t base_us;        // time the timer was (re)started
+    uint32_t deadline_idx;  // deadline of the latest acquisition, in periods after base_us
+    struct bme_sampler_stats stats;
+    portMUX_TYPE lock;      // keeps stats and period consistent for readers on other tasks
+};
+
+
+esp_err_t bme_sampler_start(struct bme_sampler* sampler, TaskHandle_t task, uint32_t period_ms);
+esp_err_t bme_sampler_set_period(struct bme_sampler* sampler, uint32_t period_ms);
+int64_t bme_sampler_wait(struct bme_sampler* sampler);
+int64_t bme_sampler_next_deadline(struct bme_sampler* sampler);
+void bme_sampler_get_stats(struct bme_sampler* sampler, struct bme_sampler_stats* stats);
+
+
+
+#endif /* __ESP_BME_SAMPLER_H__ */
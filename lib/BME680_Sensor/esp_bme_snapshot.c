@@ -0,0 +1,134 @@
+#include "esp_bme_snapshot.h"
+#include "esp_bme_format.h"
+#include "freertos/task.h"
+#include <string.h>
+
+
+/**
+ * @brief Reset a snapshot to the "nothing published yet" state
+ *
+ * @param snap
+ */
+void bme_snapshot_init(struct bme_snapshot* snap)
+{
+    atomic_store_explicit(&snap->seq, 0, memory_order_relaxed);
+    memset(&snap->data, 0, sizeof(snap->data));
+    snap->json_len = 0;
+    snap->json[0] = '\0';
+    portMUX_INITIALIZE(&snap->lock);
+}
+
+/**
+ * @brief Publish a new sample. Must only be called from a single writer task.
+ *
+ * @details The copy is done inside a critical section so the writer can not be preempted while seq is odd,
+ * which would otherwise leave a higher priority reader on the same core spinning until it falls back to sleeping.
+ * The JSON body is rendered before entering it, so the critical section stays a pair of memcpys.
+ *
+ * @param snap
+ * @param data sample to publish
+ * @return uint32_t number of the published sample, the same value bme_snapshot_read reports for it
+ */
+uint32_t bme_snapshot_publish(struct bme_snapshot* snap, const struct bme68x_data* data)
+{
+    char json[BME_SNAPSHOT_JSON_LEN];
+    uint16_t json_len = bme_format_json(json, sizeof(json), data);
+
+    portENTER_CRITICAL(&snap->lock);
+    unsigned seq = atomic_load_explicit(&snap->seq, memory_order_relaxed);
+
+    atomic_store_explicit(&snap->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    memcpy(&snap->data, data, sizeof(struct bme68x_data));
+    memcpy(snap->json, json, json_len + 1);
+    snap->json_len = json_len;
+
+    atomic_store_explicit(&snap->seq, seq + 2, memory_order_release);
+    portEXIT_CRITICAL(&snap->lock);
+
+    return (uint32_t)((seq + 2) / 2);
+}
+
+/**
+ * @brief Back off before the next attempt at a consistent copy
+ *
+ * @details The first BME_SNAPSHOT_READ_SPINS attempts follow each other at once, the writer's window is a pair of
+ * memcpys. Past that the writer is not running, so the reader sleeps a tick to let it finish, whatever its priority.
+ */
+static void read_backoff(uint32_t attempt)
+{
+    if(attempt >= BME_SNAPSHOT_READ_SPINS)
+    {
+        vTaskDelay(1);
+    }
+}
+
+/**
+ * @brief Copy out the latest published sample, without taking a lock
+ *
+ * @details Retries until the copy is consistent, see read_backoff. Only ever waits while a publish is in progress.
+ *
+ * @param snap
+ * @param out destination for the sample
+ * @return uint32_t number of the sample that was copied (1 for the first publish), or 0 if nothing has been published
+ * yet
+ */
+uint32_t bme_snapshot_read(struct bme_snapshot* snap, struct bme68x_data* out)
+{
+    for(uint32_t attempt = 0; ; read_backoff(++attempt))
+    {
+        unsigned begin = atomic_load_explicit(&snap->seq, memory_order_acquire);
+        if(begin & 1U)
+        {
+            continue;   //writer is mid copy
+        }
+
+        memcpy(out, &snap->data, sizeof(struct bme68x_data));
+        atomic_thread_fence(memory_order_acquire);
+
+        if(atomic_load_explicit(&snap->seq, memory_order_relaxed) == begin)
+        {
+            return (uint32_t)(begin / 2);
+        }
+    }
+}
+
+/**
+ * @brief Copy out the pre-rendered JSON body of the latest published sample, without taking a lock
+ *
+ * @details Retries until the copy is consistent, like bme_snapshot_read. Before the first publish the body is empty.
+ *
+ * @param snap
+ * @param out destination for the NUL terminated body
+ * @param max_len size of out, BME_SNAPSHOT_JSON_LEN always fits
+ * @param out_len length of the body, excluding the terminator
+ * @return uint32_t number of the sample the body belongs to, usable as its version, or 0 if nothing has been
+ * published yet
+ */
+uint32_t bme_snapshot_read_json(struct bme_snapshot* snap, char* out, size_t max_len, size_t* out_len)
+{
+    for(uint32_t attempt = 0; ; read_backoff(++attempt))
+    {
+        unsigned begin = atomic_load_explicit(&snap->seq, memory_order_acquire);
+        if(begin & 1U)
+        {
+            continue;   //writer is mid copy
+        }
+
+        size_t len = snap->json_len;
+        if(len >= max_len)
+        {
+            len = max_len - 1;
+        }
+        memcpy(out, snap->json, len);
+        atomic_thread_fence(memory_order_acquire);
+
+        if(atomic_load_explicit(&snap->seq, memory_order_relaxed) == begin)
+        {
+            out[len] = '\0';
+            *out_len = len;
+            return (uint32_t)(begin / 2);
+        }
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef __ESP_BME_SNAPSHOT_H__
+#define __ESP_BME_SNAPSHOT_H__
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "freertos/FreeRTOS.h"
+#include "bme68x.h"
+
+
+#define BME_SNAPSHOT_READ_SPINS   16   // back to back attempts at a consistent copy before a reader sleeps a tick between them
+#define BME_SNAPSHOT_JSON_LEN     128  // rendered JSON body of one sample, including the terminator
+
+
+/**
+ * @brief Latest published sensor sample, shared between the acquisition task and readers
+ *
+ * @details Sequence lock: the writer makes seq odd, copies the sample in, then makes it even again.
+ * Readers copy the sample without taking any lock and retry if seq was odd or changed underneath them, until they
+ * get a consistent copy. Readers must be tasks, they may sleep while the writer is held off its core.
+ * The JSON body served to web clients is rendered once per publish and versioned by the same seq.
+ */
+struct bme_snapshot
+{
+    atomic_uint seq;
+    struct bme68x_data data;
+    uint16_t json_len;
+    char json[BME_SNAPSHOT_JSON_LEN];
+    portMUX_TYPE lock;  //only taken by the writer to keep the publish window from being preempted
+};
+
+
+void bme_snapshot_init(struct bme_snapshot* snap);
+uint32_t bme_snapshot_publish(struct bme_snapshot* snap, const struct bme68x_data* data);
+uint32_t bme_snapshot_read(struct bme_snapshot* snap, struct bme68x_data* out);
+uint32_t bme_snapshot_read_json(struct bme_snapshot* snap, char* out, size_t max_len, size_t* out_len);
+
+
+
+#endif /* __ESP_BME_SNAPSHOT_H__ */
@@ -50,51 +50,80 @@ static uint8_t calc_gas_wait(uint16_t dur);
 
 #ifndef BME68X_USE_FPU
 
-/* This internal API is used to calculate the temperature in integer */
-static int16_t calc_temperature(uint32_t temp_adc, struct bme68x_dev *dev);
+/* This internal API is used to calculate the calibration-only terms of the integer compensation */
+static void calc_derived_calib(struct bme68x_calib_data *calib);
+
+/* This internal API is used to calculate t_fine, the temperature term the other compensations depend on, in integer */
+static int32_t calc_t_fine(uint32_t temp_adc, const struct bme68x_calib_data *calib);
+
+/* This internal API is used to calculate the temperature from t_fine in integer */
+static int16_t calc_temperature(int32_t t_fine);
 
 /* This internal API is used to calculate the pressure in integer */
-static uint32_t calc_pressure(uint32_t pres_adc, const struct bme68x_dev *dev);
+static uint32_t calc_pressure(uint32_t pres_adc, int32_t t_fine, const struct bme68x_calib_data *calib);
 
 /* This internal API is used to calculate the humidity in integer */
-static uint32_t calc_humidity(uint16_t hum_adc, const struct bme68x_dev *dev);
+static uint32_t calc_humidity(uint16_t hum_adc, int32_t t_fine, const struct bme68x_calib_data *calib);
 
 /* This internal API is used to calculate the gas resistance high */
 static uint32_t calc_gas_resistance_high(uint16_t gas_res_adc, uint8_t gas_range);
 
 /* This internal API is used to calculate the gas resistance low */
-static uint32_t calc_gas_resistance_low(uint16_t gas_res_adc, uint8_t gas_range, const struct bme68x_dev *dev);
+static uint32_t calc_gas_resistance_low(uint16_t gas_res_adc, uint8_t gas_range, const struct bme68x_calib_data *calib);
 
 /* This internal API is used to calculate the heater resistance using integer */
 static uint8_t calc_res_heat(uint16_t temp, const struct bme68x_dev *dev);
 
 #else
 
-/* This internal API is used to calculate the temperature value in float */
-static float calc_temperature(uint32_t temp_adc, struct bme68x_dev *dev);
+/* This internal API is used to calculate the calibration-only terms of the float compensation */
+static void calc_derived_calib(struct bme68x_calib_data *calib);
+
+/* This internal API is used to calculate t_fine, the temperature term the other compensations depend on, in float */
+static float calc_t_fine(uint32_t temp_adc, const struct bme68x_calib_data *calib);
+
+/* This internal API is used to calculate the temperature value from t_fine in float */
+static float calc_temperature(float t_fine);
 
 /* This internal API is used to calculate the pressure value in float */
-static float calc_pressure(uint32_t pres_adc, const struct bme68x_dev *dev);
+static float calc_pressure(uint32_t pres_adc, float t_fine, const struct bme68x_calib_data *calib);
 
 /* This internal API is used to calculate the humidity value in float */
-static float calc_humidity(uint16_t hum_adc, const struct bme68x_dev *dev);
+static float calc_humidity(uint16_t hum_adc, float t_fine, const struct bme68x_calib_data *calib);
 
 /* This internal API is used to calculate the gas resistance high value in float */
 static float calc_gas_resistance_high(uint16_t gas_res_adc, uint8_t gas_range);
 
 /* This internal API is used to calculate the gas resistance low value in float */
-static float calc_gas_resistance_low(uint16_t gas_res_adc, uint8_t gas_range, const struct bme68x_dev *dev);
+static float calc_gas_resistance_low(uint16_t gas_res_adc, uint8_t gas_range, const struct bme68x_calib_data *calib);
 
 /* This internal API is used to calculate the heater resistance value using float */
 static uint8_t calc_res_heat(uint16_t temp, const struct bme68x_dev *dev);
 
 #endif
 
-/* This internal API is used to read a single data of the sensor */
-static int8_t read_field_data(uint8_t index, struct bme68x_data *data, struct bme68x_dev *dev);
+/* This internal API is used to read a single data of the sensor, polling
+ * it up to tries times until it holds new data */
+static int8_t read_field_data(uint8_t index, struct bme68x_data *data, uint8_t tries, struct bme68x_dev *dev);
 
 /* This internal API is used to read all data fields of the sensor */
-static int8_t read_all_field_data(struct bme68x_data * const data[], struct bme68x_dev *dev);
+static int8_t read_all_field_data(struct bme68x_data *data, uint8_t *n_new, struct bme68x_dev *dev);
+
+/* This internal API is used to decode the status and raw ADC values of a field */
+static void parse_field(const uint8_t *buff,
+                        uint8_t variant_id,
+                        struct bme68x_data *data,
+                        uint32_t *adc_temp,
+                        uint32_t *adc_pres,
+                        uint16_t *adc_hum,
+                        uint16_t *adc_gas,
+                        uint8_t *gas_range);
+
+/* This internal API is used to compensate arrays of raw ADC values */
+static void compensate_batch(const struct bme68x_raw_batch *raw,
+                             const struct bme68x_comp_batch *comp,
+                             uint32_t n,
+                             const struct bme68x_dev *dev);
 
 /* This internal API is used to switch between SPI memory pages */
 static int8_t set_mem_page(uint8_t reg_addr, struct bme68x_dev *dev);
@@ -105,8 +134,17 @@ static int8_t get_mem_page(struct bme68x_dev *dev);
 /* This internal API is used to check the bme68x_dev for null pointers */
 static int8_t null_ptr_check(const struct bme68x_dev *dev);
 
-/* This internal API is used to set heater configurations */
-static int8_t set_conf(const struct bme68x_heatr_conf *conf, uint8_t op_mode, uint8_t *nb_conv, struct bme68x_dev *dev);
+/* This internal API is used to serve a register read from the shadow registers */
+static uint8_t read_shadow(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, struct bme68x_dev *dev);
+
+/* This internal API is used to update a register in the shadow registers */
+static void update_shadow(uint8_t reg_addr, uint8_t reg_data, struct bme68x_dev *dev);
+
+/* This internal API is used to write interleaved register address and data pairs */
+static int8_t write_interleaved(uint8_t *buff, uint32_t len, struct bme68x_dev *dev);
+
+/* This internal API is used to write a compiled heater configuration */
+static int8_t write_heatr_image(const struct bme68x_heatr_image *image, struct bme68x_dev *dev);
 
 /* This internal API is used to limit the max value of a parameter */
 static int8_t boundary_check(uint8_t *value, uint8_t max, struct bme68x_dev *dev);
@@ -115,11 +153,8 @@ static int8_t boundary_check(uint8_t *value, uint8_t max, struct bme68x_dev *dev
  * shared heater duration */
 static uint8_t calc_heatr_dur_shared(uint16_t dur);
 
-/* This internal API is used to swap two fields */
-static void swap_fields(uint8_t index1, uint8_t index2, struct bme68x_data *field[]);
-
-/* This internal API is used sort the sensor data */
-static void sort_sensor_data(uint8_t low_index, uint8_t high_index, struct bme68x_data *field[]);
+/* This internal API is used to order the new fields chronologically */
+static uint8_t order_fields(const uint8_t *buff, uint8_t n_fields, uint8_t *order);
 
 /*
  * @brief       Function to analyze the sensor data
@@ -133,6 +168,12 @@ static void sort_sensor_data(uint8_t low_index, uint8_t high_index, struct bme68
  */
 static int8_t analyze_sensor_data(const struct bme68x_data *data, uint8_t n_meas);
 
+/* This internal API is used to configure and trigger the next self-test measurement */
+static int8_t selftest_trigger(struct bme68x_selftest *st, struct bme68x_dev *dev);
+
+/* This internal API is used to end a self-test with its result */
+static void selftest_finish(struct bme68x_selftest *st, int8_t rslt);
+
 /******************************************************************************************/
 /*                                 Global API definitions                                 */
 /******************************************************************************************/
@@ -190,28 +231,59 @@ int8_t bme68x_set_regs(const uint8_t *reg_addr, const uint8_t *reg_data, uint32_
             /* Interleave the 2 arrays */
             for (index = 0; index < len; index++)
             {
-                if (dev->intf == BME68X_SPI_INTF)
-                {
-                    /* Set the memory page */
-                    rslt = set_mem_page(reg_addr[index], dev);
-                    tmp_buff[(2 * index)] = reg_addr[index] & BME68X_SPI_WR_MSK;
-                }
-                else
-                {
-                    tmp_buff[(2 * index)] = reg_addr[index];
-                }
-
+                tmp_buff[(2 * index)] = reg_addr[index];
                 tmp_buff[(2 * index) + 1] = reg_data[index];
             }
 
             /* Write the interleaved array */
-            if (rslt == BME68X_OK)
+            rslt = write_interleaved(tmp_buff, len, dev);
+        }
+        else
+        {
+            rslt = BME68X_E_INVALID_LENGTH;
+        }
+    }
+    else
+    {
+        rslt = BME68X_E_NULL_PTR;
+    }
+
+    return rslt;
+}
+
+/*
+ * @brief This API writes the given data to consecutive registers of the sensor
+ */
+int8_t bme68x_set_regs_range(uint8_t reg_addr, const uint8_t *reg_data, uint32_t len, struct bme68x_dev *dev)
+{
+    int8_t rslt;
+    uint8_t tmp_buff[BME68X_LEN_BURST_BUFF];
+    uint32_t index = 0;
+    uint32_t chunk;
+    uint32_t i;
+
+    /* Check for null pointer in the device structure*/
+    rslt = null_ptr_check(dev);
+    if ((rslt == BME68X_OK) && reg_data)
+    {
+        if ((len > 0) && (((uint32_t)reg_addr + len) <= 0x100))
+        {
+            while ((rslt == BME68X_OK) && (index < len))
             {
-                dev->intf_rslt = dev->write(tmp_buff[0], &tmp_buff[1], (2 * len) - 1, dev->intf_ptr);
-                if (dev->intf_rslt != 0)
+                chunk = len - index;
+                if (chunk > (BME68X_LEN_BURST_BUFF / 2))
                 {
-                    rslt = BME68X_E_COM_FAIL;
+                    chunk = BME68X_LEN_BURST_BUFF / 2;
+                }
+
+                for (i = 0; i < chunk; i++)
+                {
+                    tmp_buff[(2 * i)] = (uint8_t)(reg_addr + index + i);
+                    tmp_buff[(2 * i) + 1] = reg_data[index + i];
                 }
+
+                rslt = write_interleaved(tmp_buff, chunk, dev);
+                index += chunk;
             }
         }
         else
@@ -235,24 +307,40 @@ int8_t bme68x_get_regs(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, struct
     int8_t rslt;
 
     /* Check for null pointer in the device structure*/
+    uint32_t index;
+    uint8_t addr = reg_addr;
+
     rslt = null_ptr_check(dev);
     if ((rslt == BME68X_OK) && reg_data)
     {
+        if (read_shadow(reg_addr, reg_data, len, dev))
+        {
+            return rslt;
+        }
+
         if (dev->intf == BME68X_SPI_INTF)
         {
             /* Set the memory page */
             rslt = set_mem_page(reg_addr, dev);
             if (rslt == BME68X_OK)
             {
-                reg_addr = reg_addr | BME68X_SPI_RD_MSK;
+                addr = reg_addr | BME68X_SPI_RD_MSK;
             }
         }
 
-        dev->intf_rslt = dev->read(reg_addr, reg_data, len, dev->intf_ptr);
+        dev->intf_rslt = dev->read(addr, reg_data, len, dev->intf_ptr);
         if (dev->intf_rslt != 0)
         {
             rslt = BME68X_E_COM_FAIL;
         }
+        else
+        {
+            /* What the sensor returned is the newest state of shadowed registers */
+            for (index = 0; index < len; index++)
+            {
+                update_shadow((uint8_t)(reg_addr + index), reg_data[index], dev);
+            }
+        }
     }
     else
     {
@@ -262,6 +350,72 @@ int8_t bme68x_get_regs(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, struct
     return rslt;
 }
 
+/*
+ * @brief This API loads the shadow registers and starts serving reads from them.
+ */
+int8_t bme68x_enable_shadow(uint16_t check_period, struct bme68x_dev *dev)
+{
+    int8_t rslt;
+
+    /* Check for null pointer in the device structure*/
+    rslt = null_ptr_check(dev);
+    if (rslt == BME68X_OK)
+    {
+        dev->shadow_valid = 0;
+        dev->shadow_check_period = check_period;
+        rslt = bme68x_check_shadow(dev);
+    }
+
+    return rslt;
+}
+
+/*
+ * @brief This API compares the shadow registers with the sensor and reloads them.
+ */
+int8_t bme68x_check_shadow(struct bme68x_dev *dev)
+{
+    int8_t rslt;
+    uint8_t reg_data[BME68X_LEN_SHADOW];
+    uint8_t meas = BME68X_REG_CTRL_MEAS - BME68X_REG_IDAC_HEAT0;
+    uint8_t loaded;
+    uint8_t mismatch = 0;
+    uint8_t i;
+
+    /* Check for null pointer in the device structure*/
+    rslt = null_ptr_check(dev);
+    if (rslt == BME68X_OK)
+    {
+        loaded = dev->shadow_valid;
+        dev->shadow_valid = 0;
+        rslt = bme68x_get_regs(BME68X_REG_IDAC_HEAT0, reg_data, BME68X_LEN_SHADOW, dev);
+        if (rslt == BME68X_OK)
+        {
+            for (i = 0; i < BME68X_LEN_SHADOW; i++)
+            {
+                /* A finished forced measurement is not a mismatch */
+                if (loaded && (reg_data[i] != dev->shadow[i]) &&
+                    !((i == meas) && ((dev->shadow[i] & BME68X_MODE_MSK) == BME68X_FORCED_MODE) &&
+                      (reg_data[i] == (dev->shadow[i] & ~BME68X_MODE_MSK))))
+                {
+                    mismatch = 1;
+                }
+
+                dev->shadow[i] = reg_data[i];
+            }
+
+            dev->shadow_valid = 1;
+            dev->shadow_reads = 0;
+            if (mismatch)
+            {
+                dev->shadow_mismatches++;
+                rslt = BME68X_W_SHADOW_MISMATCH;
+            }
+        }
+    }
+
+    return rslt;
+}
+
 /*
  * @brief This API soft-resets the sensor.
  */
@@ -297,6 +451,13 @@ int8_t bme68x_soft_reset(struct bme68x_dev *dev)
                 {
                     rslt = get_mem_page(dev);
                 }
+
+                /* The reset restored the register defaults */
+                if ((rslt == BME68X_OK) && dev->shadow_valid)
+                {
+                    dev->shadow_valid = 0;
+                    rslt = bme68x_check_shadow(dev);
+                }
             }
         }
     }
@@ -314,7 +475,6 @@ int8_t bme68x_set_conf(struct bme68x_conf *conf, struct bme68x_dev *dev)
     uint8_t current_op_mode;
 
     /* Register data starting from BME68X_REG_CTRL_GAS_1(0x71) up to BME68X_REG_CONFIG(0x75) */
-    uint8_t reg_array[BME68X_LEN_CONFIG] = { 0x71, 0x72, 0x73, 0x74, 0x75 };
     uint8_t data_array[BME68X_LEN_CONFIG] = { 0 };
 
     rslt = bme68x_get_op_mode(&current_op_mode, dev);
@@ -331,7 +491,7 @@ int8_t bme68x_set_conf(struct bme68x_conf *conf, struct bme68x_dev *dev)
     else if (rslt == BME68X_OK)
     {
         /* Read the whole configuration and write it back once later */
-        rslt = bme68x_get_regs(reg_array[0], data_array, BME68X_LEN_CONFIG, dev);
+        rslt = bme68x_get_regs(BME68X_REG_CTRL_GAS_1, data_array, BME68X_LEN_CONFIG, dev);
         dev->info_msg = BME68X_OK;
         if (rslt == BME68X_OK)
         {
@@ -377,7 +537,7 @@ int8_t bme68x_set_conf(struct bme68x_conf *conf, struct bme68x_dev *dev)
 
     if (rslt == BME68X_OK)
     {
-        rslt = bme68x_set_regs(reg_array, data_array, BME68X_LEN_CONFIG, dev);
+        rslt = bme68x_set_regs_range(BME68X_REG_CTRL_GAS_1, data_array, BME68X_LEN_CONFIG, dev);
     }
 
     if ((current_op_mode != BME68X_SLEEP_MODE) && (rslt == BME68X_OK))
@@ -539,13 +699,7 @@ uint32_t bme68x_get_meas_dur(const uint8_t op_mode, struct bme68x_conf *conf, st
 int8_t bme68x_get_data(uint8_t op_mode, struct bme68x_data *data, uint8_t *n_data, struct bme68x_dev *dev)
 {
     int8_t rslt;
-    uint8_t i = 0, j = 0, new_fields = 0;
-    struct bme68x_data *field_ptr[3] = { 0 };
-    struct bme68x_data field_data[3] = { { 0 } };
-
-    field_ptr[0] = &field_data[0];
-    field_ptr[1] = &field_data[1];
-    field_ptr[2] = &field_data[2];
+    uint8_t new_fields = 0;
 
     rslt = null_ptr_check(dev);
     if ((rslt == BME68X_OK) && (data != NULL))
@@ -553,7 +707,7 @@ int8_t bme68x_get_data(uint8_t op_mode, struct bme68x_data *data, uint8_t *n_dat
         /* Reading the sensor data in forced mode only */
         if (op_mode == BME68X_FORCED_MODE)
         {
-            rslt = read_field_data(0, data, dev);
+            rslt = read_field_data(0, data, BME68X_FIELD_READ_TRIES, dev);
             if (rslt == BME68X_OK)
             {
                 if (data->status & BME68X_NEW_DATA_MSK)
@@ -569,56 +723,223 @@ int8_t bme68x_get_data(uint8_t op_mode, struct bme68x_data *data, uint8_t *n_dat
         }
         else if ((op_mode == BME68X_PARALLEL_MODE) || (op_mode == BME68X_SEQUENTIAL_MODE))
         {
-            /* Read the 3 fields and count the number of new data fields */
-            rslt = read_all_field_data(field_ptr, dev);
-
-            new_fields = 0;
-            for (i = 0; (i < 3) && (rslt == BME68X_OK); i++)
+            /* Read the 3 fields and decode the new ones into data, oldest first */
+            rslt = read_all_field_data(data, &new_fields, dev);
+            if ((rslt == BME68X_OK) && (new_fields == 0))
             {
-                if (field_ptr[i]->status & BME68X_NEW_DATA_MSK)
-                {
-                    new_fields++;
-                }
+                rslt = BME68X_W_NO_NEW_DATA;
             }
+        }
+        else
+        {
+            rslt = BME68X_W_DEFINE_OP_MODE;
+        }
+
+        if (n_data == NULL)
+        {
+            rslt = BME68X_E_NULL_PTR;
+        }
+        else
+        {
+            *n_data = new_fields;
+        }
+    }
+    else
+    {
+        rslt = BME68X_E_NULL_PTR;
+    }
+
+    return rslt;
+}
+
+/*
+ * @brief This API reads the field registers of new measurements without
+ * compensating them.
+ */
+int8_t bme68x_get_raw_fields(uint8_t op_mode, struct bme68x_raw_data *raw, uint8_t *n_data, struct bme68x_dev *dev)
+{
+    int8_t rslt;
+    uint8_t i, j, n_fields, new_fields = 0;
+    uint8_t buff[BME68X_LEN_FIELD * BME68X_N_FIELDS] = { 0 };
+    uint8_t order[BME68X_N_FIELDS];
+
+    rslt = null_ptr_check(dev);
+    if ((rslt == BME68X_OK) && (raw != NULL) && (n_data != NULL))
+    {
+        if (op_mode == BME68X_FORCED_MODE)
+        {
+            n_fields = 1;
+        }
+        else if ((op_mode == BME68X_PARALLEL_MODE) || (op_mode == BME68X_SEQUENTIAL_MODE))
+        {
+            n_fields = BME68X_N_FIELDS;
+        }
+        else
+        {
+            n_fields = 0;
+            rslt = BME68X_W_DEFINE_OP_MODE;
+        }
+
+        if (rslt == BME68X_OK)
+        {
+            rslt = bme68x_get_regs(BME68X_REG_FIELD0, buff, (uint32_t) BME68X_LEN_FIELD * n_fields, dev);
+        }
 
-            /* Sort the sensor data in parallel & sequential modes*/
-            for (i = 0; (i < 2) && (rslt == BME68X_OK); i++)
+        if (rslt == BME68X_OK)
+        {
+            /* Keep the new fields, oldest first, the way bme68x_get_data does */
+            new_fields = order_fields(buff, n_fields, order);
+            for (i = 0; i < new_fields; i++)
             {
-                for (j = i + 1; j < 3; j++)
+                for (j = 0; j < BME68X_LEN_FIELD; j++)
                 {
-                    sort_sensor_data(i, j, field_ptr);
+                    raw[i].field[j] = buff[(order[i] * BME68X_LEN_FIELD) + j];
                 }
             }
 
-            /* Copy the sorted data */
-            for (i = 0; ((i < 3) && (rslt == BME68X_OK)); i++)
-            {
-                data[i] = *field_ptr[i];
-            }
-
             if (new_fields == 0)
             {
                 rslt = BME68X_W_NO_NEW_DATA;
             }
         }
-        else
-        {
-            rslt = BME68X_W_DEFINE_OP_MODE;
-        }
 
-        if (n_data == NULL)
+        *n_data = new_fields;
+    }
+    else
+    {
+        rslt = BME68X_E_NULL_PTR;
+    }
+
+    return rslt;
+}
+
+/*
+ * @brief This API decodes and compensates field register images read with
+ * bme68x_get_raw_fields, without accessing the sensor.
+ */
+int8_t bme68x_decode_raw_fields(const struct bme68x_raw_data *raw,
+                                struct bme68x_data *data,
+                                uint32_t n,
+                                const struct bme68x_dev *dev)
+{
+    uint32_t adc_temp[BME68X_BATCH_CHUNK];
+    uint32_t adc_pres[BME68X_BATCH_CHUNK];
+    uint16_t adc_hum[BME68X_BATCH_CHUNK];
+    uint16_t adc_gas[BME68X_BATCH_CHUNK];
+    uint8_t gas_range[BME68X_BATCH_CHUNK];
+    struct bme68x_raw_batch batch = { adc_temp, adc_pres, adc_hum, adc_gas, gas_range };
+    struct bme68x_comp_batch comp;
+    uint32_t base, len, i;
+#ifndef BME68X_USE_FPU
+    int16_t temperature[BME68X_BATCH_CHUNK];
+    uint32_t pressure[BME68X_BATCH_CHUNK];
+    uint32_t humidity[BME68X_BATCH_CHUNK];
+    uint32_t gas_resistance[BME68X_BATCH_CHUNK];
+#else
+    float temperature[BME68X_BATCH_CHUNK];
+    float pressure[BME68X_BATCH_CHUNK];
+    float humidity[BME68X_BATCH_CHUNK];
+    float gas_resistance[BME68X_BATCH_CHUNK];
+#endif
+
+    if ((raw == NULL) || (data == NULL) || (dev == NULL))
+    {
+        return BME68X_E_NULL_PTR;
+    }
+
+    comp.temperature = temperature;
+    comp.pressure = pressure;
+    comp.humidity = humidity;
+    comp.gas_resistance = gas_resistance;
+
+    for (base = 0; base < n; base += len)
+    {
+        len = ((n - base) < BME68X_BATCH_CHUNK) ? (n - base) : BME68X_BATCH_CHUNK;
+        for (i = 0; i < len; i++)
         {
-            rslt = BME68X_E_NULL_PTR;
+            parse_field(raw[base + i].field,
+                        dev->variant_id,
+                        &data[base + i],
+                        &adc_temp[i],
+                        &adc_pres[i],
+                        &adc_hum[i],
+                        &adc_gas[i],
+                        &gas_range[i]);
+
+            /* Heater settings are only known from the shadow registers */
+            if (dev->shadow_valid && (data[base + i].gas_index < 10))
+            {
+                data[base + i].idac = dev->shadow[data[base + i].gas_index];
+                data[base + i].res_heat = dev->shadow[10 + data[base + i].gas_index];
+                data[base + i].gas_wait = dev->shadow[20 + data[base + i].gas_index];
+            }
+            else
+            {
+                data[base + i].idac = 0;
+                data[base + i].res_heat = 0;
+                data[base + i].gas_wait = 0;
+            }
         }
-        else
+
+        compensate_batch(&batch, &comp, len, dev);
+        for (i = 0; i < len; i++)
         {
-            *n_data = new_fields;
+            data[base + i].temperature = temperature[i];
+            data[base + i].pressure = pressure[i];
+            data[base + i].humidity = humidity[i];
+            data[base + i].gas_resistance = gas_resistance[i];
         }
     }
+
+    return BME68X_OK;
+}
+
+/*
+ * @brief This API compensates arrays of raw ADC values with the calibration
+ * of the device, without accessing the sensor.
+ */
+int8_t bme68x_compensate_batch(const struct bme68x_raw_batch *raw,
+                               const struct bme68x_comp_batch *comp,
+                               uint32_t n,
+                               const struct bme68x_dev *dev)
+{
+    int8_t rslt = BME68X_OK;
+
+    if ((dev == NULL) || (raw == NULL) || (comp == NULL))
+    {
+        rslt = BME68X_E_NULL_PTR;
+    }
+    else if ((n > 0) &&
+             ((raw->temp_adc == NULL) || (raw->pres_adc == NULL) || (raw->hum_adc == NULL) || (raw->gas_adc == NULL) ||
+              (raw->gas_range == NULL) || (comp->temperature == NULL) || (comp->pressure == NULL) ||
+              (comp->humidity == NULL) || (comp->gas_resistance == NULL)))
+    {
+        rslt = BME68X_E_NULL_PTR;
+    }
     else
+    {
+        compensate_batch(raw, comp, n, dev);
+    }
+
+    return rslt;
+}
+
+/*
+ * @brief This API recalculates the calibration-derived constants after the
+ * coefficients in dev->calib were changed by the user.
+ */
+int8_t bme68x_derive_calib(struct bme68x_dev *dev)
+{
+    int8_t rslt = BME68X_OK;
+
+    if (dev == NULL)
     {
         rslt = BME68X_E_NULL_PTR;
     }
+    else
+    {
+        calc_derived_calib(&dev->calib);
+    }
 
     return rslt;
 }
@@ -629,53 +950,145 @@ int8_t bme68x_get_data(uint8_t op_mode, struct bme68x_data *data, uint8_t *n_dat
 int8_t bme68x_set_heatr_conf(uint8_t op_mode, const struct bme68x_heatr_conf *conf, struct bme68x_dev *dev)
 {
     int8_t rslt;
-    uint8_t nb_conv = 0;
-    uint8_t hctrl, run_gas = 0;
-    uint8_t ctrl_gas_data[2];
-    uint8_t ctrl_gas_addr[2] = { BME68X_REG_CTRL_GAS_0, BME68X_REG_CTRL_GAS_1 };
+    struct bme68x_heatr_image image;
 
     if (conf != NULL)
     {
         rslt = bme68x_set_op_mode(BME68X_SLEEP_MODE, dev);
         if (rslt == BME68X_OK)
         {
-            rslt = set_conf(conf, op_mode, &nb_conv, dev);
+            rslt = bme68x_compile_heatr_conf(op_mode, conf, &image, dev);
         }
 
         if (rslt == BME68X_OK)
         {
-            rslt = bme68x_get_regs(BME68X_REG_CTRL_GAS_0, ctrl_gas_data, 2, dev);
-            if (rslt == BME68X_OK)
+            rslt = write_heatr_image(&image, dev);
+        }
+    }
+    else
+    {
+        rslt = BME68X_E_NULL_PTR;
+    }
+
+    return rslt;
+}
+
+/*!
+ * @brief This API calculates the heater register values of a gas configuration.
+ */
+int8_t bme68x_compile_heatr_conf(uint8_t op_mode,
+                                 const struct bme68x_heatr_conf *conf,
+                                 struct bme68x_heatr_image *image,
+                                 const struct bme68x_dev *dev)
+{
+    int8_t rslt = BME68X_OK;
+    uint8_t i;
+
+    if ((conf == NULL) || (image == NULL) || (dev == NULL))
+    {
+        return BME68X_E_NULL_PTR;
+    }
+
+    image->op_mode = op_mode;
+    image->amb_temp = dev->amb_temp;
+    image->shared_heatr_dur = 0;
+    switch (op_mode)
+    {
+        case BME68X_FORCED_MODE:
+            image->res_heat[0] = calc_res_heat(conf->heatr_temp, dev);
+            image->gas_wait[0] = calc_gas_wait(conf->heatr_dur);
+            image->nb_conv = 0;
+            image->len = 1;
+            break;
+        case BME68X_SEQUENTIAL_MODE:
+        case BME68X_PARALLEL_MODE:
+            if ((!conf->heatr_dur_prof) || (!conf->heatr_temp_prof))
+            {
+                rslt = BME68X_E_NULL_PTR;
+                break;
+            }
+
+            if ((conf->profile_len == 0) || (conf->profile_len > BME68X_LEN_HEATR_PROF))
+            {
+                rslt = BME68X_E_INVALID_LENGTH;
+                break;
+            }
+
+            for (i = 0; i < conf->profile_len; i++)
             {
-                if (conf->enable == BME68X_ENABLE)
+                image->res_heat[i] = calc_res_heat(conf->heatr_temp_prof[i], dev);
+                if (op_mode == BME68X_SEQUENTIAL_MODE)
                 {
-                    hctrl = BME68X_ENABLE_HEATER;
-                    if (dev->variant_id == BME68X_VARIANT_GAS_HIGH)
-                    {
-                        run_gas = BME68X_ENABLE_GAS_MEAS_H;
-                    }
-                    else
-                    {
-                        run_gas = BME68X_ENABLE_GAS_MEAS_L;
-                    }
+                    image->gas_wait[i] = calc_gas_wait(conf->heatr_dur_prof[i]);
                 }
                 else
                 {
-                    hctrl = BME68X_DISABLE_HEATER;
-                    run_gas = BME68X_DISABLE_GAS_MEAS;
+                    /* In parallel mode gas_wait_x is a multiplier of the shared heater duration */
+                    image->gas_wait[i] = (uint8_t) conf->heatr_dur_prof[i];
+                }
+            }
+
+            image->nb_conv = conf->profile_len;
+            image->len = conf->profile_len;
+            if (op_mode == BME68X_PARALLEL_MODE)
+            {
+                if (conf->shared_heatr_dur == 0)
+                {
+                    rslt = BME68X_W_DEFINE_SHD_HEATR_DUR;
                 }
 
-                ctrl_gas_data[0] = BME68X_SET_BITS(ctrl_gas_data[0], BME68X_HCTRL, hctrl);
-                ctrl_gas_data[1] = BME68X_SET_BITS_POS_0(ctrl_gas_data[1], BME68X_NBCONV, nb_conv);
-                ctrl_gas_data[1] = BME68X_SET_BITS(ctrl_gas_data[1], BME68X_RUN_GAS, run_gas);
-                rslt = bme68x_set_regs(ctrl_gas_addr, ctrl_gas_data, 2, dev);
+                image->shared_heatr_dur = calc_heatr_dur_shared(conf->shared_heatr_dur);
             }
+
+            break;
+        default:
+            rslt = BME68X_W_DEFINE_OP_MODE;
+    }
+
+    if (conf->enable == BME68X_ENABLE)
+    {
+        image->hctrl = BME68X_ENABLE_HEATER;
+        if (dev->variant_id == BME68X_VARIANT_GAS_HIGH)
+        {
+            image->run_gas = BME68X_ENABLE_GAS_MEAS_H;
+        }
+        else
+        {
+            image->run_gas = BME68X_ENABLE_GAS_MEAS_L;
         }
     }
     else
+    {
+        image->hctrl = BME68X_DISABLE_HEATER;
+        image->run_gas = BME68X_DISABLE_GAS_MEAS;
+    }
+
+    return rslt;
+}
+
+/*!
+ * @brief This API writes a compiled heater configuration to the sensor.
+ */
+int8_t bme68x_set_heatr_image(const struct bme68x_heatr_image *image, struct bme68x_dev *dev)
+{
+    int8_t rslt;
+
+    if (image == NULL)
     {
         rslt = BME68X_E_NULL_PTR;
     }
+    else if ((image->len == 0) || (image->len > BME68X_LEN_HEATR_PROF))
+    {
+        rslt = BME68X_E_INVALID_LENGTH;
+    }
+    else
+    {
+        rslt = bme68x_set_op_mode(BME68X_SLEEP_MODE, dev);
+        if (rslt == BME68X_OK)
+        {
+            rslt = write_heatr_image(image, dev);
+        }
+    }
 
     return rslt;
 }
@@ -727,11 +1140,8 @@ int8_t bme68x_selftest_check(const struct bme68x_dev *dev)
 {
     int8_t rslt;
     uint8_t n_fields;
-    uint8_t i = 0;
-    struct bme68x_data data[BME68X_N_MEAS] = { { 0 } };
-    struct bme68x_dev t_dev;
-    struct bme68x_conf conf;
-    struct bme68x_heatr_conf heatr_conf;
+    struct bme68x_dev t_dev = { 0 };
+    struct bme68x_selftest st;
 
     rslt = null_ptr_check(dev);
 
@@ -750,108 +1160,214 @@ int8_t bme68x_selftest_check(const struct bme68x_dev *dev)
 
     if (rslt == BME68X_OK)
     {
-        /* Set the temperature, pressure and humidity & filter settings */
-        conf.os_hum = BME68X_OS_1X;
-        conf.os_pres = BME68X_OS_16X;
-        conf.os_temp = BME68X_OS_2X;
+        /* Run the incremental self-test, waiting out each measurement */
+        (void)bme68x_selftest_start(&st, &t_dev);
+        while (st.state == BME68X_SELFTEST_RUNNING)
+        {
+            t_dev.delay_us(st.wait_us, t_dev.intf_ptr);
+            (void)bme68x_selftest_step(&st, NULL, &n_fields, &t_dev);
+        }
 
-        /* Set the remaining gas sensor settings and link the heating profile */
-        heatr_conf.enable = BME68X_ENABLE;
-        heatr_conf.heatr_dur = BME68X_HEATR_DUR1;
-        heatr_conf.heatr_temp = BME68X_HIGH_TEMP;
-        rslt = bme68x_set_heatr_conf(BME68X_FORCED_MODE, &heatr_conf, &t_dev);
-        if (rslt == BME68X_OK)
+        rslt = st.rslt;
+    }
+
+    return rslt;
+}
+
+/*
+ * @brief This API starts a self-test that runs one measurement per call to
+ * bme68x_selftest_step.
+ */
+int8_t bme68x_selftest_start(struct bme68x_selftest *st, struct bme68x_dev *dev)
+{
+    int8_t rslt;
+
+    rslt = null_ptr_check(dev);
+    if ((rslt == BME68X_OK) && (st != NULL))
+    {
+        st->state = BME68X_SELFTEST_RUNNING;
+        st->step = 0;
+        st->tries = 0;
+        st->rslt = BME68X_OK;
+        st->wait_us = 0;
+        rslt = selftest_trigger(st, dev);
+        if (rslt != BME68X_OK)
         {
-            rslt = bme68x_set_conf(&conf, &t_dev);
-            if (rslt == BME68X_OK)
-            {
-                rslt = bme68x_set_op_mode(BME68X_FORCED_MODE, &t_dev); /* Trigger a measurement */
-                if (rslt == BME68X_OK)
-                {
-                    /* Wait for the measurement to complete */
-                    t_dev.delay_us(BME68X_HEATR_DUR1_DELAY, t_dev.intf_ptr);
-                    rslt = bme68x_get_data(BME68X_FORCED_MODE, &data[0], &n_fields, &t_dev);
-                    if (rslt == BME68X_OK)
-                    {
-                        if ((data[0].idac != 0x00) && (data[0].idac != 0xFF) &&
-                            (data[0].status & BME68X_GASM_VALID_MSK))
-                        {
-                            rslt = BME68X_OK;
-                        }
-                        else
-                        {
-                            rslt = BME68X_E_SELF_TEST;
-                        }
-                    }
-                }
-            }
+            selftest_finish(st, rslt);
         }
+    }
+    else
+    {
+        rslt = BME68X_E_NULL_PTR;
+    }
 
-        heatr_conf.heatr_dur = BME68X_HEATR_DUR2;
-        while ((rslt == BME68X_OK) && (i < BME68X_N_MEAS))
+    return rslt;
+}
+
+/*
+ * @brief This API advances a self-test by one measurement.
+ */
+int8_t bme68x_selftest_step(struct bme68x_selftest *st,
+                            struct bme68x_data *data,
+                            uint8_t *n_data,
+                            struct bme68x_dev *dev)
+{
+    int8_t rslt;
+    struct bme68x_data field;
+
+    rslt = null_ptr_check(dev);
+    if ((rslt == BME68X_OK) && (st != NULL) && (n_data != NULL))
+    {
+        *n_data = 0;
+        if (st->state == BME68X_SELFTEST_RUNNING)
         {
-            if (i % 2 == 0)
+            /* Read once, the caller waits between the tries */
+            rslt = read_field_data(0, &field, 1, dev);
+            if ((rslt == BME68X_OK) && !(field.status & BME68X_NEW_DATA_MSK))
             {
-                heatr_conf.heatr_temp = BME68X_HIGH_TEMP; /* Higher temperature */
+                rslt = BME68X_W_NO_NEW_DATA;
             }
-            else
+
+            if ((rslt == BME68X_W_NO_NEW_DATA) && (++st->tries < BME68X_SELFTEST_READ_TRIES))
             {
-                heatr_conf.heatr_temp = BME68X_LOW_TEMP; /* Lower temperature */
+                /* Still measuring, try again one poll period later */
+                st->wait_us = BME68X_PERIOD_POLL;
             }
-
-            rslt = bme68x_set_heatr_conf(BME68X_FORCED_MODE, &heatr_conf, &t_dev);
-            if (rslt == BME68X_OK)
+            else if (rslt != BME68X_OK)
+            {
+                selftest_finish(st, rslt);
+            }
+            else
             {
-                rslt = bme68x_set_conf(&conf, &t_dev);
-                if (rslt == BME68X_OK)
+                if (data != NULL)
                 {
-                    rslt = bme68x_set_op_mode(BME68X_FORCED_MODE, &t_dev); /* Trigger a measurement */
-                    if (rslt == BME68X_OK)
+                    *data = field;
+                }
+
+                *n_data = 1;
+                if (st->step == 0)
+                {
+                    /* The heater check: the heater current must be set and the gas measurement valid */
+                    if ((field.idac == 0x00) || (field.idac == 0xFF) || !(field.status & BME68X_GASM_VALID_MSK))
                     {
-                        /* Wait for the measurement to complete */
-                        t_dev.delay_us(BME68X_HEATR_DUR2_DELAY, t_dev.intf_ptr);
-                        rslt = bme68x_get_data(BME68X_FORCED_MODE, &data[i], &n_fields, &t_dev);
+                        selftest_finish(st, BME68X_E_SELF_TEST);
                     }
                 }
-            }
+                else
+                {
+                    st->data[st->step - 1] = field;
+                }
 
-            i++;
+                if (st->state == BME68X_SELFTEST_RUNNING)
+                {
+                    st->step++;
+                    st->tries = 0;
+                    if (st->step < BME68X_SELFTEST_STEPS)
+                    {
+                        rslt = selftest_trigger(st, dev);
+                        if (rslt != BME68X_OK)
+                        {
+                            selftest_finish(st, rslt);
+                        }
+                    }
+                    else
+                    {
+                        selftest_finish(st, analyze_sensor_data(st->data, BME68X_N_MEAS));
+                    }
+                }
+            }
         }
-
-        if (rslt == BME68X_OK)
+        else
         {
-            rslt = analyze_sensor_data(data, BME68X_N_MEAS);
+            rslt = st->rslt;
         }
     }
+    else
+    {
+        rslt = BME68X_E_NULL_PTR;
+    }
+
+    return rslt;
+}
+
+/*****************************INTERNAL APIs***********************************************/
+#ifndef BME68X_USE_FPU
+
+/* Gas range factors of the low gas variant, combined with range_sw_err once per device by calc_derived_calib */
+static const uint32_t gas_range_lookup1[16] = {
+    UINT32_C(2147483647), UINT32_C(2147483647), UINT32_C(2147483647), UINT32_C(2147483647), UINT32_C(2147483647),
+    UINT32_C(2126008810), UINT32_C(2147483647), UINT32_C(2130303777), UINT32_C(2147483647), UINT32_C(2147483647),
+    UINT32_C(2143188679), UINT32_C(2136746228), UINT32_C(2147483647), UINT32_C(2126008810), UINT32_C(2147483647),
+    UINT32_C(2147483647)
+};
+static const uint32_t gas_range_lookup2[16] = {
+    UINT32_C(4096000000), UINT32_C(2048000000), UINT32_C(1024000000), UINT32_C(512000000), UINT32_C(255744255),
+    UINT32_C(127110228), UINT32_C(64000000), UINT32_C(32258064), UINT32_C(16016016), UINT32_C(8000000), UINT32_C(
+        4000000), UINT32_C(2000000), UINT32_C(1000000), UINT32_C(500000), UINT32_C(250000), UINT32_C(125000)
+};
+
+/* 10000 * (262144 >> gas_range), the range factor of the high gas variant */
+static const uint32_t gas_range_high_lookup[16] = {
+    UINT32_C(2621440000), UINT32_C(1310720000), UINT32_C(655360000), UINT32_C(327680000), UINT32_C(163840000),
+    UINT32_C(81920000), UINT32_C(40960000), UINT32_C(20480000), UINT32_C(10240000), UINT32_C(5120000), UINT32_C(
+        2560000), UINT32_C(1280000), UINT32_C(640000), UINT32_C(320000), UINT32_C(160000), UINT32_C(80000)
+};
+
+/* This internal API is used to calculate the calibration-only terms of the integer compensation */
+static void calc_derived_calib(struct bme68x_calib_data *calib)
+{
+    struct bme68x_calib_derived *derived = &calib->derived;
+    uint8_t i;
+
+    /*lint -save -e701 -e704 */
+    derived->t1_x2 = (int32_t)calib->par_t1 << 1;
+    derived->t3_x16 = (int32_t)calib->par_t3 << 4;
+    derived->p3_x32 = (int32_t)calib->par_p3 << 5;
+    derived->p4_x65536 = (int32_t)calib->par_p4 << 16;
+    derived->p7_x128 = (int32_t)calib->par_p7 << 7;
+    derived->h1_x16 = (int32_t)calib->par_h1 * 16;
+    derived->h6_x128 = (int32_t)calib->par_h6 << 7;
+    for (i = 0; i < 16; i++)
+    {
+        derived->gas_var1[i] =
+            (int64_t)((1340 + (5 * (int64_t)calib->range_sw_err)) * ((int64_t)gas_range_lookup1[i])) >> 16;
+        derived->gas_var3[i] = (((int64_t)gas_range_lookup2[i] * derived->gas_var1[i]) >> 9);
+    }
 
-    return rslt;
+    /*lint -restore */
 }
 
-/*****************************INTERNAL APIs***********************************************/
-#ifndef BME68X_USE_FPU
-
-/* @brief This internal API is used to calculate the temperature value. */
-static int16_t calc_temperature(uint32_t temp_adc, struct bme68x_dev *dev)
+/* @brief This internal API is used to calculate t_fine. */
+static int32_t calc_t_fine(uint32_t temp_adc, const struct bme68x_calib_data *calib)
 {
     int64_t var1;
     int64_t var2;
     int64_t var3;
-    int16_t calc_temp;
 
     /*lint -save -e701 -e702 -e704 */
-    var1 = ((int32_t)temp_adc >> 3) - ((int32_t)dev->calib.par_t1 << 1);
-    var2 = (var1 * (int32_t)dev->calib.par_t2) >> 11;
+    var1 = ((int32_t)temp_adc >> 3) - calib->derived.t1_x2;
+    var2 = (var1 * (int32_t)calib->par_t2) >> 11;
     var3 = ((var1 >> 1) * (var1 >> 1)) >> 12;
-    var3 = ((var3) * ((int32_t)dev->calib.par_t3 << 4)) >> 14;
-    dev->calib.t_fine = (int32_t)(var2 + var3);
-    calc_temp = (int16_t)(((dev->calib.t_fine * 5) + 128) >> 8);
+    var3 = ((var3) * calib->derived.t3_x16) >> 14;
+
+    /*lint -restore */
+    return (int32_t)(var2 + var3);
+}
+
+/* @brief This internal API is used to calculate the temperature value. */
+static int16_t calc_temperature(int32_t t_fine)
+{
+    int16_t calc_temp;
+
+    /*lint -save -e702 */
+    calc_temp = (int16_t)(((t_fine * 5) + 128) >> 8);
 
     /*lint -restore */
     return calc_temp;
 }
 
 /* @brief This internal API is used to calculate the pressure value. */
-static uint32_t calc_pressure(uint32_t pres_adc, const struct bme68x_dev *dev)
+static uint32_t calc_pressure(uint32_t pres_adc, int32_t t_fine, const struct bme68x_calib_data *calib)
 {
     int32_t var1;
     int32_t var2;
@@ -866,38 +1382,33 @@ static uint32_t calc_pressure(uint32_t pres_adc, const struct bme68x_dev *dev)
     const int32_t pres_ovf_check = INT32_C(0x40000000);
 
     /*lint -save -e701 -e702 -e713 */
-    var1 = (((int32_t)dev->calib.t_fine) >> 1) - 64000;
-    var2 = ((((var1 >> 2) * (var1 >> 2)) >> 11) * (int32_t)dev->calib.par_p6) >> 2;
-    var2 = var2 + ((var1 * (int32_t)dev->calib.par_p5) << 1);
-    var2 = (var2 >> 2) + ((int32_t)dev->calib.par_p4 << 16);
-    var1 = (((((var1 >> 2) * (var1 >> 2)) >> 13) * ((int32_t)dev->calib.par_p3 << 5)) >> 3) +
-           (((int32_t)dev->calib.par_p2 * var1) >> 1);
+    var1 = (((int32_t)t_fine) >> 1) - 64000;
+    var2 = ((((var1 >> 2) * (var1 >> 2)) >> 11) * (int32_t)calib->par_p6) >> 2;
+    var2 = var2 + ((var1 * (int32_t)calib->par_p5) << 1);
+    var2 = (var2 >> 2) + calib->derived.p4_x65536;
+    var1 = (((((var1 >> 2) * (var1 >> 2)) >> 13) * calib->derived.p3_x32) >> 3) +
+           (((int32_t)calib->par_p2 * var1) >> 1);
     var1 = var1 >> 18;
-    var1 = ((32768 + var1) * (int32_t)dev->calib.par_p1) >> 15;
+    var1 = ((32768 + var1) * (int32_t)calib->par_p1) >> 15;
     pressure_comp = 1048576 - pres_adc;
     pressure_comp = (int32_t)((pressure_comp - (var2 >> 12)) * ((uint32_t)3125));
-    if (pressure_comp >= pres_ovf_check)
-    {
-        pressure_comp = ((pressure_comp / var1) << 1);
-    }
-    else
-    {
-        pressure_comp = ((pressure_comp << 1) / var1);
-    }
 
-    var1 = ((int32_t)dev->calib.par_p9 * (int32_t)(((pressure_comp >> 3) * (pressure_comp >> 3)) >> 13)) >> 12;
-    var2 = ((int32_t)(pressure_comp >> 2) * (int32_t)dev->calib.par_p8) >> 13;
+    /* Select rather than branch on the precedence, so batch loops stay straight line code */
+    pressure_comp = (pressure_comp >= pres_ovf_check) ? ((pressure_comp / var1) << 1) : ((pressure_comp << 1) / var1);
+
+    var1 = ((int32_t)calib->par_p9 * (int32_t)(((pressure_comp >> 3) * (pressure_comp >> 3)) >> 13)) >> 12;
+    var2 = ((int32_t)(pressure_comp >> 2) * (int32_t)calib->par_p8) >> 13;
     var3 =
         ((int32_t)(pressure_comp >> 8) * (int32_t)(pressure_comp >> 8) * (int32_t)(pressure_comp >> 8) *
-         (int32_t)dev->calib.par_p10) >> 17;
-    pressure_comp = (int32_t)(pressure_comp) + ((var1 + var2 + var3 + ((int32_t)dev->calib.par_p7 << 7)) >> 4);
+         (int32_t)calib->par_p10) >> 17;
+    pressure_comp = (int32_t)(pressure_comp) + ((var1 + var2 + var3 + calib->derived.p7_x128) >> 4);
 
     /*lint -restore */
     return (uint32_t)pressure_comp;
 }
 
 /* This internal API is used to calculate the humidity in integer */
-static uint32_t calc_humidity(uint16_t hum_adc, const struct bme68x_dev *dev)
+static uint32_t calc_humidity(uint16_t hum_adc, int32_t t_fine, const struct bme68x_calib_data *calib)
 {
     int32_t var1;
     int32_t var2;
@@ -909,56 +1420,39 @@ static uint32_t calc_humidity(uint16_t hum_adc, const struct bme68x_dev *dev)
     int32_t calc_hum;
 
     /*lint -save -e702 -e704 */
-    temp_scaled = (((int32_t)dev->calib.t_fine * 5) + 128) >> 8;
-    var1 = (int32_t)(hum_adc - ((int32_t)((int32_t)dev->calib.par_h1 * 16))) -
-           (((temp_scaled * (int32_t)dev->calib.par_h3) / ((int32_t)100)) >> 1);
+    temp_scaled = (((int32_t)t_fine * 5) + 128) >> 8;
+    var1 = (int32_t)(hum_adc - calib->derived.h1_x16) -
+           (((temp_scaled * (int32_t)calib->par_h3) / ((int32_t)100)) >> 1);
     var2 =
-        ((int32_t)dev->calib.par_h2 *
-         (((temp_scaled * (int32_t)dev->calib.par_h4) / ((int32_t)100)) +
-          (((temp_scaled * ((temp_scaled * (int32_t)dev->calib.par_h5) / ((int32_t)100))) >> 6) / ((int32_t)100)) +
+        ((int32_t)calib->par_h2 *
+         (((temp_scaled * (int32_t)calib->par_h4) / ((int32_t)100)) +
+          (((temp_scaled * ((temp_scaled * (int32_t)calib->par_h5) / ((int32_t)100))) >> 6) / ((int32_t)100)) +
           (int32_t)(1 << 14))) >> 10;
     var3 = var1 * var2;
-    var4 = (int32_t)dev->calib.par_h6 << 7;
-    var4 = ((var4) + ((temp_scaled * (int32_t)dev->calib.par_h7) / ((int32_t)100))) >> 4;
+    var4 = calib->derived.h6_x128;
+    var4 = ((var4) + ((temp_scaled * (int32_t)calib->par_h7) / ((int32_t)100))) >> 4;
     var5 = ((var3 >> 14) * (var3 >> 14)) >> 10;
     var6 = (var4 * var5) >> 1;
     calc_hum = (((var3 + var6) >> 10) * ((int32_t)1000)) >> 12;
-    if (calc_hum > 100000) /* Cap at 100%rH */
-    {
-        calc_hum = 100000;
-    }
-    else if (calc_hum < 0)
-    {
-        calc_hum = 0;
-    }
+    calc_hum = (calc_hum > 100000) ? 100000 : calc_hum; /* Cap at 100%rH */
+    calc_hum = (calc_hum < 0) ? 0 : calc_hum;
 
     /*lint -restore */
     return (uint32_t)calc_hum;
 }
 
 /* This internal API is used to calculate the gas resistance low */
-static uint32_t calc_gas_resistance_low(uint16_t gas_res_adc, uint8_t gas_range, const struct bme68x_dev *dev)
+static uint32_t calc_gas_resistance_low(uint16_t gas_res_adc, uint8_t gas_range, const struct bme68x_calib_data *calib)
 {
     int64_t var1;
     uint64_t var2;
     int64_t var3;
     uint32_t calc_gas_res;
-    uint32_t lookup_table1[16] = {
-        UINT32_C(2147483647), UINT32_C(2147483647), UINT32_C(2147483647), UINT32_C(2147483647), UINT32_C(2147483647),
-        UINT32_C(2126008810), UINT32_C(2147483647), UINT32_C(2130303777), UINT32_C(2147483647), UINT32_C(2147483647),
-        UINT32_C(2143188679), UINT32_C(2136746228), UINT32_C(2147483647), UINT32_C(2126008810), UINT32_C(2147483647),
-        UINT32_C(2147483647)
-    };
-    uint32_t lookup_table2[16] = {
-        UINT32_C(4096000000), UINT32_C(2048000000), UINT32_C(1024000000), UINT32_C(512000000), UINT32_C(255744255),
-        UINT32_C(127110228), UINT32_C(64000000), UINT32_C(32258064), UINT32_C(16016016), UINT32_C(8000000), UINT32_C(
-            4000000), UINT32_C(2000000), UINT32_C(1000000), UINT32_C(500000), UINT32_C(250000), UINT32_C(125000)
-    };
 
     /*lint -save -e704 */
-    var1 = (int64_t)((1340 + (5 * (int64_t)dev->calib.range_sw_err)) * ((int64_t)lookup_table1[gas_range])) >> 16;
+    var1 = calib->derived.gas_var1[gas_range];
     var2 = (((int64_t)((int64_t)gas_res_adc << 15) - (int64_t)(16777216)) + var1);
-    var3 = (((int64_t)lookup_table2[gas_range] * (int64_t)var1) >> 9);
+    var3 = calib->derived.gas_var3[gas_range];
     calc_gas_res = (uint32_t)((var3 + ((int64_t)var2 >> 1)) / (int64_t)var2);
 
     /*lint -restore */
@@ -969,14 +1463,13 @@ static uint32_t calc_gas_resistance_low(uint16_t gas_res_adc, uint8_t gas_range,
 static uint32_t calc_gas_resistance_high(uint16_t gas_res_adc, uint8_t gas_range)
 {
     uint32_t calc_gas_res;
-    uint32_t var1 = UINT32_C(262144) >> gas_range;
     int32_t var2 = (int32_t)gas_res_adc - INT32_C(512);
 
     var2 *= INT32_C(3);
     var2 = INT32_C(4096) + var2;
 
     /* multiplying 10000 then dividing then multiplying by 100 instead of multiplying by 1000000 to prevent overflow */
-    calc_gas_res = (UINT32_C(10000) * var1) / (uint32_t)var2;
+    calc_gas_res = gas_range_high_lookup[gas_range] / (uint32_t)var2;
     calc_gas_res = calc_gas_res * 100;
 
     return calc_gas_res;
@@ -1011,65 +1504,109 @@ static uint8_t calc_res_heat(uint16_t temp, const struct bme68x_dev *dev)
 
 #else
 
-/* @brief This internal API is used to calculate the temperature value. */
-static float calc_temperature(uint32_t temp_adc, struct bme68x_dev *dev)
+/* Gas range factors of the low gas variant, combined with range_sw_err once per device by calc_derived_calib */
+static const float gas_range_k1[16] = {
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, -0.8f, 0.0f, 0.0f, -0.2f, -0.5f, 0.0f, -1.0f, 0.0f, 0.0f
+};
+static const float gas_range_k2[16] = {
+    0.0f, 0.0f, 0.0f, 0.0f, 0.1f, 0.7f, 0.0f, -0.8f, -0.1f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f
+};
+
+/* 1000000 * (262144 >> gas_range), the range factor of the high gas variant. Exact in float */
+static const float gas_range_high_lookup[16] = {
+    262144000000.0f, 131072000000.0f, 65536000000.0f, 32768000000.0f, 16384000000.0f, 8192000000.0f, 4096000000.0f,
+    2048000000.0f, 1024000000.0f, 512000000.0f, 256000000.0f, 128000000.0f, 64000000.0f, 32000000.0f, 16000000.0f,
+    8000000.0f
+};
+
+/* This internal API is used to calculate the calibration-only terms of the float compensation */
+static void calc_derived_calib(struct bme68x_calib_data *calib)
+{
+    struct bme68x_calib_derived *derived = &calib->derived;
+    uint8_t i;
+    float var1;
+
+    derived->t1_div1024 = (float)calib->par_t1 / 1024.0f;
+    derived->t1_div8192 = (float)calib->par_t1 / 8192.0f;
+    derived->t3_x16 = (float)calib->par_t3 * 16.0f;
+    derived->p4_x65536 = ((float)calib->par_p4) * 65536.0f;
+    derived->p5_x2 = ((float)calib->par_p5) * 2.0f;
+    derived->p6_div131072 = ((float)calib->par_p6) / (131072.0f);
+    derived->p7_x128 = (float)calib->par_p7 * 128.0f;
+    derived->p8_div32768 = ((float)calib->par_p8) / 32768.0f;
+    derived->p10_div131072 = calib->par_p10 / 131072.0f;
+    derived->h1_x16 = (float)calib->par_h1 * 16.0f;
+    derived->h2_div262144 = (float)calib->par_h2 / 262144.0f;
+    derived->h3_div2 = (float)calib->par_h3 / 2.0f;
+    derived->h4_div16384 = (float)calib->par_h4 / 16384.0f;
+    derived->h5_div1048576 = (float)calib->par_h5 / 1048576.0f;
+    derived->h6_div16384 = (float)calib->par_h6 / 16384.0f;
+    derived->h7_div2097152 = (float)calib->par_h7 / 2097152.0f;
+
+    var1 = (1340.0f + (5.0f * calib->range_sw_err));
+    for (i = 0; i < 16; i++)
+    {
+        derived->gas_var2[i] = (var1) * (1.0f + gas_range_k1[i] / 100.0f);
+        derived->gas_scale[i] = (1.0f + (gas_range_k2[i] / 100.0f)) * (0.000000125f) *
+                                (float)(1U << i); /*lint !e790 / Suspicious truncation, integral to float */
+    }
+}
+
+/* @brief This internal API is used to calculate t_fine. */
+static float calc_t_fine(uint32_t temp_adc, const struct bme68x_calib_data *calib)
 {
     float var1;
     float var2;
-    float calc_temp;
 
     /* calculate var1 data */
-    var1 = ((((float)temp_adc / 16384.0f) - ((float)dev->calib.par_t1 / 1024.0f)) * ((float)dev->calib.par_t2));
+    var1 = ((((float)temp_adc / 16384.0f) - calib->derived.t1_div1024) * ((float)calib->par_t2));
 
     /* calculate var2 data */
     var2 =
-        (((((float)temp_adc / 131072.0f) - ((float)dev->calib.par_t1 / 8192.0f)) *
-          (((float)temp_adc / 131072.0f) - ((float)dev->calib.par_t1 / 8192.0f))) * ((float)dev->calib.par_t3 * 16.0f));
+        (((((float)temp_adc / 131072.0f) - calib->derived.t1_div8192) *
+          (((float)temp_adc / 131072.0f) - calib->derived.t1_div8192)) * calib->derived.t3_x16);
 
-    /* t_fine value*/
-    dev->calib.t_fine = (var1 + var2);
+    return (var1 + var2);
+}
 
+/* @brief This internal API is used to calculate the temperature value. */
+static float calc_temperature(float t_fine)
+{
     /* compensated temperature data*/
-    calc_temp = ((dev->calib.t_fine) / 5120.0f);
-
-    return calc_temp;
+    return (t_fine / 5120.0f);
 }
 
 /* @brief This internal API is used to calculate the pressure value. */
-static float calc_pressure(uint32_t pres_adc, const struct bme68x_dev *dev)
+static float calc_pressure(uint32_t pres_adc, float t_fine, const struct bme68x_calib_data *calib)
 {
     float var1;
     float var2;
     float var3;
     float calc_pres;
-
-    var1 = (((float)dev->calib.t_fine / 2.0f) - 64000.0f);
-    var2 = var1 * var1 * (((float)dev->calib.par_p6) / (131072.0f));
-    var2 = var2 + (var1 * ((float)dev->calib.par_p5) * 2.0f);
-    var2 = (var2 / 4.0f) + (((float)dev->calib.par_p4) * 65536.0f);
-    var1 = (((((float)dev->calib.par_p3 * var1 * var1) / 16384.0f) + ((float)dev->calib.par_p2 * var1)) / 524288.0f);
-    var1 = ((1.0f + (var1 / 32768.0f)) * ((float)dev->calib.par_p1));
+    uint8_t div_ok;
+
+    var1 = ((t_fine / 2.0f) - 64000.0f);
+    var2 = var1 * var1 * calib->derived.p6_div131072;
+    var2 = var2 + (var1 * calib->derived.p5_x2);
+    var2 = (var2 / 4.0f) + calib->derived.p4_x65536;
+    var1 = (((((float)calib->par_p3 * var1 * var1) / 16384.0f) + ((float)calib->par_p2 * var1)) / 524288.0f);
+    var1 = ((1.0f + (var1 / 32768.0f)) * ((float)calib->par_p1));
     calc_pres = (1048576.0f - ((float)pres_adc));
 
-    /* Avoid exception caused by division by zero */
-    if ((int)var1 != 0)
-    {
-        calc_pres = (((calc_pres - (var2 / 4096.0f)) * 6250.0f) / var1);
-        var1 = (((float)dev->calib.par_p9) * calc_pres * calc_pres) / 2147483648.0f;
-        var2 = calc_pres * (((float)dev->calib.par_p8) / 32768.0f);
-        var3 = ((calc_pres / 256.0f) * (calc_pres / 256.0f) * (calc_pres / 256.0f) * (dev->calib.par_p10 / 131072.0f));
-        calc_pres = (calc_pres + (var1 + var2 + var3 + ((float)dev->calib.par_p7 * 128.0f)) / 16.0f);
-    }
-    else
-    {
-        calc_pres = 0;
-    }
+    /* Avoid exception caused by division by zero. Selects rather than branches, so batch loops stay straight line code */
+    div_ok = ((int)var1 != 0);
+    var1 = div_ok ? var1 : 1.0f;
+    calc_pres = (((calc_pres - (var2 / 4096.0f)) * 6250.0f) / var1);
+    var1 = (((float)calib->par_p9) * calc_pres * calc_pres) / 2147483648.0f;
+    var2 = calc_pres * calib->derived.p8_div32768;
+    var3 = ((calc_pres / 256.0f) * (calc_pres / 256.0f) * (calc_pres / 256.0f) * calib->derived.p10_div131072);
+    calc_pres = (calc_pres + (var1 + var2 + var3 + calib->derived.p7_x128) / 16.0f);
 
-    return calc_pres;
+    return div_ok ? calc_pres : 0.0f;
 }
 
 /* This internal API is used to calculate the humidity in integer */
-static float calc_humidity(uint16_t hum_adc, const struct bme68x_dev *dev)
+static float calc_humidity(uint16_t hum_adc, float t_fine, const struct bme68x_calib_data *calib)
 {
     float calc_hum;
     float var1;
@@ -1079,48 +1616,31 @@ static float calc_humidity(uint16_t hum_adc, const struct bme68x_dev *dev)
     float temp_comp;
 
     /* compensated temperature data*/
-    temp_comp = ((dev->calib.t_fine) / 5120.0f);
+    temp_comp = (t_fine / 5120.0f);
     var1 = (float)((float)hum_adc) -
-           (((float)dev->calib.par_h1 * 16.0f) + (((float)dev->calib.par_h3 / 2.0f) * temp_comp));
+           (calib->derived.h1_x16 + (calib->derived.h3_div2 * temp_comp));
     var2 = var1 *
-           ((float)(((float)dev->calib.par_h2 / 262144.0f) *
-                    (1.0f + (((float)dev->calib.par_h4 / 16384.0f) * temp_comp) +
-                     (((float)dev->calib.par_h5 / 1048576.0f) * temp_comp * temp_comp))));
-    var3 = (float)dev->calib.par_h6 / 16384.0f;
-    var4 = (float)dev->calib.par_h7 / 2097152.0f;
+           ((float)(calib->derived.h2_div262144 *
+                    (1.0f + (calib->derived.h4_div16384 * temp_comp) +
+                     (calib->derived.h5_div1048576 * temp_comp * temp_comp))));
+    var3 = calib->derived.h6_div16384;
+    var4 = calib->derived.h7_div2097152;
     calc_hum = var2 + ((var3 + (var4 * temp_comp)) * var2 * var2);
-    if (calc_hum > 100.0f)
-    {
-        calc_hum = 100.0f;
-    }
-    else if (calc_hum < 0.0f)
-    {
-        calc_hum = 0.0f;
-    }
+    calc_hum = (calc_hum > 100.0f) ? 100.0f : calc_hum;
+    calc_hum = (calc_hum < 0.0f) ? 0.0f : calc_hum;
 
     return calc_hum;
 }
 
 /* This internal API is used to calculate the gas resistance low value in float */
-static float calc_gas_resistance_low(uint16_t gas_res_adc, uint8_t gas_range, const struct bme68x_dev *dev)
+static float calc_gas_resistance_low(uint16_t gas_res_adc, uint8_t gas_range, const struct bme68x_calib_data *calib)
 {
     float calc_gas_res;
-    float var1;
-    float var2;
-    float var3;
     float gas_res_f = gas_res_adc;
-    float gas_range_f = (1U << gas_range); /*lint !e790 / Suspicious truncation, integral to float */
-    const float lookup_k1_range[16] = {
-        0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, -0.8f, 0.0f, 0.0f, -0.2f, -0.5f, 0.0f, -1.0f, 0.0f, 0.0f
-    };
-    const float lookup_k2_range[16] = {
-        0.0f, 0.0f, 0.0f, 0.0f, 0.1f, 0.7f, 0.0f, -0.8f, -0.1f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f
-    };
-
-    var1 = (1340.0f + (5.0f * dev->calib.range_sw_err));
-    var2 = (var1) * (1.0f + lookup_k1_range[gas_range] / 100.0f);
-    var3 = 1.0f + (lookup_k2_range[gas_range] / 100.0f);
-    calc_gas_res = 1.0f / (float)(var3 * (0.000000125f) * gas_range_f * (((gas_res_f - 512.0f) / var2) + 1.0f));
+
+    calc_gas_res = 1.0f /
+                   (float)(calib->derived.gas_scale[gas_range] *
+                           (((gas_res_f - 512.0f) / calib->derived.gas_var2[gas_range]) + 1.0f));
 
     return calc_gas_res;
 }
@@ -1129,13 +1649,12 @@ static float calc_gas_resistance_low(uint16_t gas_res_adc, uint8_t gas_range, co
 static float calc_gas_resistance_high(uint16_t gas_res_adc, uint8_t gas_range)
 {
     float calc_gas_res;
-    uint32_t var1 = UINT32_C(262144) >> gas_range;
     int32_t var2 = (int32_t)gas_res_adc - INT32_C(512);
 
     var2 *= INT32_C(3);
     var2 = INT32_C(4096) + var2;
 
-    calc_gas_res = 1000000.0f * (float)var1 / (float)var2;
+    calc_gas_res = gas_range_high_lookup[gas_range] / (float)var2;
 
     return calc_gas_res;
 }
@@ -1195,17 +1714,18 @@ static uint8_t calc_gas_wait(uint16_t dur)
     return durval;
 }
 
-/* This internal API is used to read a single data of the sensor */
-static int8_t read_field_data(uint8_t index, struct bme68x_data *data, struct bme68x_dev *dev)
+/* This internal API is used to read a single data of the sensor, polling
+ * it up to tries times until it holds new data */
+static int8_t read_field_data(uint8_t index, struct bme68x_data *data, uint8_t tries, struct bme68x_dev *dev)
 {
     int8_t rslt = BME68X_OK;
     uint8_t buff[BME68X_LEN_FIELD] = { 0 };
-    uint8_t gas_range_l, gas_range_h;
+    uint8_t gas_range;
     uint32_t adc_temp;
     uint32_t adc_pres;
     uint16_t adc_hum;
-    uint16_t adc_gas_res_low, adc_gas_res_high;
-    uint8_t tries = 5;
+    uint16_t adc_gas_res;
+    uint8_t set_val[30] = { 0 }; /* idac, res_heat, gas_wait */
 
     while ((tries) && (rslt == BME68X_OK))
     {
@@ -1219,61 +1739,36 @@ static int8_t read_field_data(uint8_t index, struct bme68x_data *data, struct bm
             break;
         }
 
-        data->status = buff[0] & BME68X_NEW_DATA_MSK;
-        data->gas_index = buff[0] & BME68X_GAS_INDEX_MSK;
-        data->meas_index = buff[1];
-
-        /* read the raw data from the sensor */
-        adc_pres = (uint32_t)(((uint32_t)buff[2] * 4096) | ((uint32_t)buff[3] * 16) | ((uint32_t)buff[4] / 16));
-        adc_temp = (uint32_t)(((uint32_t)buff[5] * 4096) | ((uint32_t)buff[6] * 16) | ((uint32_t)buff[7] / 16));
-        adc_hum = (uint16_t)(((uint32_t)buff[8] * 256) | (uint32_t)buff[9]);
-        adc_gas_res_low = (uint16_t)((uint32_t)buff[13] * 4 | (((uint32_t)buff[14]) / 64));
-        adc_gas_res_high = (uint16_t)((uint32_t)buff[15] * 4 | (((uint32_t)buff[16]) / 64));
-        gas_range_l = buff[14] & BME68X_GAS_RANGE_MSK;
-        gas_range_h = buff[16] & BME68X_GAS_RANGE_MSK;
-        if (dev->variant_id == BME68X_VARIANT_GAS_HIGH)
-        {
-            data->status |= buff[16] & BME68X_GASM_VALID_MSK;
-            data->status |= buff[16] & BME68X_HEAT_STAB_MSK;
-        }
-        else
-        {
-            data->status |= buff[14] & BME68X_GASM_VALID_MSK;
-            data->status |= buff[14] & BME68X_HEAT_STAB_MSK;
-        }
+        parse_field(buff, dev->variant_id, data, &adc_temp, &adc_pres, &adc_hum, &adc_gas_res, &gas_range);
 
         if ((data->status & BME68X_NEW_DATA_MSK) && (rslt == BME68X_OK))
         {
-            rslt = bme68x_get_regs(BME68X_REG_RES_HEAT0 + data->gas_index, &data->res_heat, 1, dev);
-            if (rslt == BME68X_OK)
-            {
-                rslt = bme68x_get_regs(BME68X_REG_IDAC_HEAT0 + data->gas_index, &data->idac, 1, dev);
-            }
-
+            /* One read for all three heater settings, served by the shadow registers when enabled */
+            rslt = bme68x_get_regs(BME68X_REG_IDAC_HEAT0, set_val, 30, dev);
             if (rslt == BME68X_OK)
             {
-                rslt = bme68x_get_regs(BME68X_REG_GAS_WAIT0 + data->gas_index, &data->gas_wait, 1, dev);
-            }
-
-            if (rslt == BME68X_OK)
-            {
-                data->temperature = calc_temperature(adc_temp, dev);
-                data->pressure = calc_pressure(adc_pres, dev);
-                data->humidity = calc_humidity(adc_hum, dev);
+                data->idac = set_val[data->gas_index];
+                data->res_heat = set_val[10 + data->gas_index];
+                data->gas_wait = set_val[20 + data->gas_index];
+                dev->calib.t_fine = calc_t_fine(adc_temp, &dev->calib);
+                data->temperature = calc_temperature(dev->calib.t_fine);
+                data->pressure = calc_pressure(adc_pres, dev->calib.t_fine, &dev->calib);
+                data->humidity = calc_humidity(adc_hum, dev->calib.t_fine, &dev->calib);
                 if (dev->variant_id == BME68X_VARIANT_GAS_HIGH)
                 {
-                    data->gas_resistance = calc_gas_resistance_high(adc_gas_res_high, gas_range_h);
+                    data->gas_resistance = calc_gas_resistance_high(adc_gas_res, gas_range);
                 }
                 else
                 {
-                    data->gas_resistance = calc_gas_resistance_low(adc_gas_res_low, gas_range_l, dev);
+                    data->gas_resistance = calc_gas_resistance_low(adc_gas_res, gas_range, &dev->calib);
                 }
 
                 break;
             }
         }
 
-        if (rslt == BME68X_OK)
+        /* No point waiting after the last read */
+        if ((rslt == BME68X_OK) && (tries > 1))
         {
             dev->delay_us(BME68X_PERIOD_POLL, dev->intf_ptr);
         }
@@ -1284,82 +1779,176 @@ static int8_t read_field_data(uint8_t index, struct bme68x_data *data, struct bm
     return rslt;
 }
 
-/* This internal API is used to read all data fields of the sensor */
-static int8_t read_all_field_data(struct bme68x_data * const data[], struct bme68x_dev *dev)
+/* This internal API is used to read all data fields of the sensor. Only
+ * the new fields are decoded, straight into data in chronological order */
+static int8_t read_all_field_data(struct bme68x_data *data, uint8_t *n_new, struct bme68x_dev *dev)
 {
-    int8_t rslt = BME68X_OK;
-    uint8_t buff[BME68X_LEN_FIELD * 3] = { 0 };
-    uint8_t gas_range_l, gas_range_h;
-    uint32_t adc_temp;
-    uint32_t adc_pres;
-    uint16_t adc_hum;
-    uint16_t adc_gas_res_low, adc_gas_res_high;
-    uint8_t off;
+    int8_t rslt;
+    uint8_t buff[BME68X_LEN_FIELD * BME68X_N_FIELDS] = { 0 };
+    uint8_t order[BME68X_N_FIELDS];
+    uint32_t adc_temp[BME68X_N_FIELDS];
+    uint32_t adc_pres[BME68X_N_FIELDS];
+    uint16_t adc_hum[BME68X_N_FIELDS];
+    uint16_t adc_gas_res[BME68X_N_FIELDS];
+    uint8_t gas_range[BME68X_N_FIELDS];
     uint8_t set_val[30] = { 0 }; /* idac, res_heat, gas_wait */
     uint8_t i;
+    struct bme68x_raw_batch raw = { adc_temp, adc_pres, adc_hum, adc_gas_res, gas_range };
+    struct bme68x_comp_batch comp;
+#ifndef BME68X_USE_FPU
+    int16_t temperature[BME68X_N_FIELDS];
+    uint32_t pressure[BME68X_N_FIELDS];
+    uint32_t humidity[BME68X_N_FIELDS];
+    uint32_t gas_resistance[BME68X_N_FIELDS];
+#else
+    float temperature[BME68X_N_FIELDS];
+    float pressure[BME68X_N_FIELDS];
+    float humidity[BME68X_N_FIELDS];
+    float gas_resistance[BME68X_N_FIELDS];
+#endif
 
-    if (!data[0] && !data[1] && !data[2])
-    {
-        rslt = BME68X_E_NULL_PTR;
-    }
+    comp.temperature = temperature;
+    comp.pressure = pressure;
+    comp.humidity = humidity;
+    comp.gas_resistance = gas_resistance;
 
+    *n_new = 0;
+    rslt = bme68x_get_regs(BME68X_REG_FIELD0, buff, (uint32_t) BME68X_LEN_FIELD * BME68X_N_FIELDS, dev);
     if (rslt == BME68X_OK)
     {
-        rslt = bme68x_get_regs(BME68X_REG_FIELD0, buff, (uint32_t) BME68X_LEN_FIELD * 3, dev);
+        *n_new = order_fields(buff, BME68X_N_FIELDS, order);
     }
 
-    if (rslt == BME68X_OK)
+    if ((rslt == BME68X_OK) && (*n_new > 0))
     {
         rslt = bme68x_get_regs(BME68X_REG_IDAC_HEAT0, set_val, 30, dev);
     }
 
-    for (i = 0; ((i < 3) && (rslt == BME68X_OK)); i++)
-    {
-        off = (uint8_t)(i * BME68X_LEN_FIELD);
-        data[i]->status = buff[off] & BME68X_NEW_DATA_MSK;
-        data[i]->gas_index = buff[off] & BME68X_GAS_INDEX_MSK;
-        data[i]->meas_index = buff[off + 1];
-
-        /* read the raw data from the sensor */
-        adc_pres =
-            (uint32_t) (((uint32_t) buff[off + 2] * 4096) | ((uint32_t) buff[off + 3] * 16) |
-                        ((uint32_t) buff[off + 4] / 16));
-        adc_temp =
-            (uint32_t) (((uint32_t) buff[off + 5] * 4096) | ((uint32_t) buff[off + 6] * 16) |
-                        ((uint32_t) buff[off + 7] / 16));
-        adc_hum = (uint16_t) (((uint32_t) buff[off + 8] * 256) | (uint32_t) buff[off + 9]);
-        adc_gas_res_low = (uint16_t) ((uint32_t) buff[off + 13] * 4 | (((uint32_t) buff[off + 14]) / 64));
-        adc_gas_res_high = (uint16_t) ((uint32_t) buff[off + 15] * 4 | (((uint32_t) buff[off + 16]) / 64));
-        gas_range_l = buff[off + 14] & BME68X_GAS_RANGE_MSK;
-        gas_range_h = buff[off + 16] & BME68X_GAS_RANGE_MSK;
-        if (dev->variant_id == BME68X_VARIANT_GAS_HIGH)
+    if ((rslt == BME68X_OK) && (*n_new > 0))
+    {
+        for (i = 0; i < *n_new; i++)
         {
-            data[i]->status |= buff[off + 16] & BME68X_GASM_VALID_MSK;
-            data[i]->status |= buff[off + 16] & BME68X_HEAT_STAB_MSK;
+            parse_field(&buff[order[i] * BME68X_LEN_FIELD],
+                        dev->variant_id,
+                        &data[i],
+                        &adc_temp[i],
+                        &adc_pres[i],
+                        &adc_hum[i],
+                        &adc_gas_res[i],
+                        &gas_range[i]);
+            data[i].idac = set_val[data[i].gas_index];
+            data[i].res_heat = set_val[10 + data[i].gas_index];
+            data[i].gas_wait = set_val[20 + data[i].gas_index];
         }
-        else
+
+        /* Compensate the new fields as one batch, then scatter the results back into the records */
+        compensate_batch(&raw, &comp, *n_new, dev);
+        for (i = 0; i < *n_new; i++)
         {
-            data[i]->status |= buff[off + 14] & BME68X_GASM_VALID_MSK;
-            data[i]->status |= buff[off + 14] & BME68X_HEAT_STAB_MSK;
+            data[i].temperature = temperature[i];
+            data[i].pressure = pressure[i];
+            data[i].humidity = humidity[i];
+            data[i].gas_resistance = gas_resistance[i];
         }
 
-        data[i]->idac = set_val[data[i]->gas_index];
-        data[i]->res_heat = set_val[10 + data[i]->gas_index];
-        data[i]->gas_wait = set_val[20 + data[i]->gas_index];
-        data[i]->temperature = calc_temperature(adc_temp, dev);
-        data[i]->pressure = calc_pressure(adc_pres, dev);
-        data[i]->humidity = calc_humidity(adc_hum, dev);
-        if (dev->variant_id == BME68X_VARIANT_GAS_HIGH)
+        /* Leave calib.t_fine holding the term of the newest field */
+        dev->calib.t_fine = calc_t_fine(adc_temp[*n_new - 1], &dev->calib);
+    }
+    else if (*n_new > 0)
+    {
+        *n_new = 0;
+    }
+
+    return rslt;
+}
+
+/* This internal API is used to decode the status and raw ADC values of a
+ * field register image. Only the gas channel of the variant is decoded:
+ * 13/14 on the BME680, 15/16 on the BME688 */
+static void parse_field(const uint8_t *buff,
+                        uint8_t variant_id,
+                        struct bme68x_data *data,
+                        uint32_t *adc_temp,
+                        uint32_t *adc_pres,
+                        uint16_t *adc_hum,
+                        uint16_t *adc_gas,
+                        uint8_t *gas_range)
+{
+    uint8_t gas_off = (variant_id == BME68X_VARIANT_GAS_HIGH) ? 15 : 13;
+
+    data->status = buff[0] & BME68X_NEW_DATA_MSK;
+    data->gas_index = buff[0] & BME68X_GAS_INDEX_MSK;
+    data->meas_index = buff[1];
+    data->status |= buff[gas_off + 1] & BME68X_GASM_VALID_MSK;
+    data->status |= buff[gas_off + 1] & BME68X_HEAT_STAB_MSK;
+
+    /* read the raw data from the sensor */
+    *adc_pres = (uint32_t)(((uint32_t)buff[2] * 4096) | ((uint32_t)buff[3] * 16) | ((uint32_t)buff[4] / 16));
+    *adc_temp = (uint32_t)(((uint32_t)buff[5] * 4096) | ((uint32_t)buff[6] * 16) | ((uint32_t)buff[7] / 16));
+    *adc_hum = (uint16_t)(((uint32_t)buff[8] * 256) | (uint32_t)buff[9]);
+    *adc_gas = (uint16_t)((uint32_t)buff[gas_off] * 4 | (((uint32_t)buff[gas_off + 1]) / 64));
+    *gas_range = buff[gas_off + 1] & BME68X_GAS_RANGE_MSK;
+}
+
+/* This internal API is used to compensate arrays of raw ADC values */
+static void compensate_batch(const struct bme68x_raw_batch *raw,
+                             const struct bme68x_comp_batch *comp,
+                             uint32_t n,
+                             const struct bme68x_dev *dev)
+{
+    const struct bme68x_calib_data *calib = &dev->calib;
+    uint32_t base;
+    uint32_t len;
+    uint32_t i;
+
+#ifndef BME68X_USE_FPU
+    int32_t t_fine[BME68X_BATCH_CHUNK];
+#else
+    float t_fine[BME68X_BATCH_CHUNK];
+#endif
+
+    /* t_fine is kept in a chunk sized scratch array and handed to pressure and humidity explicitly, so each loop
+     * below only reads its inputs and writes its own output array */
+    for (base = 0; base < n; base += len)
+    {
+        len = ((n - base) < BME68X_BATCH_CHUNK) ? (n - base) : BME68X_BATCH_CHUNK;
+
+        for (i = 0; i < len; i++)
         {
-            data[i]->gas_resistance = calc_gas_resistance_high(adc_gas_res_high, gas_range_h);
+            t_fine[i] = calc_t_fine(raw->temp_adc[base + i], calib);
         }
-        else
+
+        for (i = 0; i < len; i++)
+        {
+            comp->temperature[base + i] = calc_temperature(t_fine[i]);
+        }
+
+        for (i = 0; i < len; i++)
+        {
+            comp->pressure[base + i] = calc_pressure(raw->pres_adc[base + i], t_fine[i], calib);
+        }
+
+        for (i = 0; i < len; i++)
         {
-            data[i]->gas_resistance = calc_gas_resistance_low(adc_gas_res_low, gas_range_l, dev);
+            comp->humidity[base + i] = calc_humidity(raw->hum_adc[base + i], t_fine[i], calib);
         }
     }
 
-    return rslt;
+    /* The variant does not change within a batch, so it is resolved once outside the loops */
+    if (dev->variant_id == BME68X_VARIANT_GAS_HIGH)
+    {
+        for (i = 0; i < n; i++)
+        {
+            comp->gas_resistance[i] = calc_gas_resistance_high(raw->gas_adc[i], raw->gas_range[i]);
+        }
+    }
+    else
+    {
+        for (i = 0; i < n; i++)
+        {
+            comp->gas_resistance[i] = calc_gas_resistance_low(raw->gas_adc[i], raw->gas_range[i], calib);
+        }
+    }
 }
 
 /* This internal API is used to switch between SPI memory pages */
@@ -1469,88 +2058,156 @@ static int8_t null_ptr_check(const struct bme68x_dev *dev)
     return rslt;
 }
 
-/* This internal API is used to set heater configurations */
-static int8_t set_conf(const struct bme68x_heatr_conf *conf, uint8_t op_mode, uint8_t *nb_conv, struct bme68x_dev *dev)
+/* This internal API is used to serve a register read from the shadow
+ * registers. Returns 1 if reg_data was filled, 0 if the sensor has to be read */
+static uint8_t read_shadow(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, struct bme68x_dev *dev)
 {
-    int8_t rslt = BME68X_OK;
-    uint8_t i;
-    uint8_t shared_dur;
-    uint8_t write_len = 0;
-    uint8_t heater_dur_shared_addr = BME68X_REG_SHD_HEATR_DUR;
-    uint8_t rh_reg_addr[10] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
-    uint8_t rh_reg_data[10] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
-    uint8_t gw_reg_addr[10] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
-    uint8_t gw_reg_data[10] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+    uint32_t offset = (uint32_t)reg_addr - BME68X_REG_IDAC_HEAT0;
+    uint32_t index;
 
-    switch (op_mode)
+    if ((!dev->shadow_valid) || (reg_addr < BME68X_REG_IDAC_HEAT0) || ((offset + len) > BME68X_LEN_SHADOW))
     {
-        case BME68X_FORCED_MODE:
-            rh_reg_addr[0] = BME68X_REG_RES_HEAT0;
-            rh_reg_data[0] = calc_res_heat(conf->heatr_temp, dev);
-            gw_reg_addr[0] = BME68X_REG_GAS_WAIT0;
-            gw_reg_data[0] = calc_gas_wait(conf->heatr_dur);
-            (*nb_conv) = 0;
-            write_len = 1;
-            break;
-        case BME68X_SEQUENTIAL_MODE:
-            if ((!conf->heatr_dur_prof) || (!conf->heatr_temp_prof))
-            {
-                rslt = BME68X_E_NULL_PTR;
-                break;
-            }
+        return 0;
+    }
 
-            for (i = 0; i < conf->profile_len; i++)
-            {
-                rh_reg_addr[i] = BME68X_REG_RES_HEAT0 + i;
-                rh_reg_data[i] = calc_res_heat(conf->heatr_temp_prof[i], dev);
-                gw_reg_addr[i] = BME68X_REG_GAS_WAIT0 + i;
-                gw_reg_data[i] = calc_gas_wait(conf->heatr_dur_prof[i]);
-            }
+    /* A forced measurement puts the sensor back to sleep by itself, so ctrl_meas is read from the sensor */
+    if ((reg_addr <= BME68X_REG_CTRL_MEAS) && ((reg_addr + len) > BME68X_REG_CTRL_MEAS) &&
+        ((dev->shadow[BME68X_REG_CTRL_MEAS - BME68X_REG_IDAC_HEAT0] & BME68X_MODE_MSK) == BME68X_FORCED_MODE))
+    {
+        return 0;
+    }
 
-            (*nb_conv) = conf->profile_len;
-            write_len = conf->profile_len;
-            break;
-        case BME68X_PARALLEL_MODE:
-            if ((!conf->heatr_dur_prof) || (!conf->heatr_temp_prof))
-            {
-                rslt = BME68X_E_NULL_PTR;
-                break;
-            }
+    if ((dev->shadow_check_period != 0) && (++dev->shadow_reads >= dev->shadow_check_period))
+    {
+        (void) bme68x_check_shadow(dev);
+        if (!dev->shadow_valid)
+        {
+            return 0;
+        }
+    }
 
-            if (conf->shared_heatr_dur == 0)
-            {
-                rslt = BME68X_W_DEFINE_SHD_HEATR_DUR;
-            }
+    for (index = 0; index < len; index++)
+    {
+        reg_data[index] = dev->shadow[offset + index];
+    }
 
-            for (i = 0; i < conf->profile_len; i++)
+    return 1;
+}
+
+/* This internal API is used to update a register in the shadow registers,
+ * registers outside the shadowed range are ignored */
+static void update_shadow(uint8_t reg_addr, uint8_t reg_data, struct bme68x_dev *dev)
+{
+    if (dev->shadow_valid && (reg_addr >= BME68X_REG_IDAC_HEAT0) &&
+        (reg_addr < (BME68X_REG_IDAC_HEAT0 + BME68X_LEN_SHADOW)))
+    {
+        dev->shadow[reg_addr - BME68X_REG_IDAC_HEAT0] = reg_data;
+    }
+}
+
+/* This internal API is used to write interleaved register address and data
+ * pairs. len is the number of registers. Up to BME68X_LEN_BURST_BUFF / 2
+ * registers go in one transfer; on SPI a transfer also ends where the memory
+ * page changes, and the addresses in buff are masked in place */
+static int8_t write_interleaved(uint8_t *buff, uint32_t len, struct bme68x_dev *dev)
+{
+    int8_t rslt = BME68X_OK;
+    uint32_t start = 0;
+    uint32_t end;
+    uint32_t index;
+
+    while ((rslt == BME68X_OK) && (start < len))
+    {
+        end = start + 1;
+        while ((end < len) && ((end - start) < (BME68X_LEN_BURST_BUFF / 2)) &&
+               ((dev->intf != BME68X_SPI_INTF) || ((buff[2 * end] > 0x7f) == (buff[2 * start] > 0x7f))))
+        {
+            end++;
+        }
+
+        for (index = start; index < end; index++)
+        {
+            update_shadow(buff[2 * index], buff[(2 * index) + 1], dev);
+        }
+
+        if (dev->intf == BME68X_SPI_INTF)
+        {
+            /* Set the memory page */
+            rslt = set_mem_page(buff[2 * start], dev);
+            for (index = start; index < end; index++)
             {
-                rh_reg_addr[i] = BME68X_REG_RES_HEAT0 + i;
-                rh_reg_data[i] = calc_res_heat(conf->heatr_temp_prof[i], dev);
-                gw_reg_addr[i] = BME68X_REG_GAS_WAIT0 + i;
-                gw_reg_data[i] = (uint8_t) conf->heatr_dur_prof[i];
+                buff[2 * index] &= BME68X_SPI_WR_MSK;
             }
+        }
 
-            (*nb_conv) = conf->profile_len;
-            write_len = conf->profile_len;
-            shared_dur = calc_heatr_dur_shared(conf->shared_heatr_dur);
-            if (rslt == BME68X_OK)
+        if (rslt == BME68X_OK)
+        {
+            dev->intf_rslt = dev->write(buff[2 * start], &buff[(2 * start) + 1], (2 * (end - start)) - 1, dev->intf_ptr);
+            if (dev->intf_rslt != 0)
             {
-                rslt = bme68x_set_regs(&heater_dur_shared_addr, &shared_dur, 1, dev);
+                rslt = BME68X_E_COM_FAIL;
             }
+        }
 
-            break;
-        default:
-            rslt = BME68X_W_DEFINE_OP_MODE;
-    }
+        if (rslt != BME68X_OK)
+        {
+            /* The registers may or may not have been written */
+            dev->shadow_valid = 0;
+        }
 
-    if (rslt == BME68X_OK)
-    {
-        rslt = bme68x_set_regs(rh_reg_addr, rh_reg_data, write_len, dev);
+        start = end;
     }
 
+    return rslt;
+}
+
+/* This internal API is used to write a compiled heater configuration. The
+ * res_heat_x, gas_wait_x, shared heater duration and ctrl_gas registers are
+ * interleaved into one buffer, so with the default BME68X_LEN_BURST_BUFF the
+ * whole image is a single transfer. The sensor takes writes only as address
+ * and data pairs, so one transfer is never more bytes on the bus than writing
+ * the blocks separately, it saves the device address of every transfer left
+ * out. That holds whether or not the shadow is valid; the shadow only saves
+ * the ctrl_gas read before the write */
+static int8_t write_heatr_image(const struct bme68x_heatr_image *image, struct bme68x_dev *dev)
+{
+    int8_t rslt;
+    uint8_t i;
+    uint8_t len = 0;
+    uint8_t ctrl_gas_data[2];
+    uint8_t tmp_buff[2 * BME68X_LEN_HEATR_IMAGE_REGS];
+
+    rslt = bme68x_get_regs(BME68X_REG_CTRL_GAS_0, ctrl_gas_data, 2, dev);
     if (rslt == BME68X_OK)
     {
-        rslt = bme68x_set_regs(gw_reg_addr, gw_reg_data, write_len, dev);
+        ctrl_gas_data[0] = BME68X_SET_BITS(ctrl_gas_data[0], BME68X_HCTRL, image->hctrl);
+        ctrl_gas_data[1] = BME68X_SET_BITS_POS_0(ctrl_gas_data[1], BME68X_NBCONV, image->nb_conv);
+        ctrl_gas_data[1] = BME68X_SET_BITS(ctrl_gas_data[1], BME68X_RUN_GAS, image->run_gas);
+
+        for (i = 0; i < image->len; i++)
+        {
+            tmp_buff[len++] = BME68X_REG_RES_HEAT0 + i;
+            tmp_buff[len++] = image->res_heat[i];
+        }
+
+        for (i = 0; i < image->len; i++)
+        {
+            tmp_buff[len++] = BME68X_REG_GAS_WAIT0 + i;
+            tmp_buff[len++] = image->gas_wait[i];
+        }
+
+        if (image->op_mode == BME68X_PARALLEL_MODE)
+        {
+            tmp_buff[len++] = BME68X_REG_SHD_HEATR_DUR;
+            tmp_buff[len++] = image->shared_heatr_dur;
+        }
+
+        tmp_buff[len++] = BME68X_REG_CTRL_GAS_0;
+        tmp_buff[len++] = ctrl_gas_data[0];
+        tmp_buff[len++] = BME68X_REG_CTRL_GAS_1;
+        tmp_buff[len++] = ctrl_gas_data[1];
+
+        rslt = write_interleaved(tmp_buff, len / 2, dev);
     }
 
     return rslt;
@@ -1583,137 +2240,121 @@ static uint8_t calc_heatr_dur_shared(uint16_t dur)
     return heatdurval;
 }
 
-/* This internal API is used sort the sensor data */
-static void sort_sensor_data(uint8_t low_index, uint8_t high_index, struct bme68x_data *field[])
+/* This internal API is used to order the new fields chronologically. order
+ * receives the indexes of the fields with new data, oldest first, and the
+ * number of new fields is returned.
+ *
+ * The fields are filled round robin with an incrementing 8-bit
+ * sub-measurement index which looks like
+ * Field index | Sub-meas index
+ *      0      |        0
+ *      1      |        1
+ *      2      |        2
+ *      0      |        3
+ *      ...
+ *      2      |        254
+ *      0      |        255
+ *      1      |        0
+ *
+ * A field that has not been read yet is never older than n_fields - 1
+ * measurements relative to another unread one, so the sub-meas indexes of
+ * the new fields lie within a window far smaller than 128. Their distance
+ * from the first new field, taken modulo 256 as a signed 8-bit value, orders
+ * them correctly wherever the overflow from 255 to 0 falls. This holds for
+ * any number of fields below 128, not only the 3 the sensor has. */
+static uint8_t order_fields(const uint8_t *buff, uint8_t n_fields, uint8_t *order)
 {
-    int16_t meas_index1;
-    int16_t meas_index2;
-
-    meas_index1 = (int16_t)field[low_index]->meas_index;
-    meas_index2 = (int16_t)field[high_index]->meas_index;
-    if ((field[low_index]->status & BME68X_NEW_DATA_MSK) && (field[high_index]->status & BME68X_NEW_DATA_MSK))
-    {
-        int16_t diff = meas_index2 - meas_index1;
-        if (((diff > -3) && (diff < 0)) || (diff > 2))
-        {
-            swap_fields(low_index, high_index, field);
-        }
-    }
-    else if (field[high_index]->status & BME68X_NEW_DATA_MSK)
-    {
-        swap_fields(low_index, high_index, field);
-    }
-
-    /* Sorting field data
-     *
-     * The 3 fields are filled in a fixed order with data in an incrementing
-     * 8-bit sub-measurement index which looks like
-     * Field index | Sub-meas index
-     *      0      |        0
-     *      1      |        1
-     *      2      |        2
-     *      0      |        3
-     *      1      |        4
-     *      2      |        5
-     *      ...
-     *      0      |        252
-     *      1      |        253
-     *      2      |        254
-     *      0      |        255
-     *      1      |        0
-     *      2      |        1
-     *
-     * The fields are sorted in a way so as to always deal with only a snapshot
-     * of comparing 2 fields at a time. The order being
-     * field0 & field1
-     * field0 & field2
-     * field1 & field2
-     * Here the oldest data should be in field0 while the newest is in field2.
-     * In the following documentation, field0's position would referred to as
-     * the lowest and field2 as the highest.
-     *
-     * In order to sort we have to consider the following cases,
-     *
-     * Case A: No fields have new data
-     *     Then do not sort, as this data has already been read.
-     *
-     * Case B: Higher field has new data
-     *     Then the new field get's the lowest position.
-     *
-     * Case C: Both fields have new data
-     *     We have to put the oldest sample in the lowest position. Since the
-     *     sub-meas index contains in essence the age of the sample, we calculate
-     *     the difference between the higher field and the lower field.
-     *     Here we have 3 sub-cases,
-     *     Case 1: Regular read without overwrite
-     *         Field index | Sub-meas index
-     *              0      |        3
-     *              1      |        4
-     *
-     *         Field index | Sub-meas index
-     *              0      |        3
-     *              2      |        5
-     *
-     *         The difference is always <= 2. There is no need to swap as the
-     *         oldest sample is already in the lowest position.
-     *
-     *     Case 2: Regular read with an overflow and without an overwrite
-     *         Field index | Sub-meas index
-     *              0      |        255
-     *              1      |        0
-     *
-     *         Field index | Sub-meas index
-     *              0      |        254
-     *              2      |        0
-     *
-     *         The difference is always <= -3. There is no need to swap as the
-     *         oldest sample is already in the lowest position.
-     *
-     *     Case 3: Regular read with overwrite
-     *         Field index | Sub-meas index
-     *              0      |        6
-     *              1      |        4
-     *
-     *         Field index | Sub-meas index
-     *              0      |        6
-     *              2      |        5
-     *
-     *         The difference is always > -3. There is a need to swap as the
-     *         oldest sample is not in the lowest position.
-     *
-     *     Case 4: Regular read with overwrite and overflow
-     *         Field index | Sub-meas index
-     *              0      |        0
-     *              1      |        254
-     *
-     *         Field index | Sub-meas index
-     *              0      |        0
-     *              2      |        255
-     *
-     *         The difference is always > 2. There is a need to swap as the
-     *         oldest sample is not in the lowest position.
-     *
-     * To summarize, we have to swap when
-     *     - The higher field has new data and the lower field does not.
-     *     - If both fields have new data, then the difference of sub-meas index
-     *         between the higher field and the lower field creates the
-     *         following condition for swapping.
-     *         - (diff > -3) && (diff < 0), combination of cases 1, 2, and 3.
-     *         - diff > 2, case 4.
-     *
-     *     Here the limits of -3 and 2 derive from the fact that there are 3 fields.
-     *     These values decrease or increase respectively if the number of fields increases.
-     */
+    uint8_t i, j;
+    uint8_t n_new = 0;
+    uint8_t ref = 0;
+    int8_t age;
+
+    for (i = 0; i < n_fields; i++)
+    {
+        if (buff[i * BME68X_LEN_FIELD] & BME68X_NEW_DATA_MSK)
+        {
+            if (n_new == 0)
+            {
+                ref = buff[(i * BME68X_LEN_FIELD) + 1];
+            }
+
+            /* Insertion sort on the signed distance from the reference */
+            age = (int8_t)(uint8_t)(buff[(i * BME68X_LEN_FIELD) + 1] - ref);
+            for (j = n_new; (j > 0) && ((int8_t)(uint8_t)(buff[(order[j - 1] * BME68X_LEN_FIELD) + 1] - ref) > age); j--)
+            {
+                order[j] = order[j - 1];
+            }
+
+            order[j] = i;
+            n_new++;
+        }
+    }
+
+    return n_new;
 }
 
-/* This internal API is used sort the sensor data */
-static void swap_fields(uint8_t index1, uint8_t index2, struct bme68x_data *field[])
+/* This internal API is used to configure and trigger the next self-test
+ * measurement. Step 0 checks the heater at the high temperature for
+ * BME68X_HEATR_DUR1, the rest alternate between the high and the low
+ * temperature for BME68X_HEATR_DUR2 */
+static int8_t selftest_trigger(struct bme68x_selftest *st, struct bme68x_dev *dev)
 {
-    struct bme68x_data *temp;
+    int8_t rslt;
+    struct bme68x_conf conf;
+    struct bme68x_heatr_conf heatr_conf = { 0 };
+
+    /* Set the temperature, pressure and humidity & filter settings */
+    conf.os_hum = BME68X_OS_1X;
+    conf.os_pres = BME68X_OS_16X;
+    conf.os_temp = BME68X_OS_2X;
+    conf.filter = BME68X_FILTER_OFF;
+    conf.odr = BME68X_ODR_NONE;
+
+    /* Set the remaining gas sensor settings and link the heating profile */
+    heatr_conf.enable = BME68X_ENABLE;
+    if (st->step == 0)
+    {
+        heatr_conf.heatr_dur = BME68X_HEATR_DUR1;
+        heatr_conf.heatr_temp = BME68X_HIGH_TEMP;
+    }
+    else
+    {
+        heatr_conf.heatr_dur = BME68X_HEATR_DUR2;
+        if ((st->step - 1) % 2 == 0)
+        {
+            heatr_conf.heatr_temp = BME68X_HIGH_TEMP; /* Higher temperature */
+        }
+        else
+        {
+            heatr_conf.heatr_temp = BME68X_LOW_TEMP; /* Lower temperature */
+        }
+    }
+
+    rslt = bme68x_set_heatr_conf(BME68X_FORCED_MODE, &heatr_conf, dev);
+    if (rslt == BME68X_OK)
+    {
+        rslt = bme68x_set_conf(&conf, dev);
+    }
+
+    if (rslt == BME68X_OK)
+    {
+        rslt = bme68x_set_op_mode(BME68X_FORCED_MODE, dev); /* Trigger a measurement */
+    }
+
+    /* The measurement completes after the TPH conversion and the heating, give
+     * the sensor's oscillator some margin on top */
+    st->wait_us = bme68x_get_meas_dur(BME68X_FORCED_MODE, &conf, dev) + ((uint32_t)heatr_conf.heatr_dur * 1000);
+    st->wait_us += BME68X_MEAS_MARGIN_US + ((st->wait_us / 1000) * BME68X_MEAS_MARGIN_PERMILLE);
+
+    return rslt;
+}
 
-    temp = field[index1];
-    field[index1] = field[index2];
-    field[index2] = temp;
+/* This internal API is used to end a self-test with its result */
+static void selftest_finish(struct bme68x_selftest *st, int8_t rslt)
+{
+    st->state = BME68X_SELFTEST_DONE;
+    st->rslt = rslt;
+    st->wait_us = 0;
 }
 
 /* This Function is to analyze the sensor data */
@@ -1833,6 +2474,9 @@ static int8_t get_calib_data(struct bme68x_dev *dev)
         dev->calib.res_heat_range = ((coeff_array[BME68X_IDX_RES_HEAT_RANGE] & BME68X_RHRANGE_MSK) / 16);
         dev->calib.res_heat_val = (int8_t)coeff_array[BME68X_IDX_RES_HEAT_VAL];
         dev->calib.range_sw_err = ((int8_t)(coeff_array[BME68X_IDX_RANGE_SW_ERR] & BME68X_RSERROR_MSK)) / 16;
+
+        /* Terms that only depend on the coefficients are worked out once here instead of for every sample */
+        calc_derived_calib(&dev->calib);
     }
 
     return rslt;
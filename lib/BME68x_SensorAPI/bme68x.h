@@ -102,6 +102,31 @@ int8_t bme68x_init(struct bme68x_dev *dev);
  */
 int8_t bme68x_set_regs(const uint8_t *reg_addr, const uint8_t *reg_data, uint32_t len, struct bme68x_dev *dev);
 
+/*!
+ * \ingroup bme68xApiRegister
+ * \page bme68x_api_bme68x_set_regs_range bme68x_set_regs_range
+ * \code
+ * int8_t bme68x_set_regs_range(uint8_t reg_addr, const uint8_t *reg_data, uint32_t len, struct bme68x_dev *dev)
+ * \endcode
+ * @details This API writes len bytes to the consecutive registers starting
+ * at reg_addr, with no limit on len. The sensor only auto-increments the
+ * register address on reads, a multi byte write has to carry the address
+ * of every register next to its data (I2C and SPI alike). The range is
+ * therefore sent as address/data pairs, BME68X_LEN_BURST_BUFF / 2 registers
+ * per transfer, and on SPI a transfer never crosses a memory page.
+ *
+ * @param[in] reg_addr : Address of the first register to be written
+ * @param[in] reg_data : Pointer to data buffer which is to be written
+ *                       to reg_addr onwards.
+ * @param[in] len      : No of bytes of data to write
+ * @param[in,out] dev  : Structure instance of bme68x_dev
+ *
+ * @return Result of API execution status
+ * @retval 0 -> Success
+ * @retval < 0 -> Fail
+ */
+int8_t bme68x_set_regs_range(uint8_t reg_addr, const uint8_t *reg_data, uint32_t len, struct bme68x_dev *dev);
+
 /*!
  * \ingroup bme68xApiRegister
  * \page bme68x_api_bme68x_get_regs bme68x_get_regs
@@ -121,6 +146,49 @@ int8_t bme68x_set_regs(const uint8_t *reg_addr, const uint8_t *reg_data, uint32_
  */
 int8_t bme68x_get_regs(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, struct bme68x_dev *dev);
 
+/*!
+ * \ingroup bme68xApiRegister
+ * \page bme68x_api_bme68x_enable_shadow bme68x_enable_shadow
+ * \code
+ * int8_t bme68x_enable_shadow(uint16_t check_period, struct bme68x_dev *dev)
+ * \endcode
+ * @details This API loads the control and heater registers, 0x50 to 0x75,
+ * into dev->shadow with one read. From then on every register write is also
+ * applied to the shadow, and reads inside that range are answered from it
+ * without a bus transfer. ctrl_meas is still read from the sensor while a
+ * forced measurement may be running, since the sensor returns to sleep by
+ * itself. A soft reset reloads the shadow; clearing dev->shadow_valid turns
+ * it off.
+ *
+ * @param[in] check_period : Reads served from the shadow after which it is
+ *                           compared with the sensor, 0 to never check.
+ * @param[in,out] dev      : Structure instance of bme68x_dev
+ *
+ * @return Result of API execution status
+ * @retval 0 -> Success
+ * @retval < 0 -> Fail
+ */
+int8_t bme68x_enable_shadow(uint16_t check_period, struct bme68x_dev *dev);
+
+/*!
+ * \ingroup bme68xApiRegister
+ * \page bme68x_api_bme68x_check_shadow bme68x_check_shadow
+ * \code
+ * int8_t bme68x_check_shadow(struct bme68x_dev *dev)
+ * \endcode
+ * @details This API reads the shadowed registers from the sensor, compares
+ * them with dev->shadow and reloads the shadow with what was read. It runs
+ * by itself every dev->shadow_check_period shadow reads.
+ *
+ * @param[in,out] dev : Structure instance of bme68x_dev
+ *
+ * @return Result of API execution status
+ * @retval 0 -> Success
+ * @retval > 0 -> BME68X_W_SHADOW_MISMATCH, the shadow was out of sync
+ * @retval < 0 -> Fail
+ */
+int8_t bme68x_check_shadow(struct bme68x_dev *dev);
+
 /**
  * \ingroup bme68x
  * \defgroup bme68xApiSystem System
@@ -214,6 +282,10 @@ uint32_t bme68x_get_meas_dur(const uint8_t op_mode, struct bme68x_conf *conf, st
  * from the sensor, compensates the data and store it in the bme68x_data
  * structure instance passed by the user.
  *
+ * In parallel and sequential mode only the new fields are decoded, directly
+ * into data[0 .. n_data - 1] in the order they were measured. data must hold
+ * BME68X_N_FIELDS instances; the ones past n_data are left untouched.
+ *
  * @param[in]  op_mode : Expected operation mode.
  * @param[out] data    : Structure instance to hold the data.
  * @param[out] n_data  : Number of data instances available.
@@ -225,6 +297,106 @@ uint32_t bme68x_get_meas_dur(const uint8_t op_mode, struct bme68x_conf *conf, st
  */
 int8_t bme68x_get_data(uint8_t op_mode, struct bme68x_data *data, uint8_t *n_data, struct bme68x_dev *dev);
 
+/*!
+ * \ingroup bme68xApiData
+ * \page bme68x_api_bme68x_get_raw_fields bme68x_get_raw_fields
+ * \code
+ * int8_t bme68x_get_raw_fields(uint8_t op_mode, struct bme68x_raw_data *raw, uint8_t *n_data, struct bme68x_dev *dev);
+ * \endcode
+ * @details This API reads the field registers in one transfer and copies the
+ * images of the new measurements to raw, oldest first, without compensating
+ * them. Decode them later with bme68x_decode_raw_fields.
+ *
+ * @param[in]  op_mode : Expected operation mode.
+ * @param[out] raw     : Field images, room for 3 in parallel and sequential mode.
+ * @param[out] n_data  : Number of new field images.
+ * @param[in,out] dev  : Structure instance of bme68x_dev
+ *
+ * @return Result of API execution status
+ * @retval 0 -> Success
+ * @retval < 0 -> Fail
+ */
+int8_t bme68x_get_raw_fields(uint8_t op_mode, struct bme68x_raw_data *raw, uint8_t *n_data, struct bme68x_dev *dev);
+
+/*!
+ * \ingroup bme68xApiData
+ * \page bme68x_api_bme68x_decode_raw_fields bme68x_decode_raw_fields
+ * \code
+ * int8_t bme68x_decode_raw_fields(const struct bme68x_raw_data *raw,
+ *                                 struct bme68x_data *data,
+ *                                 uint32_t n,
+ *                                 const struct bme68x_dev *dev);
+ * \endcode
+ * @details This API decodes n field images from bme68x_get_raw_fields and
+ * compensates them with the calibration held in dev, giving the same values
+ * bme68x_get_data would have. The sensor is not accessed, so stored images can
+ * be decoded at any time and again after a calibration change. idac, res_heat
+ * and gas_wait are taken from the shadow registers when enabled, else 0.
+ *
+ * @param[in]  raw  : Field images.
+ * @param[out] data : n decoded records.
+ * @param[in]  n    : Number of field images.
+ * @param[in]  dev  : Structure instance of bme68x_dev. calib.derived must be current
+ *
+ * @return Result of API execution status
+ * @retval 0 -> Success
+ * @retval < 0 -> Fail
+ */
+int8_t bme68x_decode_raw_fields(const struct bme68x_raw_data *raw,
+                                struct bme68x_data *data,
+                                uint32_t n,
+                                const struct bme68x_dev *dev);
+
+/*!
+ * \ingroup bme68xApiData
+ * \page bme68x_api_bme68x_compensate_batch bme68x_compensate_batch
+ * \code
+ * int8_t bme68x_compensate_batch(const struct bme68x_raw_batch *raw,
+ *                                const struct bme68x_comp_batch *comp,
+ *                                uint32_t n,
+ *                                const struct bme68x_dev *dev);
+ * \endcode
+ * @details This API compensates n raw temperature, pressure, humidity and gas
+ * readings with the calibration and variant held in dev, without accessing
+ * the sensor. t_fine is passed from the temperature to the pressure and
+ * humidity compensation explicitly, and each output is computed in its own
+ * loop, so dev is not modified and recorded raw data can be compensated
+ * again later, on the device or on a host.
+ *
+ * @param[in]  raw  : Arrays of n raw ADC values.
+ * @param[out] comp : Arrays receiving n compensated values.
+ * @param[in]  n    : Number of samples.
+ * @param[in]  dev  : Structure instance of bme68x_dev, only calib and variant_id are used.
+ *                    calib.derived must be current, see bme68x_derive_calib
+ *
+ * @return Result of API execution status
+ * @retval 0 -> Success
+ * @retval < 0 -> Fail
+ */
+int8_t bme68x_compensate_batch(const struct bme68x_raw_batch *raw,
+                               const struct bme68x_comp_batch *comp,
+                               uint32_t n,
+                               const struct bme68x_dev *dev);
+
+/*!
+ * \ingroup bme68xApiData
+ * \page bme68x_api_bme68x_derive_calib bme68x_derive_calib
+ * \code
+ * int8_t bme68x_derive_calib(struct bme68x_dev *dev);
+ * \endcode
+ * @details This API recalculates dev->calib.derived, the compensation terms
+ * that only depend on the calibration coefficients. bme68x_init does this
+ * when it reads the coefficients from the sensor; call it after filling
+ * dev->calib by other means, e.g. from a stored copy on a host.
+ *
+ * @param[in,out] dev : Structure instance of bme68x_dev
+ *
+ * @return Result of API execution status
+ * @retval 0 -> Success
+ * @retval < 0 -> Fail
+ */
+int8_t bme68x_derive_calib(struct bme68x_dev *dev);
+
 /**
  * \ingroup bme68x
  * \defgroup bme68xApiConfig Configuration
@@ -284,6 +456,54 @@ int8_t bme68x_get_conf(struct bme68x_conf *conf, struct bme68x_dev *dev);
  */
 int8_t bme68x_set_heatr_conf(uint8_t op_mode, const struct bme68x_heatr_conf *conf, struct bme68x_dev *dev);
 
+/*!
+ * \ingroup bme68xApiConfig
+ * \page bme68x_api_bme68x_compile_heatr_conf bme68x_compile_heatr_conf
+ * \code
+ * int8_t bme68x_compile_heatr_conf(uint8_t op_mode,
+ *                                  const struct bme68x_heatr_conf *conf,
+ *                                  struct bme68x_heatr_image *image,
+ *                                  const struct bme68x_dev *dev);
+ * \endcode
+ * @details This API calculates the heater register values for a gas
+ * configuration without accessing the sensor. res_heat_x depends on the
+ * calibration and on dev->amb_temp, so an image only needs to be compiled
+ * again when the ambient temperature has changed noticeably. Compiled images
+ * are applied with bme68x_set_heatr_image.
+ *
+ * @param[in] op_mode : Operation mode the image is compiled for.
+ * @param[in] conf    : Desired heating configuration.
+ * @param[out] image  : Register values of the configuration.
+ * @param[in] dev     : Structure instance of bme68x_dev.
+ *
+ * @return Result of API execution status
+ * @retval 0 -> Success
+ * @retval < 0 -> Fail
+ */
+int8_t bme68x_compile_heatr_conf(uint8_t op_mode,
+                                 const struct bme68x_heatr_conf *conf,
+                                 struct bme68x_heatr_image *image,
+                                 const struct bme68x_dev *dev);
+
+/*!
+ * \ingroup bme68xApiConfig
+ * \page bme68x_api_bme68x_set_heatr_image bme68x_set_heatr_image
+ * \code
+ * int8_t bme68x_set_heatr_image(const struct bme68x_heatr_image *image, struct bme68x_dev *dev);
+ * \endcode
+ * @details This API puts the sensor to sleep and writes a compiled heater
+ * configuration. Apart from one read of ctrl_gas_0 and ctrl_gas_1 all heater
+ * registers are written in a single interleaved transfer.
+ *
+ * @param[in] image   : Heater image from bme68x_compile_heatr_conf.
+ * @param[in,out] dev : Structure instance of bme68x_dev.
+ *
+ * @return Result of API execution status
+ * @retval 0 -> Success
+ * @retval < 0 -> Fail
+ */
+int8_t bme68x_set_heatr_image(const struct bme68x_heatr_image *image, struct bme68x_dev *dev);
+
 /*!
  * \ingroup bme68xApiConfig
  * \page bme68x_api_bme68x_get_heatr_conf bme68x_get_heatr_conf
@@ -317,6 +537,56 @@ int8_t bme68x_get_heatr_conf(const struct bme68x_heatr_conf *conf, struct bme68x
  */
 int8_t bme68x_selftest_check(const struct bme68x_dev *dev);
 
+/*!
+ * \ingroup bme68xApiSystem
+ * \page bme68x_api_bme68x_selftest_start bme68x_selftest_start
+ * \code
+ * int8_t bme68x_selftest_start(struct bme68x_selftest *st, struct bme68x_dev *dev);
+ * \endcode
+ * @details This API starts the self-test of bme68x_selftest_check on an
+ * initialized device without blocking. It triggers the first forced mode
+ * measurement and returns; call bme68x_selftest_step once st->wait_us has
+ * passed, until st->state is BME68X_SELFTEST_DONE. The device is neither
+ * reset nor copied, so its sensor and heater settings must be restored once
+ * the test is done.
+ *
+ * @param[out] st     : Self-test progress.
+ * @param[in,out] dev : Structure instance of bme68x_dev.
+ *
+ * @return Result of API execution status
+ * @retval 0 -> Success
+ * @retval < 0 -> Fail
+ */
+int8_t bme68x_selftest_start(struct bme68x_selftest *st, struct bme68x_dev *dev);
+
+/*!
+ * \ingroup bme68xApiSystem
+ * \page bme68x_api_bme68x_selftest_step bme68x_selftest_step
+ * \code
+ * int8_t bme68x_selftest_step(struct bme68x_selftest *st, struct bme68x_data *data, uint8_t *n_data, struct bme68x_dev *dev);
+ * \endcode
+ * @details This API advances a self-test by one measurement. It reads the
+ * measurement that st->wait_us was waiting for and triggers the next one, or
+ * analyzes all of them after the last. It never delays: if the measurement is
+ * not ready yet, it asks for another BME68X_PERIOD_POLL in st->wait_us, up to
+ * BME68X_SELFTEST_READ_TRIES times. The outcome is in st->rslt once st->state is
+ * BME68X_SELFTEST_DONE.
+ *
+ * @param[in,out] st  : Self-test progress.
+ * @param[out] data   : Measurement read by this step, can be NULL.
+ * @param[out] n_data : 1 if a measurement was read, else 0.
+ * @param[in,out] dev : Structure instance of bme68x_dev.
+ *
+ * @return Result of API execution status
+ * @retval 0 -> Success
+ * @retval > 0 -> Warning, BME68X_W_NO_NEW_DATA while waiting on a measurement
+ * @retval < 0 -> Fail
+ */
+int8_t bme68x_selftest_step(struct bme68x_selftest *st,
+                            struct bme68x_data *data,
+                            uint8_t *n_data,
+                            struct bme68x_dev *dev);
+
 #ifdef __cplusplus
 }
 #endif /* End of CPP guard */
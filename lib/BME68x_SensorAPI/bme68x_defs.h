@@ -97,6 +97,38 @@
 #define BME68X_PERIOD_POLL                        UINT32_C(10000)
 #endif
 
+/* Reads of a forced mode field before bme68x_get_data gives up on new data, BME68X_PERIOD_POLL apart. 1 reads
+ * once without waiting, for callers that already waited out the measurement (value can be given by user) */
+#ifndef BME68X_FIELD_READ_TRIES
+#define BME68X_FIELD_READ_TRIES                   UINT8_C(5)
+#endif
+
+/* Reads of a self-test measurement before bme68x_selftest_step gives up on it, BME68X_PERIOD_POLL apart
+ * (value can be given by user) */
+#ifndef BME68X_SELFTEST_READ_TRIES
+#define BME68X_SELFTEST_READ_TRIES                UINT8_C(5)
+#endif
+
+/* Margin added to the duration of a measurement before it is expected to be ready, for the tolerance of the
+ * sensor's oscillator: a fixed part plus a part per mille of the duration (value can be given by user) */
+#ifndef BME68X_MEAS_MARGIN_US
+#define BME68X_MEAS_MARGIN_US                     UINT32_C(1000)
+#endif
+
+#ifndef BME68X_MEAS_MARGIN_PERMILLE
+#define BME68X_MEAS_MARGIN_PERMILLE               UINT32_C(20)
+#endif
+
+/* Number of samples bme68x_compensate_batch keeps intermediate t_fine values for on the stack (value can be given by user) */
+#ifndef BME68X_BATCH_CHUNK
+#define BME68X_BATCH_CHUNK                        UINT32_C(8)
+#endif
+
+/* Bytes of register address and data pairs sent per write transfer, room for a whole heater image by default (value can be given by user) */
+#ifndef BME68X_LEN_BURST_BUFF
+#define BME68X_LEN_BURST_BUFF                     UINT8_C(46)
+#endif
+
 /* BME68X unique chip identifier */
 #define BME68X_CHIP_ID                            UINT8_C(0x61)
 
@@ -142,6 +174,9 @@
 /* Define the shared heating duration */
 #define BME68X_W_DEFINE_SHD_HEATR_DUR             INT8_C(3)
 
+/* The shadow registers differed from the sensor and were reloaded */
+#define BME68X_W_SHADOW_MISMATCH                  INT8_C(4)
+
 /* Information - only available via bme68x_dev.info_msg */
 #define BME68X_I_PARAM_CORR                       UINT8_C(1)
 
@@ -333,12 +368,24 @@
 /* Length between two fields */
 #define BME68X_LEN_FIELD_OFFSET                   UINT8_C(17)
 
+/* Number of field register sets, filled round robin in parallel and sequential mode */
+#define BME68X_N_FIELDS                           UINT8_C(3)
+
 /* Length of the configuration register */
 #define BME68X_LEN_CONFIG                         UINT8_C(5)
 
 /* Length of the interleaved buffer */
 #define BME68X_LEN_INTERLEAVE_BUFF                UINT8_C(20)
 
+/* Maximum number of steps in a heater profile */
+#define BME68X_LEN_HEATR_PROF                     UINT8_C(10)
+
+/* Registers of a heater image: res_heat_x, gas_wait_x, shd_heatr_dur, ctrl_gas_0 and ctrl_gas_1 */
+#define BME68X_LEN_HEATR_IMAGE_REGS               UINT8_C(23)
+
+/* Length of the shadow registers, BME68X_REG_IDAC_HEAT0(0x50) up to BME68X_REG_CONFIG(0x75) */
+#define BME68X_LEN_SHADOW                         UINT8_C(38)
+
 /* Coefficient index macros */
 
 /* Coefficient T2 LSB position */
@@ -520,6 +567,14 @@
 #define BME68X_LOW_TEMP                           UINT8_C(150)
 #define BME68X_HIGH_TEMP                          UINT16_C(350)
 
+/* Measurements of a self-test: the heater check, then BME68X_N_MEAS alternating high and low temperature ones */
+#define BME68X_SELFTEST_STEPS                     UINT8_C(7)
+
+/* Self-test states */
+#define BME68X_SELFTEST_IDLE                      UINT8_C(0)
+#define BME68X_SELFTEST_RUNNING                   UINT8_C(1)
+#define BME68X_SELFTEST_DONE                      UINT8_C(2)
+
 /* Mask macros */
 /* Mask for number of conversions */
 #define BME68X_NBCONV_MSK                         UINT8_C(0X0f)
@@ -765,6 +820,186 @@ struct bme68x_data
 
 };
 
+/*
+ * @brief Structure of arrays holding raw ADC values, one entry per sample
+ */
+struct bme68x_raw_batch
+{
+    /*! Raw 20 bit temperature ADC values */
+    const uint32_t *temp_adc;
+
+    /*! Raw 20 bit pressure ADC values */
+    const uint32_t *pres_adc;
+
+    /*! Raw 16 bit humidity ADC values */
+    const uint16_t *hum_adc;
+
+    /*! Raw 10 bit gas resistance ADC values, from the gas channel of the device variant */
+    const uint16_t *gas_adc;
+
+    /*! Gas range of each gas resistance ADC value */
+    const uint8_t *gas_range;
+};
+
+/*
+ * @brief Field registers of one measurement, as read from the sensor
+ */
+struct bme68x_raw_data
+{
+    /*! Field register image, starting at the status byte */
+    uint8_t field[BME68X_LEN_FIELD];
+};
+
+/*
+ * @brief Progress of a self-test run one measurement at a time
+ */
+struct bme68x_selftest
+{
+    /*! BME68X_SELFTEST_IDLE, BME68X_SELFTEST_RUNNING or BME68X_SELFTEST_DONE */
+    uint8_t state;
+
+    /*! Measurements completed, out of BME68X_SELFTEST_STEPS */
+    uint8_t step;
+
+    /*! Reads of the current measurement that found no new data */
+    uint8_t tries;
+
+    /*! Result once done, BME68X_OK if the sensor passed */
+    int8_t rslt;
+
+    /*! Time to wait before the next call to bme68x_selftest_step, in us, BME68X_MEAS_MARGIN_US included */
+    uint32_t wait_us;
+
+    /*! Alternating high and low temperature measurements analyzed at the end */
+    struct bme68x_data data[BME68X_N_MEAS];
+};
+
+/*
+ * @brief Structure of arrays receiving compensated values, in the units of bme68x_data
+ */
+struct bme68x_comp_batch
+{
+#ifndef BME68X_USE_FPU
+
+    /*! Temperature in degree celsius x100 */
+    int16_t *temperature;
+
+    /*! Pressure in Pascal */
+    uint32_t *pressure;
+
+    /*! Humidity in % relative humidity x1000 */
+    uint32_t *humidity;
+
+    /*! Gas resistance in Ohms */
+    uint32_t *gas_resistance;
+#else
+
+    /*! Temperature in degree celsius */
+    float *temperature;
+
+    /*! Pressure in Pascal */
+    float *pressure;
+
+    /*! Humidity in % relative humidity */
+    float *humidity;
+
+    /*! Gas resistance in Ohms */
+    float *gas_resistance;
+#endif
+};
+
+/*
+ * @brief Structure to hold the terms of the compensation that only depend on
+ * the calibration coefficients, calculated once when they are read
+ */
+struct bme68x_calib_derived
+{
+#ifndef BME68X_USE_FPU
+
+    /*! par_t1 << 1 */
+    int32_t t1_x2;
+
+    /*! par_t3 << 4 */
+    int32_t t3_x16;
+
+    /*! par_p3 << 5 */
+    int32_t p3_x32;
+
+    /*! par_p4 << 16 */
+    int32_t p4_x65536;
+
+    /*! par_p7 << 7 */
+    int32_t p7_x128;
+
+    /*! par_h1 * 16 */
+    int32_t h1_x16;
+
+    /*! par_h6 << 7 */
+    int32_t h6_x128;
+
+    /*! Range switching error scaled by the first gas lookup table, per gas range */
+    int64_t gas_var1[16];
+
+    /*! gas_var1 scaled by the second gas lookup table, per gas range */
+    int64_t gas_var3[16];
+#else
+
+    /*! par_t1 / 1024 */
+    float t1_div1024;
+
+    /*! par_t1 / 8192 */
+    float t1_div8192;
+
+    /*! par_t3 * 16 */
+    float t3_x16;
+
+    /*! par_p4 * 65536 */
+    float p4_x65536;
+
+    /*! par_p5 * 2 */
+    float p5_x2;
+
+    /*! par_p6 / 131072 */
+    float p6_div131072;
+
+    /*! par_p7 * 128 */
+    float p7_x128;
+
+    /*! par_p8 / 32768 */
+    float p8_div32768;
+
+    /*! par_p10 / 131072 */
+    float p10_div131072;
+
+    /*! par_h1 * 16 */
+    float h1_x16;
+
+    /*! par_h2 / 262144 */
+    float h2_div262144;
+
+    /*! par_h3 / 2 */
+    float h3_div2;
+
+    /*! par_h4 / 16384 */
+    float h4_div16384;
+
+    /*! par_h5 / 1048576 */
+    float h5_div1048576;
+
+    /*! par_h6 / 16384 */
+    float h6_div16384;
+
+    /*! par_h7 / 2097152 */
+    float h7_div2097152;
+
+    /*! Range switching error corrected divisor of the gas ADC value, per gas range */
+    float gas_var2[16];
+
+    /*! Range dependent scale of the gas conductance, per gas range */
+    float gas_scale[16];
+#endif
+};
+
 /*
  * @brief Structure to hold the calibration coefficients
  */
@@ -856,6 +1091,9 @@ struct bme68x_calib_data
 
     /*! Gas resistance range switching error coefficient */
     int8_t range_sw_err;
+
+    /*! Terms derived from the coefficients above, see bme68x_derive_calib */
+    struct bme68x_calib_derived derived;
 };
 
 /*
@@ -913,6 +1151,39 @@ struct bme68x_heatr_conf
     uint16_t shared_heatr_dur;
 };
 
+/*
+ * @brief BME68X gas heater configuration compiled to register values
+ */
+struct bme68x_heatr_image
+{
+    /*! Operation mode the image was compiled for */
+    uint8_t op_mode;
+
+    /*! Number of res_heat_x and gas_wait_x registers in use */
+    uint8_t len;
+
+    /*! Heater control field of ctrl_gas_0 */
+    uint8_t hctrl;
+
+    /*! Number of heater steps field of ctrl_gas_1 */
+    uint8_t nb_conv;
+
+    /*! Gas measurement enable field of ctrl_gas_1 */
+    uint8_t run_gas;
+
+    /*! res_heat_x register values */
+    uint8_t res_heat[BME68X_LEN_HEATR_PROF];
+
+    /*! gas_wait_x register values */
+    uint8_t gas_wait[BME68X_LEN_HEATR_PROF];
+
+    /*! shd_heatr_dur register value, written in parallel mode only */
+    uint8_t shared_heatr_dur;
+
+    /*! Ambient temperature res_heat was calculated for in degree Celsius */
+    int8_t amb_temp;
+};
+
 /*
  * @brief BME68X device structure
  */
@@ -966,6 +1237,21 @@ struct bme68x_dev
 
     /*! Store the info messages */
     uint8_t info_msg;
+
+    /*! Write-through copy of the control and heater registers from BME68X_REG_IDAC_HEAT0 on */
+    uint8_t shadow[BME68X_LEN_SHADOW];
+
+    /*! Shadow registers loaded and used to serve reads. Refer bme68x_enable_shadow */
+    uint8_t shadow_valid;
+
+    /*! Reads served from the shadow between checks against the sensor, 0 to never check */
+    uint16_t shadow_check_period;
+
+    /*! Reads served from the shadow since the last check */
+    uint16_t shadow_reads;
+
+    /*! Checks that found the shadow out of sync with the sensor */
+    uint16_t shadow_mismatches;
 };
 
 #endif /* BME68X_DEFS_H_ */
@@ -0,0 +1,612 @@
+#include "bme68x_sim.h"
+#include <string.h>
+
+/* Register layout, as read by bme68x.c */
+#define SIM_REG_CTRL_GAS_0      0x70
+#define SIM_REG_CTRL_GAS_1      0x71
+#define SIM_REG_CTRL_HUM        0x72
+#define SIM_REG_CTRL_MEAS       0x74
+#define SIM_REG_CONFIG          0x75
+#define SIM_FIELD_STATUS_MEASURING  0x20
+#define SIM_FIELD_STATUS_GAS_MEASURING  0x40
+
+/**
+ * @brief Calibration of a typical part. Gives sane readings over the whole operating range
+ *
+ */
+const struct bme68x_sim_calib bme68x_sim_default_calib = {
+    .par_t1 = 26115, .par_t2 = 26366, .par_t3 = 3,
+    .par_p1 = 36476, .par_p2 = -10439, .par_p3 = 88, .par_p4 = 6873, .par_p5 = -96, .par_p6 = 30,
+    .par_p7 = 34, .par_p8 = -1024, .par_p9 = -3276, .par_p10 = 30,
+    .par_h1 = 785, .par_h2 = 1010, .par_h3 = 0, .par_h4 = 45, .par_h5 = 20, .par_h6 = 120, .par_h7 = -100,
+    .par_gh1 = -31, .par_gh2 = -12410, .par_gh3 = 18,
+    .res_heat_range = 1, .res_heat_val = 40, .range_sw_err = 0
+};
+
+static const uint8_t os_to_meas_cycles[8] = { 0, 1, 2, 4, 8, 16, 16, 16 };
+static const uint32_t odr_standby_us[8] = { 590, 62500, 125000, 250000, 500000, 1000000, 10000, 20000 };
+static const double gas_k1_range[16] = { 0, 0, 0, 0, 0, -1.0, 0, -0.8, 0, 0, -0.2, -0.5, 0, -1.0, 0, 0 };
+static const double gas_k2_range[16] = { 0, 0, 0, 0, 0.1, 0.7, 0, -0.8, -0.1, 0, 0, 0, 0, 0, 0, 0 };
+
+
+/**
+ * @brief Register holding byte i of the driver's 42 byte coefficient array
+ *
+ */
+static uint8_t coeff_reg(uint8_t i)
+{
+    if(i < BME68X_LEN_COEFF1)
+    {
+        return BME68X_REG_COEFF1 + i;
+    }
+    if(i < (BME68X_LEN_COEFF1 + BME68X_LEN_COEFF2))
+    {
+        return BME68X_REG_COEFF2 + (i - BME68X_LEN_COEFF1);
+    }
+    return BME68X_REG_COEFF3 + (i - BME68X_LEN_COEFF1 - BME68X_LEN_COEFF2);
+}
+
+static void put_coeff(struct bme68x_sim* sim, uint8_t i, uint8_t val)
+{
+    sim->regs[coeff_reg(i)] = val;
+}
+
+static void put_coeff16(struct bme68x_sim* sim, uint8_t lsb, uint8_t msb, uint16_t val)
+{
+    put_coeff(sim, lsb, (uint8_t)(val & 0xFF));
+    put_coeff(sim, msb, (uint8_t)(val >> 8));
+}
+
+/**
+ * @brief Load the non volatile part of the register file: identity and calibration
+ *
+ */
+static void load_nvm(struct bme68x_sim* sim, uint8_t variant_id)
+{
+    const struct bme68x_sim_calib* c = &sim->calib;
+
+    sim->regs[BME68X_REG_CHIP_ID] = BME68X_CHIP_ID;
+    sim->regs[BME68X_REG_VARIANT_ID] = variant_id;
+
+    put_coeff16(sim, BME68X_IDX_T1_LSB, BME68X_IDX_T1_MSB, c->par_t1);
+    put_coeff16(sim, BME68X_IDX_T2_LSB, BME68X_IDX_T2_MSB, (uint16_t)c->par_t2);
+    put_coeff(sim, BME68X_IDX_T3, (uint8_t)c->par_t3);
+    put_coeff16(sim, BME68X_IDX_P1_LSB, BME68X_IDX_P1_MSB, c->par_p1);
+    put_coeff16(sim, BME68X_IDX_P2_LSB, BME68X_IDX_P2_MSB, (uint16_t)c->par_p2);
+    put_coeff(sim, BME68X_IDX_P3, (uint8_t)c->par_p3);
+    put_coeff16(sim, BME68X_IDX_P4_LSB, BME68X_IDX_P4_MSB, (uint16_t)c->par_p4);
+    put_coeff16(sim, BME68X_IDX_P5_LSB, BME68X_IDX_P5_MSB, (uint16_t)c->par_p5);
+    put_coeff(sim, BME68X_IDX_P6, (uint8_t)c->par_p6);
+    put_coeff(sim, BME68X_IDX_P7, (uint8_t)c->par_p7);
+    put_coeff16(sim, BME68X_IDX_P8_LSB, BME68X_IDX_P8_MSB, (uint16_t)c->par_p8);
+    put_coeff16(sim, BME68X_IDX_P9_LSB, BME68X_IDX_P9_MSB, (uint16_t)c->par_p9);
+    put_coeff(sim, BME68X_IDX_P10, c->par_p10);
+    /* H1 and H2 share the nibbles of one register */
+    put_coeff(sim, BME68X_IDX_H1_MSB, (uint8_t)(c->par_h1 >> 4));
+    put_coeff(sim, BME68X_IDX_H2_MSB, (uint8_t)(c->par_h2 >> 4));
+    put_coeff(sim, BME68X_IDX_H1_LSB, (uint8_t)(((c->par_h2 & 0x0F) << 4) | (c->par_h1 & BME68X_BIT_H1_DATA_MSK)));
+    put_coeff(sim, BME68X_IDX_H3, (uint8_t)c->par_h3);
+    put_coeff(sim, BME68X_IDX_H4, (uint8_t)c->par_h4);
+    put_coeff(sim, BME68X_IDX_H5, (uint8_t)c->par_h5);
+    put_coeff(sim, BME68X_IDX_H6, c->par_h6);
+    put_coeff(sim, BME68X_IDX_H7, (uint8_t)c->par_h7);
+    put_coeff(sim, BME68X_IDX_GH1, (uint8_t)c->par_gh1);
+    put_coeff16(sim, BME68X_IDX_GH2_LSB, BME68X_IDX_GH2_MSB, (uint16_t)c->par_gh2);
+    put_coeff(sim, BME68X_IDX_GH3, (uint8_t)c->par_gh3);
+    put_coeff(sim, BME68X_IDX_RES_HEAT_VAL, (uint8_t)c->res_heat_val);
+    put_coeff(sim, BME68X_IDX_RES_HEAT_RANGE, (uint8_t)((c->res_heat_range << 4) & BME68X_RHRANGE_MSK));
+    put_coeff(sim, BME68X_IDX_RANGE_SW_ERR, (uint8_t)(((uint8_t)c->range_sw_err << 4) & BME68X_RSERROR_MSK));
+}
+
+/**
+ * @brief Power on / soft reset state: volatile registers cleared, sensor asleep
+ *
+ */
+static void reset(struct bme68x_sim* sim)
+{
+    uint8_t variant_id = sim->regs[BME68X_REG_VARIANT_ID];
+
+    memset(sim->regs, 0, sizeof(sim->regs));
+    load_nvm(sim, variant_id);
+    sim->mode = BME68X_SLEEP_MODE;
+    sim->gas_index = 0;
+    sim->meas_index = 0;
+    sim->next_field = 0;
+}
+
+/* ---------------------------------------------------------------------------------------------------------------- */
+/*                                    Forward compensation, datasheet float formulas                                  */
+/* ---------------------------------------------------------------------------------------------------------------- */
+
+static double comp_temperature(const struct bme68x_sim_calib* c, uint32_t adc, double* t_fine)
+{
+    double var1 = (((double)adc / 16384.0) - ((double)c->par_t1 / 1024.0)) * (double)c->par_t2;
+    double var2 = ((double)adc / 131072.0) - ((double)c->par_t1 / 8192.0);
+
+    var2 = var2 * var2 * ((double)c->par_t3 * 16.0);
+    *t_fine = var1 + var2;
+    return *t_fine / 5120.0;
+}
+
+static double comp_pressure(const struct bme68x_sim_calib* c, uint32_t adc, double t_fine)
+{
+    double var1 = (t_fine / 2.0) - 64000.0;
+    double var2 = var1 * var1 * ((double)c->par_p6 / 131072.0);
+    double var3;
+    double pres;
+
+    var2 = var2 + (var1 * (double)c->par_p5 * 2.0);
+    var2 = (var2 / 4.0) + ((double)c->par_p4 * 65536.0);
+    var1 = ((((double)c->par_p3 * var1 * var1) / 16384.0) + ((double)c->par_p2 * var1)) / 524288.0;
+    var1 = (1.0 + (var1 / 32768.0)) * (double)c->par_p1;
+    pres = 1048576.0 - (double)adc;
+    pres = ((pres - (var2 / 4096.0)) * 6250.0) / var1;
+    var1 = ((double)c->par_p9 * pres * pres) / 2147483648.0;
+    var2 = pres * ((double)c->par_p8 / 32768.0);
+    var3 = (pres / 256.0) * (pres / 256.0) * (pres / 256.0) * ((double)c->par_p10 / 131072.0);
+    return pres + ((var1 + var2 + var3 + ((double)c->par_p7 * 128.0)) / 16.0);
+}
+
+static double comp_humidity(const struct bme68x_sim_calib* c, uint32_t adc, double temperature)
+{
+    double var1 = (double)adc - (((double)c->par_h1 * 16.0) + (((double)c->par_h3 / 2.0) * temperature));
+    double var2 = var1 * (((double)c->par_h2 / 262144.0) *
+                          (1.0 + (((double)c->par_h4 / 16384.0) * temperature) +
+                           (((double)c->par_h5 / 1048576.0) * temperature * temperature)));
+    double var3 = (double)c->par_h6 / 16384.0;
+    double var4 = (double)c->par_h7 / 2097152.0;
+
+    return var2 + ((var3 + (var4 * temperature)) * var2 * var2);
+}
+
+/* ---------------------------------------------------------------------------------------------------------------- */
+/*                                  Inverse compensation: environment to raw ADC words                                */
+/* ---------------------------------------------------------------------------------------------------------------- */
+
+/**
+ * @brief Smallest 20 bit temperature ADC word that reads at or above the wanted temperature
+ *
+ */
+static uint32_t temperature_adc(const struct bme68x_sim_calib* c, double temperature)
+{
+    uint32_t low = 0, high = (1UL << 20) - 1;
+    double t_fine;
+
+    while(low < high)
+    {
+        uint32_t mid = low + ((high - low) / 2);
+        if(comp_temperature(c, mid, &t_fine) < temperature)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/**
+ * @brief Smallest 20 bit pressure ADC word that reads at or below the wanted pressure. Pressure falls as the word rises
+ *
+ */
+static uint32_t pressure_adc(const struct bme68x_sim_calib* c, double pressure, double t_fine)
+{
+    uint32_t low = 0, high = (1UL << 20) - 1;
+
+    while(low < high)
+    {
+        uint32_t mid = low + ((high - low) / 2);
+        if(comp_pressure(c, mid, t_fine) > pressure)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/**
+ * @brief Smallest 16 bit humidity ADC word that reads at or above the wanted humidity
+ *
+ */
+static uint32_t humidity_adc(const struct bme68x_sim_calib* c, double humidity, double temperature)
+{
+    uint32_t low = 0, high = 0xFFFF;
+
+    while(low < high)
+    {
+        uint32_t mid = low + ((high - low) / 2);
+        if(comp_humidity(c, mid, temperature) < humidity)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/**
+ * @brief 10 bit gas ADC word and range that read as the wanted resistance. Picks the range that puts the word closest to mid scale
+ *
+ * @details Resistances outside what the part can measure are clamped to the nearest end of the scale.
+ */
+static void gas_adc(const struct bme68x_sim* sim, double resistance, uint16_t* adc, uint8_t* range)
+{
+    double best_dist = 1e9;
+
+    *adc = 512;
+    *range = 0;
+    if(resistance <= 0)
+    {
+        return;
+    }
+
+    for(uint8_t r = 0; r < 16; r++)
+    {
+        double word;
+        if(sim->regs[BME68X_REG_VARIANT_ID] == BME68X_VARIANT_GAS_HIGH)
+        {
+            word = 512.0 + (((1000000.0 * (double)(262144UL >> r)) / resistance) - 4096.0) / 3.0;
+        }
+        else
+        {
+            double var1 = 1340.0 + (5.0 * sim->calib.range_sw_err);
+            double var2 = var1 * (1.0 + (gas_k1_range[r] / 100.0));
+            double var3 = 1.0 + (gas_k2_range[r] / 100.0);
+            word = 512.0 + (var2 * ((1.0 / (resistance * var3 * 0.000000125 * (double)(1UL << r))) - 1.0));
+        }
+
+        double dist = (word > 512.0) ? (word - 512.0) : (512.0 - word);
+        if((word >= 0.0) && (word <= 1023.0) && (dist < best_dist))
+        {
+            best_dist = dist;
+            *adc = (uint16_t)(word + 0.5);
+            *range = r;
+        }
+    }
+    if(best_dist > 511.5)
+    {
+        // Out of range. Low resistances read at the top of the highest range, high ones at the bottom of the lowest
+        uint8_t too_low = (resistance < 1000.0);
+        *adc = too_low ? 1023 : 0;
+        *range = too_low ? 15 : 0;
+    }
+}
+
+/* ---------------------------------------------------------------------------------------------------------------- */
+/*                                              Measurement scheduling                                              */
+/* ---------------------------------------------------------------------------------------------------------------- */
+
+static uint8_t nb_conv(const struct bme68x_sim* sim)
+{
+    return sim->regs[SIM_REG_CTRL_GAS_1] & BME68X_NBCONV_MSK;
+}
+
+static uint8_t gas_enabled(const struct bme68x_sim* sim)
+{
+    return ((sim->regs[SIM_REG_CTRL_GAS_1] & BME68X_RUN_GAS_MSK) != 0) && ((sim->regs[SIM_REG_CTRL_GAS_0] & BME68X_HCTRL_MSK) == 0);
+}
+
+/**
+ * @brief Heater on time encoded in a gas_wait register: 6 bit value times a 1, 4, 16 or 64 multiplier, in ms
+ *
+ */
+static uint32_t gas_wait_us(uint8_t reg)
+{
+    return (uint32_t)(reg & 0x3F) * (1UL << (2 * (reg >> 6))) * 1000;
+}
+
+/**
+ * @brief Time the part takes to produce one field at heater step gas_index in the configured mode
+ *
+ * @param sim
+ * @param gas_index
+ * @return uint32_t us
+ */
+uint32_t bme68x_sim_meas_dur_us(const struct bme68x_sim* sim, uint8_t gas_index)
+{
+    uint8_t mode = sim->regs[SIM_REG_CTRL_MEAS] & BME68X_MODE_MSK;
+    uint8_t os_t = (sim->regs[SIM_REG_CTRL_MEAS] & BME68X_OST_MSK) >> BME68X_OST_POS;
+    uint8_t os_p = (sim->regs[SIM_REG_CTRL_MEAS] & BME68X_OSP_MSK) >> BME68X_OSP_POS;
+    uint8_t os_h = sim->regs[SIM_REG_CTRL_HUM] & BME68X_OSH_MSK;
+    uint32_t dur_us;
+
+    if(mode == BME68X_SLEEP_MODE)
+    {
+        mode = sim->mode;
+    }
+
+    dur_us = (os_to_meas_cycles[os_t] + os_to_meas_cycles[os_p] + os_to_meas_cycles[os_h]) * 1963UL;
+    dur_us += 477UL * 4;    // TPH switching
+    dur_us += 477UL * 5;    // gas conversion
+    if(mode != BME68X_PARALLEL_MODE)
+    {
+        dur_us += 1000;     // wake up
+    }
+
+    if(gas_enabled(sim))
+    {
+        uint8_t gas_wait = sim->regs[BME68X_REG_GAS_WAIT0 + (gas_index % 10)];
+        if(mode == BME68X_PARALLEL_MODE)
+        {
+            // gas_wait is a multiple of the shared heater duration, in 0.477 ms steps
+            uint8_t shd = sim->regs[BME68X_REG_SHD_HEATR_DUR];
+            uint32_t shared_us = (uint32_t)(shd & 0x3F) * (1UL << (2 * (shd >> 6))) * 477;
+            uint32_t cycles = (gas_wait > 0) ? gas_wait : 1;
+            dur_us = cycles * (dur_us + shared_us);
+        }
+        else
+        {
+            dur_us += gas_wait_us(gas_wait);
+        }
+    }
+
+    if((mode == BME68X_SEQUENTIAL_MODE) && ((sim->regs[SIM_REG_CTRL_GAS_1] & BME68X_ODR3_MSK) == 0))
+    {
+        dur_us += odr_standby_us[(sim->regs[SIM_REG_CONFIG] & BME68X_ODR20_MSK) >> BME68X_ODR20_POS];
+    }
+    return dur_us;
+}
+
+/**
+ * @brief Write the measurement that just finished into the next field buffer
+ *
+ */
+static void complete_measurement(struct bme68x_sim* sim)
+{
+    uint8_t* field = &sim->regs[BME68X_REG_FIELD0 + (sim->next_field * BME68X_LEN_FIELD_OFFSET)];
+    const struct bme68x_sim_calib* c = &sim->calib;
+    double t_fine;
+    uint32_t adc_t = temperature_adc(c, sim->env.temperature);
+    double temperature = comp_temperature(c, adc_t, &t_fine);
+    uint32_t adc_p = pressure_adc(c, sim->env.pressure, t_fine);
+    uint32_t adc_h = humidity_adc(c, sim->env.humidity, temperature);
+    uint16_t adc_g = 0;
+    uint8_t range = 0;
+    uint8_t gas_status = 0;
+
+    memset(field, 0, BME68X_LEN_FIELD);
+    field[0] = BME68X_NEW_DATA_MSK | (sim->gas_index & BME68X_GAS_INDEX_MSK);
+    field[1] = sim->meas_index++;
+    field[2] = (uint8_t)(adc_p >> 12);
+    field[3] = (uint8_t)(adc_p >> 4);
+    field[4] = (uint8_t)((adc_p & 0x0F) << 4);
+    field[5] = (uint8_t)(adc_t >> 12);
+    field[6] = (uint8_t)(adc_t >> 4);
+    field[7] = (uint8_t)((adc_t & 0x0F) << 4);
+    field[8] = (uint8_t)(adc_h >> 8);
+    field[9] = (uint8_t)adc_h;
+
+    if(gas_enabled(sim))
+    {
+        gas_adc(sim, sim->env.gas_resistance, &adc_g, &range);
+        gas_status = BME68X_GASM_VALID_MSK;
+        if(sim->regs[BME68X_REG_RES_HEAT0 + (sim->gas_index % 10)] != 0)
+        {
+            gas_status |= BME68X_HEAT_STAB_MSK;
+        }
+    }
+    if(sim->regs[BME68X_REG_VARIANT_ID] == BME68X_VARIANT_GAS_HIGH)
+    {
+        field[15] = (uint8_t)(adc_g >> 2);
+        field[16] = (uint8_t)(((adc_g & 0x03) << 6) | gas_status | range);
+    }
+    else
+    {
+        field[13] = (uint8_t)(adc_g >> 2);
+        field[14] = (uint8_t)(((adc_g & 0x03) << 6) | gas_status | range);
+    }
+
+    sim->next_field = (sim->mode == BME68X_FORCED_MODE) ? 0 : ((sim->next_field + 1) % BME68X_SIM_N_FIELDS);
+    sim->n_measurements++;
+}
+
+/**
+ * @brief Begin a measurement at heater step gas_index, starting at start_us
+ *
+ */
+static void start_measurement(struct bme68x_sim* sim, uint8_t gas_index, uint64_t start_us)
+{
+    sim->gas_index = gas_index;
+    sim->meas_end_us = start_us + bme68x_sim_meas_dur_us(sim, gas_index);
+    if(sim->mode == BME68X_FORCED_MODE)
+    {
+        sim->regs[BME68X_REG_FIELD0] = SIM_FIELD_STATUS_MEASURING | (gas_enabled(sim) ? SIM_FIELD_STATUS_GAS_MEASURING : 0);
+    }
+}
+
+/**
+ * @brief Run every measurement that finished by now. Continuous modes start the next heater step back to back
+ *
+ */
+static void run(struct bme68x_sim* sim)
+{
+    while((sim->mode != BME68X_SLEEP_MODE) && (sim->now_us >= sim->meas_end_us))
+    {
+        complete_measurement(sim);
+        if(sim->mode == BME68X_FORCED_MODE)
+        {
+            sim->mode = BME68X_SLEEP_MODE;
+            sim->regs[SIM_REG_CTRL_MEAS] &= (uint8_t)~BME68X_MODE_MSK;
+        }
+        else
+        {
+            uint8_t steps = (nb_conv(sim) > 0) ? nb_conv(sim) : 1;
+            start_measurement(sim, (uint8_t)((sim->gas_index + 1) % steps), sim->meas_end_us);
+        }
+    }
+}
+
+/**
+ * @brief Apply one register write and its side effects
+ *
+ */
+static void write_reg(struct bme68x_sim* sim, uint8_t reg, uint8_t val)
+{
+    if(reg == BME68X_REG_SOFT_RESET)
+    {
+        if(val == BME68X_SOFT_RESET_CMD)
+        {
+            reset(sim);
+        }
+        return;
+    }
+    if((reg >= BME68X_REG_IDAC_HEAT0) && (reg <= SIM_REG_CONFIG))
+    {
+        sim->regs[reg] = val;
+    }
+    if(reg == SIM_REG_CTRL_MEAS)
+    {
+        uint8_t mode = val & BME68X_MODE_MSK;
+        if(mode == BME68X_SLEEP_MODE)
+        {
+            sim->mode = BME68X_SLEEP_MODE;
+        }
+        else if(sim->mode == BME68X_SLEEP_MODE)
+        {
+            sim->mode = mode;
+            sim->next_field = 0;
+            start_measurement(sim, (mode == BME68X_FORCED_MODE) ? nb_conv(sim) : 0, sim->now_us);
+        }
+    }
+}
+
+/* ---------------------------------------------------------------------------------------------------------------- */
+/*                                                    Public API                                                    */
+/* ---------------------------------------------------------------------------------------------------------------- */
+
+/**
+ * @brief Power up a simulated part with the given identity and calibration, measuring 25 °C, 1013.25 hPa, 40 %, 50 kOhm
+ *
+ * @param sim
+ * @param variant_id BME68X_VARIANT_GAS_LOW for a BME680, BME68X_VARIANT_GAS_HIGH for a BME688
+ * @param calib calibration to burn in, NULL for bme68x_sim_default_calib
+ */
+void bme68x_sim_init(struct bme68x_sim* sim, uint8_t variant_id, const struct bme68x_sim_calib* calib)
+{
+    memset(sim, 0, sizeof(struct bme68x_sim));
+    sim->calib = (calib != NULL) ? *calib : bme68x_sim_default_calib;
+    sim->bus_us_per_byte = BME68X_SIM_BUS_US_PER_BYTE;
+    sim->env.temperature = 25.0;
+    sim->env.pressure = 101325.0;
+    sim->env.humidity = 40.0;
+    sim->env.gas_resistance = 50000.0;
+    sim->regs[BME68X_REG_VARIANT_ID] = variant_id;
+    reset(sim);
+}
+
+/**
+ * @brief Point a driver device at the simulator as an I2C part
+ *
+ * @param sim
+ * @param dev
+ */
+void bme68x_sim_attach(struct bme68x_sim* sim, struct bme68x_dev* dev)
+{
+    dev->intf = BME68X_I2C_INTF;
+    dev->read = bme68x_sim_read;
+    dev->write = bme68x_sim_write;
+    dev->delay_us = bme68x_sim_delay_us;
+    dev->intf_ptr = sim;
+    dev->amb_temp = 25;
+}
+
+/**
+ * @brief Change what the sensor is measuring. Takes effect from the next measurement that completes
+ *
+ * @param sim
+ * @param env
+ */
+void bme68x_sim_set_env(struct bme68x_sim* sim, const struct bme68x_sim_env* env)
+{
+    run(sim);
+    sim->env = *env;
+}
+
+/**
+ * @brief Move the virtual clock forward, completing any measurement that finishes in the meantime
+ *
+ * @param sim
+ * @param period_us
+ */
+void bme68x_sim_advance(struct bme68x_sim* sim, uint64_t period_us)
+{
+    sim->now_us += period_us;
+    run(sim);
+}
+
+/**
+ * @brief bme68x_read_fptr_t backed by the simulator. intf_ptr must be the struct bme68x_sim
+ *
+ * @details Reading a field's status byte clears its new data flag, so every field is reported as new exactly once.
+ */
+BME68X_INTF_RET_TYPE bme68x_sim_read(uint8_t reg_addr, uint8_t* reg_data, uint32_t len, void* intf_ptr)
+{
+    struct bme68x_sim* sim = (struct bme68x_sim*)intf_ptr;
+
+    if(((uint32_t)reg_addr + len) > BME68X_SIM_N_REGS)
+    {
+        return -1;
+    }
+
+    run(sim);
+    memcpy(reg_data, &sim->regs[reg_addr], len);
+    for(uint8_t f = 0; f < BME68X_SIM_N_FIELDS; f++)
+    {
+        uint8_t status_reg = BME68X_REG_FIELD0 + (f * BME68X_LEN_FIELD_OFFSET);
+        if((status_reg >= reg_addr) && (status_reg < ((uint32_t)reg_addr + len)))
+        {
+            sim->regs[status_reg] &= (uint8_t)~BME68X_NEW_DATA_MSK;
+        }
+    }
+
+    sim->n_reads++;
+    sim->bytes_read += len;
+    bme68x_sim_advance(sim, (uint64_t)(len + 1) * sim->bus_us_per_byte);
+    return 0;
+}
+
+/**
+ * @brief bme68x_write_fptr_t backed by the simulator. intf_ptr must be the struct bme68x_sim
+ *
+ * @details Takes the driver's I2C write layout: the first register address as reg_addr, then its data byte
+ * followed by address/data pairs for every further register.
+ */
+BME68X_INTF_RET_TYPE bme68x_sim_write(uint8_t reg_addr, const uint8_t* reg_data, uint32_t len, void* intf_ptr)
+{
+    struct bme68x_sim* sim = (struct bme68x_sim*)intf_ptr;
+
+    if((len == 0) || ((len % 2) == 0))
+    {
+        return -1;
+    }
+
+    run(sim);
+    write_reg(sim, reg_addr, reg_data[0]);
+    for(uint32_t i = 1; (i + 1) < len; i += 2)
+    {
+        write_reg(sim, reg_data[i], reg_data[i + 1]);
+    }
+
+    sim->n_writes++;
+    sim->bytes_written += len;
+    bme68x_sim_advance(sim, (uint64_t)(len + 1) * sim->bus_us_per_byte);
+    return 0;
+}
+
+/**
+ * @brief bme68x_delay_us_fptr_t backed by the simulator. Advances the virtual clock instead of sleeping
+ *
+ */
+void bme68x_sim_delay_us(uint32_t period, void* intf_ptr)
+{
+    bme68x_sim_advance((struct bme68x_sim*)intf_ptr, period);
+}
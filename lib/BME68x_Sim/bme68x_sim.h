@@ -0,0 +1,106 @@
+#ifndef __BME68X_SIM_H__
+#define __BME68X_SIM_H__
+#include <stdint.h>
+#include "bme68x.h"
+
+
+#define BME68X_SIM_N_REGS           256
+#define BME68X_SIM_N_FIELDS         3
+#define BME68X_SIM_BUS_US_PER_BYTE  23      // 9 bit clocks per byte at 400 kHz, charged to the virtual clock on every transfer
+
+
+/**
+ * @brief Environment the simulated sensor is measuring
+ *
+ */
+struct bme68x_sim_env
+{
+    double temperature;     // degree celsius
+    double pressure;        // Pa
+    double humidity;        // % relative humidity
+    double gas_resistance;  // Ohm
+};
+
+/**
+ * @brief Raw calibration parameters burnt into the simulated part, in the units of the coefficient registers
+ *
+ */
+struct bme68x_sim_calib
+{
+    uint16_t par_t1;
+    int16_t par_t2;
+    int8_t par_t3;
+    uint16_t par_p1;
+    int16_t par_p2;
+    int8_t par_p3;
+    int16_t par_p4;
+    int16_t par_p5;
+    int8_t par_p6;
+    int8_t par_p7;
+    int16_t par_p8;
+    int16_t par_p9;
+    uint8_t par_p10;
+    uint16_t par_h1;
+    uint16_t par_h2;
+    int8_t par_h3;
+    int8_t par_h4;
+    int8_t par_h5;
+    uint8_t par_h6;
+    int8_t par_h7;
+    int8_t par_gh1;
+    int16_t par_gh2;
+    int8_t par_gh3;
+    uint8_t res_heat_range;
+    int8_t res_heat_val;
+    int8_t range_sw_err;
+};
+
+/**
+ * @brief Register level model of a BME680/BME688 on a virtual clock
+ *
+ * @details The register file is what the driver reads and writes. Measurements are scheduled from the control
+ * registers exactly as the part would run them: TPH conversion time from the oversampling settings, heater time
+ * from gas_wait (and the shared heater duration in parallel mode), stepping through the heater profile in
+ * sequential and parallel mode and filling the three field buffers round robin. Time only moves when the driver
+ * delays, when bytes cross the bus, or when bme68x_sim_advance is called, so runs are deterministic and as fast
+ * as the host allows.
+ */
+struct bme68x_sim
+{
+    uint8_t regs[BME68X_SIM_N_REGS];
+    struct bme68x_sim_calib calib;
+    struct bme68x_sim_env env;
+
+    uint64_t now_us;            // virtual clock
+    uint32_t bus_us_per_byte;
+
+    uint8_t mode;               // operating mode the current measurement runs in, sleep if idle
+    uint64_t meas_end_us;       // completion time of the measurement in progress
+    uint8_t gas_index;          // heater step of the measurement in progress
+    uint8_t meas_index;         // sequence number given to the next completed field
+    uint8_t next_field;         // field buffer the next completed measurement is written to
+
+    /* Bus statistics */
+    uint32_t n_reads;
+    uint32_t n_writes;
+    uint32_t bytes_read;
+    uint32_t bytes_written;
+    uint32_t n_measurements;
+};
+
+
+void bme68x_sim_init(struct bme68x_sim* sim, uint8_t variant_id, const struct bme68x_sim_calib* calib);
+void bme68x_sim_attach(struct bme68x_sim* sim, struct bme68x_dev* dev);
+void bme68x_sim_set_env(struct bme68x_sim* sim, const struct bme68x_sim_env* env);
+void bme68x_sim_advance(struct bme68x_sim* sim, uint64_t period_us);
+uint32_t bme68x_sim_meas_dur_us(const struct bme68x_sim* sim, uint8_t gas_index);
+
+BME68X_INTF_RET_TYPE bme68x_sim_read(uint8_t reg_addr, uint8_t* reg_data, uint32_t len, void* intf_ptr);
+BME68X_INTF_RET_TYPE bme68x_sim_write(uint8_t reg_addr, const uint8_t* reg_data, uint32_t len, void* intf_ptr);
+void bme68x_sim_delay_us(uint32_t period, void* intf_ptr);
+
+extern const struct bme68x_sim_calib bme68x_sim_default_calib;
+
+
+
+#endif /* __BME68X_SIM_H__ */
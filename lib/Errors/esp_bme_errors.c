@@ -51,6 +51,9 @@ void bme68x_check_rslt(const char api_name[], int8_t rslt)
         case BME68X_W_NO_NEW_DATA:
             ESP_LOGI(tag, "API name [%s]  Warning [%d] : No new data found\r\n", api_name, rslt);
             break;
+        case BME68X_W_SHADOW_MISMATCH:
+            ESP_LOGW(tag, "API name [%s]  Warning [%d] : Shadow registers out of sync, reloaded\r\n", api_name, rslt);
+            break;
         default:
             ESP_LOGE(tag, "API name [%s]  Error [%d] : Unknown error code\r\n", api_name, rslt);
             break;
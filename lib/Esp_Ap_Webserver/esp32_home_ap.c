@@ -1,7 +1,14 @@
 #include "esp32_home_ap.h"
+#include <unistd.h>
+#include <stdatomic.h>
+#include "esp_random.h"
 
 const char* server_tag = "ESP32 Home Server";
 
+static httpd_handle_t event_server = NULL;
+static int event_fds[MAX_EVENT_SUBSCRIBERS] = { [0 ... MAX_EVENT_SUBSCRIBERS - 1] = -1 };   //only touched from the httpd task
+static uint32_t etag_boot_nonce;   //sample ids restart at 1 every boot, this keeps their ETags from repeating
+static atomic_uint event_subscriber_count = 0;  //changed on the httpd task, read on the acquisition task
 
 
 
@@ -9,6 +16,13 @@ static esp_err_t hello_get_handler(httpd_req_t *req);
 static esp_err_t http_404_error_handler(httpd_req_t *req, httpd_err_code_t err);
 static esp_err_t index_handler(httpd_req_t *req);
 static esp_err_t sensor_data_handler(httpd_req_t *req);
+static esp_err_t events_handler(httpd_req_t *req);
+static esp_err_t selftest_get_handler(httpd_req_t *req);
+static esp_err_t selftest_post_handler(httpd_req_t *req);
+#if BME_I2C_TRACE_BYTES > 0
+static esp_err_t i2c_trace_handler(httpd_req_t *req);
+#endif
+static void events_close_fn(httpd_handle_t hd, int sockfd);
 
 
 /**
@@ -33,6 +47,52 @@ static const httpd_uri_t sensor_data_uri = {
     .user_ctx  = NULL
 };
 
+/**
+ * @brief httpd URI structure for the server sent events stream
+ * 
+ */
+static const httpd_uri_t events_uri = {
+    .uri       = "/events",
+    .method    = HTTP_GET,
+    .handler   = events_handler,
+    .user_ctx  = NULL
+};
+
+/**
+ * @brief httpd URI structure for reading the sensor self-test status
+ * 
+ */
+static const httpd_uri_t selftest_get_uri = {
+    .uri       = "/selftest",
+    .method    = HTTP_GET,
+    .handler   = selftest_get_handler,
+    .user_ctx  = NULL
+};
+
+/**
+ * @brief httpd URI structure for starting the sensor self-test
+ * 
+ */
+static const httpd_uri_t selftest_post_uri = {
+    .uri       = "/selftest",
+    .method    = HTTP_POST,
+    .handler   = selftest_post_handler,
+    .user_ctx  = NULL
+};
+
+#if BME_I2C_TRACE_BYTES > 0
+/**
+ * @brief httpd URI structure for downloading the recorded sensor bus trace
+ * 
+ */
+static const httpd_uri_t i2c_trace_uri = {
+    .uri       = "/i2c_trace",
+    .method    = HTTP_GET,
+    .handler   = i2c_trace_handler,
+    .user_ctx  = NULL
+};
+#endif
+
 /**
  * @brief httpd URI structure for the hello world endpoint
  * 
@@ -134,182 +194,362 @@ static esp_err_t hello_get_handler(httpd_req_t *req)
 /**
  * @brief Index handler for serving the main dashboard page. Resolves to "/"
  * 
+ * @details The page is data/index.html, gzipped and hashed at build time by tools/embed_asset.py.
+ * A matching If-None-Match gets an empty 304, anything else gets the gzip blob as is.
+ * 
  * @param req 
  * @return esp_err_t 
  */
 static esp_err_t index_handler(httpd_req_t *req)
 {
-    const char* html = 
-        "<!DOCTYPE html>"
-        "<html>"
-        "<head>"
-            "<meta charset='UTF-8'>"
-            "<meta name='viewport' content='width=device-width, initial-scale=1.0'>"
-            "<title>BME680 Sensor Dashboard</title>"
-            "<style>"
-                "* { margin: 0; padding: 0; box-sizing: border-box; }"
-                "body {"
-                    "font-family: 'Segoe UI', Tahoma, Geneva, Verdana, sans-serif;"
-                    "background: linear-gradient(135deg, #667eea 0%, #764ba2 100%);"
-                    "min-height: 100vh;"
-                    "padding: 20px;"
-                "}"
-                ".container {"
-                    "max-width: 800px;"
-                    "margin: 0 auto;"
-                "}"
-                "h1 {"
-                    "color: white;"
-                    "text-align: center;"
-                    "margin-bottom: 30px;"
-                    "font-size: 2.5em;"
-                    "text-shadow: 2px 2px 4px rgba(0,0,0,0.3);"
-                "}"
-                ".grid {"
-                    "display: grid;"
-                    "grid-template-columns: repeat(auto-fit, minmax(250px, 1fr));"
-                    "gap: 20px;"
-                "}"
-                ".sensor-box {"
-                    "background: white;"
-                    "padding: 30px;"
-                    "border-radius: 15px;"
-                    "box-shadow: 0 8px 16px rgba(0,0,0,0.2);"
-                    "transition: transform 0.3s ease;"
-                "}"
-                ".sensor-box:hover {"
-                    "transform: translateY(-5px);"
-                "}"
-                ".sensor-title {"
-                    "font-size: 1.2em;"
-                    "color: #555;"
-                    "margin-bottom: 15px;"
-                    "font-weight: 600;"
-                "}"
-                ".sensor-value {"
-                    "font-size: 2.5em;"
-                    "font-weight: bold;"
-                    "background: linear-gradient(135deg, #667eea 0%, #764ba2 100%);"
-                    "background-clip: text;"
-                    "-webkit-background-clip: text;"
-                    "-webkit-text-fill-color: transparent;"
-                "}"
-                ".loading {"
-                    "color: #999;"
-                    "font-style: italic;"
-                "}"
-                ".footer {"
-                    "text-align: center;"
-                    "color: white;"
-                    "margin-top: 40px;"
-                    "font-size: 0.9em;"
-                    "opacity: 0.8;"
-                "}"
-                ".status {"
-                    "display: inline-block;"
-                    "width: 10px;"
-                    "height: 10px;"
-                    "border-radius: 50%;"
-                    "background: #4caf50;"
-                    "margin-right: 8px;"
-                    "animation: pulse 2s infinite;"
-                "}"
-                "@keyframes pulse {"
-                    "0%, 100% { opacity: 1; }"
-                    "50% { opacity: 0.5; }"
-                "}"
-            "</style>"
-        "</head>"
-        "<body>"
-            "<div class='container'>"
-                "<h1>🌡️ BME680 Sensor Dashboard</h1>"
-                "<div class='grid'>"
-                    "<div class='sensor-box'>"
-                        "<div class='sensor-title'>🌡️ Temperature</div>"
-                        "<div class='sensor-value loading' id='temp'>--</div>"
-                    "</div>"
-                    "<div class='sensor-box'>"
-                        "<div class='sensor-title'>📊 Pressure</div>"
-                        "<div class='sensor-value loading' id='pressure'>--</div>"
-                    "</div>"
-                    "<div class='sensor-box'>"
-                        "<div class='sensor-title'>💧 Humidity</div>"
-                        "<div class='sensor-value loading' id='humidity'>--</div>"
-                    "</div>"
-                    "<div class='sensor-box'>"
-                        "<div class='sensor-title'>💨 Gas Resistance</div>"
-                        "<div class='sensor-value loading' id='gas'>--</div>"
-                    "</div>"
-                "</div>"
-                "<div class='footer'>"
-                    "<span class='status'></span>Live updating every second | ESP32 BME680"
-                "</div>"
-            "</div>"
-            "<script>"
-                "function updateData() {"
-                    "fetch('/sensor_data')"
-                    ".then(response => response.json())"
-                    ".then(data => {"
-                        "document.getElementById('temp').innerHTML = data.temperature.toFixed(2) + ' <small>°C</small>';"
-                        "document.getElementById('pressure').innerHTML = data.pressure.toFixed(2) + ' <small>hPa</small>';"
-                        "document.getElementById('humidity').innerHTML = data.humidity.toFixed(2) + ' <small>%</small>';"
-                        "document.getElementById('gas').innerHTML = data.gas.toFixed(0) + ' <small>Ω</small>';"
-                        "document.querySelectorAll('.sensor-value').forEach(el => el.classList.remove('loading'));"
-                    "})"
-                    ".catch(err => {"
-                        "console.error('Error fetching data:', err);"
-                    "});"
-                "}"
-                "setInterval(updateData, 1000);"
-                "updateData();"
-            "</script>"
-        "</body>"
-        "</html>";
+    char if_none_match[64];
+
+    httpd_resp_set_hdr(req, "ETag", index_html_etag);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-cache");   // revalidate every load, the ETag makes that a 304
+
+    if((httpd_req_get_hdr_value_str(req, "If-None-Match", if_none_match, sizeof(if_none_match)) == ESP_OK) &&
+       (strstr(if_none_match, index_html_etag) != NULL))  // also matches W/ and lists of tags
+    {
+        httpd_resp_set_status(req, "304 Not Modified");
+        httpd_resp_send(req, NULL, 0);
+        return ESP_OK;
+    }
 
     httpd_resp_set_type(req, "text/html");
-    httpd_resp_send(req, html, strlen(html));
+    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    httpd_resp_send(req, (const char*)index_html_gz, index_html_gz_len);
     return ESP_OK;
 }
 
+/**
+ * @brief Sensor a request is about, from its "sensor" query parameter. The first sensor if there is none
+ * 
+ * @details A query or value too long for the buffers is a 404, its truncated form could name another sensor.
+ * 
+ * @param req 
+ * @return struct bme_sensor* NULL if there is no such sensor, the 404 has then been sent
+ */
+static struct bme_sensor* request_sensor(httpd_req_t *req)
+{
+    char query[32];
+    char value[4];
+    unsigned long index = 0;
+    struct bme_sensor* sensor;
+    esp_err_t err = httpd_req_get_url_query_str(req, query, sizeof(query));
+
+    if(err == ESP_OK)
+    {
+        err = httpd_query_key_value(query, "sensor", value, sizeof(value));
+    }
+    if(err == ESP_OK)
+    {
+        char* end;
+        index = strtoul(value, &end, 10);
+        if((end == value) || (*end != '\0'))
+        {
+            index = BME_MAX_SENSORS;
+        }
+    }
+    else if(err != ESP_ERR_NOT_FOUND)
+    {
+        index = BME_MAX_SENSORS;
+    }
+
+    sensor = (index < BME_MAX_SENSORS) ? bmeSensor((uint8_t)index) : NULL;
+    if(sensor == NULL)
+    {
+        httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "No such sensor");
+    }
+    return sensor;
+}
+
 /**
  * @brief Sensor data handler to update the index handler, when queried, with the lastest sensor data
  * 
+ * @details Until the sensor published its first sample the answer is 503 with a Retry-After header, so clients poll
+ * again rather than treat it as a failure. The ETag is the sample id prefixed with a random per boot nonce, so a
+ * client revalidating across a reboot never gets a 304 for a different sample.
+ * 
  * @param req 
  * @return esp_err_t 
  */
 static esp_err_t sensor_data_handler(httpd_req_t *req)
 {
-    struct bme68x_data local_bme_data;
-    // Try to receive data from the queue
-    if(xSemaphoreTake(sensor_data_mutex, pdMS_TO_TICKS(100)) == pdTRUE)
+    char json_response[BME_SNAPSHOT_JSON_LEN];
+    size_t json_len;
+    struct bme_sensor* sensor = request_sensor(req);
+    if(sensor == NULL)
+    {
+        return ESP_OK;
+    }
+    // Lock free copy of the body rendered when the latest sample was published, never waits on the acquisition task
+    uint32_t sample_id = bme_snapshot_read_json(&sensor->snapshot, json_response, sizeof(json_response), &json_len);
+    if(sample_id != 0)
     {
-        memcpy(&local_bme_data, &global_sensor_data, sizeof(struct bme68x_data));
-        xSemaphoreGive(sensor_data_mutex);
-        char json_response[256];
-        snprintf(json_response, sizeof(json_response), 
-        "{"
-            "\"temperature\": %.2f,"
-            "\"pressure\": %.2f,"
-            "\"humidity\": %.2f,"
-            "\"gas\": %.2f"
-        "}",
-            (float)local_bme_data.temperature / 100.0, // Convert to °C
-            (float)local_bme_data.pressure,
-            (float)local_bme_data.humidity / 1000.0, // Convert to %
-            (float)local_bme_data.gas_resistance
-        );
+        char etag[24];
+        char if_none_match[64];
+        snprintf(etag, sizeof(etag), "\"%08lx-%lu\"", (unsigned long)etag_boot_nonce, (unsigned long)sample_id);
 
-        httpd_resp_set_type(req, "application/json");
         httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
-        httpd_resp_send(req, json_response, strlen(json_response));
+        httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+        httpd_resp_set_hdr(req, "ETag", etag);
+
+        if((httpd_req_get_hdr_value_str(req, "If-None-Match", if_none_match, sizeof(if_none_match)) == ESP_OK) &&
+           (strcmp(if_none_match, etag) == 0))
+        {
+            httpd_resp_set_status(req, "304 Not Modified");
+            httpd_resp_send(req, NULL, 0);
+            return ESP_OK;
+        }
+
+        httpd_resp_set_type(req, "application/json");
+        httpd_resp_send(req, json_response, json_len);
 
     }
     else
     {
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Sensor data unavailable");
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_set_hdr(req, "Retry-After", SENSOR_RETRY_AFTER);
+        httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+        httpd_resp_set_type(req, "text/plain");
+        httpd_resp_send(req, "No sample yet", HTTPD_RESP_USE_STRLEN);
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Send a sensor's self-test status as JSON
+ * 
+ * @param req 
+ * @param sensor 
+ * @return esp_err_t 
+ */
+static esp_err_t send_selftest_status(httpd_req_t *req, struct bme_sensor* sensor)
+{
+    static const char* const states[] = { "idle", "running", "done" };
+    struct bme_selftest_status status;
+    char json_response[SELFTEST_JSON_LEN];
+
+    bmeGetSelfTestStatus(sensor, &status);
+    int json_len = snprintf(json_response, sizeof(json_response),
+        "{\"sensor\":%u,\"state\":\"%s\",\"requested\":%s,\"step\":%u,\"steps\":%u,\"result\":%d,\"passed\":%s,\"runs\":%lu}",
+        (unsigned)sensor->index,
+        (status.state <= BME68X_SELFTEST_DONE) ? states[status.state] : "unknown",
+        status.requested ? "true" : "false",
+        (unsigned)status.step,
+        (unsigned)BME68X_SELFTEST_STEPS,
+        (int)status.rslt,
+        ((status.runs > 0) && (status.rslt == BME68X_OK)) ? "true" : "false",
+        (unsigned long)status.runs);
+
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, json_response, json_len);
+    return ESP_OK;
+}
+
+/**
+ * @brief Sensor self-test status. Resolves to GET "/selftest?sensor=N"
+ * 
+ * @param req 
+ * @return esp_err_t 
+ */
+static esp_err_t selftest_get_handler(httpd_req_t *req)
+{
+    struct bme_sensor* sensor = request_sensor(req);
+    return (sensor != NULL) ? send_selftest_status(req, sensor) : ESP_OK;
+}
+
+/**
+ * @brief Start a sensor's self-test. Resolves to POST "/selftest?sensor=N"
+ * 
+ * @details Only queues the request, the acquisition task runs the test one measurement at a time, reading each as it completes. Poll
+ * GET "/selftest" for progress.
+ * 
+ * @param req 
+ * @return esp_err_t 
+ */
+static esp_err_t selftest_post_handler(httpd_req_t *req)
+{
+    struct bme_sensor* sensor = request_sensor(req);
+    if(sensor == NULL)
+    {
+        return ESP_OK;
+    }
+    bmeRequestSelfTest(sensor);
+    httpd_resp_set_status(req, "202 Accepted");
+    return send_selftest_status(req, sensor);
+}
+
+#if BME_I2C_TRACE_BYTES > 0
+/**
+ * @brief Sensor bus trace download. Resolves to "/i2c_trace"
+ * 
+ * @details Sends every record completed so far. The trace is append only, so the prefix is stable while the
+ * acquisition task keeps recording. Replay it on a host with bme_i2c_replay_attach.
+ * 
+ * @param req 
+ * @return esp_err_t 
+ */
+static esp_err_t i2c_trace_handler(httpd_req_t *req)
+{
+    size_t len = bme_i2c_trace_len(&i2c_trace);
+    if(len == 0)
+    {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "I2C trace unavailable");
+        return ESP_OK;
     }
+
+    httpd_resp_set_type(req, "application/octet-stream");
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"i2c_trace.bin\"");
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    httpd_resp_send(req, (const char*)i2c_trace.buf, len);
     return ESP_OK;
 }
+#endif
+
+/**
+ * @brief Server sent events handler. Resolves to "/events"
+ * 
+ * @details Writes the event stream headers by hand and keeps the socket as a subscriber instead of completing a response.
+ * Samples are then pushed to every subscriber by events_publish_sample, so browsers get each reading once, as it arrives,
+ * without opening a new request per update.
+ * 
+ * @param req 
+ * @return esp_err_t 
+ */
+static esp_err_t events_handler(httpd_req_t *req)
+{
+    static const char event_stream_hdr[] =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: text/event-stream\r\n"
+        "Cache-Control: no-cache\r\n"
+        "Connection: keep-alive\r\n"
+        "Access-Control-Allow-Origin: *\r\n"
+        "\r\n";
+    char retry[24];
+    int fd = httpd_req_to_sockfd(req);
+    int slot = -1;
+
+    for(int i = 0; i < MAX_EVENT_SUBSCRIBERS; i++)
+    {
+        if(event_fds[i] == fd)
+        {
+            return ESP_OK;  // already streaming on this socket
+        }
+        if((slot < 0) && (event_fds[i] < 0))
+        {
+            slot = i;
+        }
+    }
+    if(slot < 0)
+    {
+        // EventSource gives up on anything but a 200, the page then polls /sensor_data instead
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_set_hdr(req, "Retry-After", EVENT_RETRY_AFTER);
+        httpd_resp_set_hdr(req, "Cache-Control", "no-cache");
+        httpd_resp_set_type(req, "text/plain");
+        httpd_resp_send(req, "Too many event subscribers", HTTPD_RESP_USE_STRLEN);
+        return ESP_OK;
+    }
+
+    int retry_len = snprintf(retry, sizeof(retry), "retry: %d\n\n", EVENT_RETRY_MS);
+    if((httpd_send(req, event_stream_hdr, sizeof(event_stream_hdr) - 1) < 0) || (httpd_send(req, retry, retry_len) < 0))
+    {
+        return ESP_FAIL;
+    }
+
+    event_fds[slot] = fd;
+    atomic_fetch_add_explicit(&event_subscriber_count, 1, memory_order_relaxed);
+    ESP_LOGI(server_tag, "Event subscriber added on socket %d", fd);
+    return ESP_OK;
+}
+
+/**
+ * @brief Session close callback. Drops the socket from the event subscribers before closing it
+ * 
+ * @param hd 
+ * @param sockfd 
+ */
+static void events_close_fn(httpd_handle_t hd, int sockfd)
+{
+    (void)hd;
+    for(int i = 0; i < MAX_EVENT_SUBSCRIBERS; i++)
+    {
+        if(event_fds[i] == sockfd)
+        {
+            event_fds[i] = -1;
+            atomic_fetch_sub_explicit(&event_subscriber_count, 1, memory_order_relaxed);
+            ESP_LOGI(server_tag, "Event subscriber removed on socket %d", sockfd);
+        }
+    }
+    close(sockfd);
+}
+
+/**
+ * @brief httpd work item that writes one event to every subscriber. Runs on the httpd task
+ * 
+ * @param arg heap allocated, NUL terminated event text. Freed here
+ */
+static void events_send_work(void* arg)
+{
+    char* event = (char*)arg;
+    size_t len = strlen(event);
+
+    for(int i = 0; i < MAX_EVENT_SUBSCRIBERS; i++)
+    {
+        int fd = event_fds[i];
+        if(fd < 0)
+        {
+            continue;
+        }
+        if(httpd_socket_send(event_server, fd, event, len, 0) < 0)
+        {
+            httpd_sess_trigger_close(event_server, fd);
+        }
+        else
+        {
+            httpd_sess_update_lru_counter(event_server, fd);   // keep open streams from being LRU purged first
+        }
+    }
+    free(event);
+}
+
+/**
+ * @brief Push one sample to every /events subscriber
+ * 
+ * @details Called from the acquisition task right after each publish, so the snapshot still holds that sample.
+ * The cached JSON body is wrapped into an event here and handed to the httpd task, which owns the subscriber sockets.
+ * 
+ * @param snap snapshot the sample was just published to
+ */
+void events_publish_sample(struct bme_snapshot* snap)
+{
+    if((event_server == NULL) || (atomic_load_explicit(&event_subscriber_count, memory_order_relaxed) == 0))
+    {
+        return;
+    }
+
+    char json[BME_SNAPSHOT_JSON_LEN];
+    size_t json_len;
+    uint32_t sample_id = bme_snapshot_read_json(snap, json, sizeof(json), &json_len);
+    if(sample_id == 0)
+    {
+        return;
+    }
+
+    char* event = malloc(EVENT_MAX_LEN);
+    if(event == NULL)
+    {
+        return;
+    }
+    snprintf(event, EVENT_MAX_LEN, "id: %lu\ndata: %s\n\n", (unsigned long)sample_id, json);
+
+    if(httpd_queue_work(event_server, events_send_work, event) != ESP_OK)
+    {
+        free(event);
+    }
+}
 
 /**
  * @brief Start the webserver for esp32 home AP
@@ -320,8 +560,11 @@ httpd_handle_t start_webserver(void)
 {
     httpd_handle_t server = NULL;
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+
+    etag_boot_nonce = esp_random();
     config.lru_purge_enable = true;
     config.max_uri_handlers=8;
+    config.close_fn = events_close_fn;
 
     ESP_LOGI(server_tag, "Starting server on port: %d", config.server_port);
 
@@ -350,6 +593,44 @@ httpd_handle_t start_webserver(void)
             ESP_LOGI(server_tag, "Failed to register Sensor Data URI handler");
         }
 
+        ret = httpd_register_uri_handler(server, &events_uri);
+        if(ret == ESP_OK)
+        {
+            ESP_LOGI(server_tag, "Events URI handler registered");
+        }
+        else
+        {
+            ESP_LOGI(server_tag, "Failed to register Events URI handler");
+        }
+
+        ret = httpd_register_uri_handler(server, &selftest_get_uri);
+        if(ret == ESP_OK)
+        {
+            ret = httpd_register_uri_handler(server, &selftest_post_uri);
+        }
+        if(ret == ESP_OK)
+        {
+            ESP_LOGI(server_tag, "Self-test URI handlers registered");
+        }
+        else
+        {
+            ESP_LOGI(server_tag, "Failed to register Self-test URI handlers");
+        }
+
+#if BME_I2C_TRACE_BYTES > 0
+        ret = httpd_register_uri_handler(server, &i2c_trace_uri);
+        if(ret == ESP_OK)
+        {
+            ESP_LOGI(server_tag, "I2C trace URI handler registered");
+        }
+        else
+        {
+            ESP_LOGI(server_tag, "Failed to register I2C trace URI handler");
+        }
+#endif
+
+        event_server = server;
+
         ESP_LOGI(server_tag, "Webserver started successfully");
         return server;
     }
@@ -368,6 +649,7 @@ httpd_handle_t stop_webserver(httpd_handle_t server)
     ESP_LOGI(server_tag, "Stopping webserver");
     if(httpd_stop(server)  == ESP_OK)
     {
+        event_server = NULL;
         ESP_LOGI(server_tag, "Webserver stopped");
         return NULL;
     }
@@ -2,6 +2,7 @@
 #define __ESP32_HOME_SERVER_H__
 
 #include <stdio.h>
+#include <stdlib.h>
 #include "esp_http_server.h"
 #include "esp_log.h"
 #include "esp_wifi.h"
@@ -14,15 +15,24 @@
 #define ESP_WIFI_PASS       "bme680sensor"
 #define ESP_WIFI_CHANNEL    1
 #define MAX_STA_CONN        2
+#define MAX_EVENT_SUBSCRIBERS 4     // open /events streams
+#define EVENT_RETRY_MS      2000    // browser reconnect delay sent to /events subscribers
+#define EVENT_RETRY_AFTER   "10"    // seconds a client refused an /events stream is told to wait
+#define EVENT_MAX_LEN       320     // rendered "id: ...\ndata: {json}\n\n" event
+#define SELFTEST_JSON_LEN   128     // rendered /selftest status body
+#define SENSOR_RETRY_AFTER  "1"     // seconds a client is told to wait when /sensor_data has no sample yet
 
-extern SemaphoreHandle_t sensor_data_mutex;
-
+/* Dashboard page, generated at build time from data/index.html by tools/embed_asset.py */
+extern const uint8_t index_html_gz[];
+extern const size_t index_html_gz_len;
+extern const char index_html_etag[];
 
 
 void wifi_init_softap(void);
 httpd_handle_t start_webserver(void);
 httpd_handle_t stop_webserver(httpd_handle_t server);
 esp_err_t nvs_setup(void);
+void events_publish_sample(struct bme_snapshot* snap);
 
 
 
@@ -0,0 +1,323 @@
+#include "bme_i2c_trace.h"
+#include <string.h>
+
+
+static void put_u16(uint8_t* p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint16_t get_u16(const uint8_t* p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+
+/**
+ * @brief Start an empty trace in a caller provided buffer
+ *
+ * @param trace
+ * @param buf
+ * @param cap size of buf, at least BME_I2C_TRACE_HEADER_LEN
+ */
+void bme_i2c_trace_init(struct bme_i2c_trace* trace, uint8_t* buf, size_t cap)
+{
+    trace->buf = buf;
+    trace->cap = cap;
+    trace->last_us = 0;
+    trace->records = 0;
+    trace->dropped = 0;
+    memcpy(buf, BME_I2C_TRACE_MAGIC, BME_I2C_TRACE_HEADER_LEN);
+    atomic_store_explicit(&trace->len, BME_I2C_TRACE_HEADER_LEN, memory_order_release);
+}
+
+/**
+ * @brief Append one transfer. Single writer: call only from the task that owns the bus
+ *
+ * @param trace
+ * @param op BME_I2C_TRACE_READ or BME_I2C_TRACE_WRITE
+ * @param reg register address the transfer started at
+ * @param data bytes read or written
+ * @param len
+ * @param failed nonzero if the transfer returned an error
+ * @param now_us monotonic timestamp of the transfer
+ */
+void bme_i2c_trace_record(struct bme_i2c_trace* trace, uint8_t op, uint8_t reg, const uint8_t* data, uint32_t len, uint8_t failed, uint64_t now_us)
+{
+    size_t pos = atomic_load_explicit(&trace->len, memory_order_relaxed);
+    uint64_t dt_us = (trace->records == 0) ? 0 : (now_us - trace->last_us);
+    uint8_t* rec;
+
+    if((trace->buf == NULL) || (len > UINT16_MAX) || ((pos + BME_I2C_TRACE_RECORD_LEN + len) > trace->cap))
+    {
+        trace->dropped++;
+        return;
+    }
+
+    rec = &trace->buf[pos];
+    rec[0] = (uint8_t)((op & BME_I2C_TRACE_OP_MSK) | (failed ? BME_I2C_TRACE_FAILED : 0));
+    rec[1] = reg;
+    put_u16(&rec[2], (uint16_t)len);
+    put_u32(&rec[4], (dt_us > UINT32_MAX) ? UINT32_MAX : (uint32_t)dt_us);
+    memcpy(&rec[BME_I2C_TRACE_RECORD_LEN], data, len);
+
+    trace->last_us = now_us;
+    trace->records++;
+    atomic_store_explicit(&trace->len, pos + BME_I2C_TRACE_RECORD_LEN + len, memory_order_release);
+}
+
+/**
+ * @brief Number of valid bytes in the trace, header included. Safe to call from any task
+ *
+ */
+size_t bme_i2c_trace_len(struct bme_i2c_trace* trace)
+{
+    return atomic_load_explicit(&trace->len, memory_order_acquire);
+}
+
+
+/**
+ * @brief Prepare a recorded trace for replay
+ *
+ * @param replay
+ * @param buf the trace, as produced by bme_i2c_trace_record. Must outlive the replay
+ * @param len
+ * @return int8_t BME68X_OK, or BME68X_E_INVALID_LENGTH if buf is not a trace
+ */
+int8_t bme_i2c_replay_init(struct bme_i2c_replay* replay, const uint8_t* buf, size_t len)
+{
+    memset(replay, 0, sizeof(struct bme_i2c_replay));
+    if((len < BME_I2C_TRACE_HEADER_LEN) || (memcmp(buf, BME_I2C_TRACE_MAGIC, BME_I2C_TRACE_HEADER_LEN) != 0))
+    {
+        return BME68X_E_INVALID_LENGTH;
+    }
+    replay->buf = buf;
+    replay->len = len;
+    replay->pos = BME_I2C_TRACE_HEADER_LEN;
+    return BME68X_OK;
+}
+
+/**
+ * @brief Point a driver device at the replay, in place of the real bus
+ *
+ */
+void bme_i2c_replay_attach(struct bme_i2c_replay* replay, struct bme68x_dev* dev)
+{
+    dev->intf = BME68X_I2C_INTF;
+    dev->read = bme_i2c_replay_read;
+    dev->write = bme_i2c_replay_write;
+    dev->delay_us = bme_i2c_replay_delay_us;
+    dev->intf_ptr = replay;
+}
+
+/**
+ * @brief Record at offset pos, NULL if it does not fit in the trace
+ *
+ */
+static const uint8_t* replay_record(const struct bme_i2c_replay* replay, size_t pos)
+{
+    const uint8_t* rec = &replay->buf[pos];
+
+    if(((pos + BME_I2C_TRACE_RECORD_LEN) > replay->len) ||
+       ((pos + BME_I2C_TRACE_RECORD_LEN + get_u16(&rec[2])) > replay->len))
+    {
+        return NULL;
+    }
+    return rec;
+}
+
+/**
+ * @brief Whether a write record sets reg, and to what. The payload is the driver's I2C layout: the value of the first
+ * register, then address/value pairs
+ *
+ */
+static uint8_t record_writes(const uint8_t* rec, uint8_t reg, uint8_t* value)
+{
+    const uint8_t* payload = &rec[BME_I2C_TRACE_RECORD_LEN];
+    uint16_t len = get_u16(&rec[2]);
+    uint8_t found = 0;
+
+    if((len > 0) && (rec[1] == reg))
+    {
+        *value = payload[0];
+        found = 1;
+    }
+    for(uint16_t i = 1; (i + 1) < len; i += 2)
+    {
+        if(payload[i] == reg)
+        {
+            *value = payload[i + 1];
+            found = 1;
+        }
+    }
+    return found;
+}
+
+/**
+ * @brief Bring the register image up to date with one record: read bytes are what the device held, written ones what it
+ * was set to
+ *
+ */
+static void replay_apply(struct bme_i2c_replay* replay, const uint8_t* rec)
+{
+    const uint8_t* payload = &rec[BME_I2C_TRACE_RECORD_LEN];
+    uint16_t len = get_u16(&rec[2]);
+
+    if((rec[0] & BME_I2C_TRACE_OP_MSK) == BME_I2C_TRACE_READ)
+    {
+        for(uint16_t i = 0; (i < len) && ((rec[1] + i) < (int)sizeof(replay->regs)); i++)
+        {
+            replay->regs[rec[1] + i] = payload[i];
+        }
+    }
+    else if(len > 0)
+    {
+        replay->regs[rec[1]] = payload[0];
+        for(uint16_t i = 1; (i + 1) < len; i += 2)
+        {
+            replay->regs[payload[i]] = payload[i + 1];
+        }
+    }
+    replay->now_us += get_u32(&rec[4]);
+}
+
+/**
+ * @brief Advance through the next record of op that touches the registers reg .. reg + len - 1, applying it and every
+ * record before it
+ *
+ * @return const uint8_t* that record, NULL if none is left. The image is then left as it stands
+ */
+static const uint8_t* replay_advance(struct bme_i2c_replay* replay, uint8_t op, uint8_t reg, uint32_t len)
+{
+    const uint8_t* rec;
+    size_t pos = replay->pos;
+    uint8_t value;
+
+    while((rec = replay_record(replay, pos)) != NULL)
+    {
+        uint16_t rec_len = get_u16(&rec[2]);
+        uint8_t match;
+
+        if((rec[0] & BME_I2C_TRACE_OP_MSK) != op)
+        {
+            match = 0;
+        }
+        else if(op == BME_I2C_TRACE_READ)
+        {
+            match = ((uint32_t)rec[1] < ((uint32_t)reg + len)) && ((uint32_t)reg < ((uint32_t)rec[1] + rec_len));
+        }
+        else
+        {
+            match = record_writes(rec, reg, &value);
+        }
+
+        pos += BME_I2C_TRACE_RECORD_LEN + rec_len;
+        if(match)
+        {
+            while(replay->pos < pos)
+            {
+                const uint8_t* applied = &replay->buf[replay->pos];
+                replay_apply(replay, applied);
+                replay->pos += BME_I2C_TRACE_RECORD_LEN + get_u16(&applied[2]);
+            }
+            return rec;
+        }
+    }
+    replay->exhausted = 1;
+    return NULL;
+}
+
+/**
+ * @brief Compare the contents the driver writes to reg with those the recording holds for it, and apply them
+ *
+ * @return uint8_t nonzero if the recorded transfer that wrote reg failed
+ */
+static uint8_t replay_write_reg(struct bme_i2c_replay* replay, uint8_t reg, uint8_t value)
+{
+    const uint8_t* rec = NULL;
+
+    // Writing what the register already holds changes nothing, whether or not the recording repeated the write
+    if(replay->regs[reg] != value)
+    {
+        rec = replay_advance(replay, BME_I2C_TRACE_WRITE, reg, 1);
+    }
+    if(replay->regs[reg] != value)
+    {
+        if(replay->mismatches == 0)
+        {
+            replay->mismatch_reg = reg;
+            replay->mismatch_recorded = replay->regs[reg];
+            replay->mismatch_written = value;
+        }
+        replay->mismatches++;
+    }
+    replay->regs[reg] = value;
+    return (rec != NULL) && (rec[0] & BME_I2C_TRACE_FAILED);
+}
+
+/**
+ * @brief bme68x_read_fptr_t that answers from the register image. intf_ptr must be the struct bme_i2c_replay
+ *
+ */
+BME68X_INTF_RET_TYPE bme_i2c_replay_read(uint8_t reg_addr, uint8_t* reg_data, uint32_t len, void* intf_ptr)
+{
+    struct bme_i2c_replay* replay = (struct bme_i2c_replay*)intf_ptr;
+    const uint8_t* rec;
+
+    if(((uint32_t)reg_addr + len) > sizeof(replay->regs))
+    {
+        return BME68X_E_COM_FAIL;
+    }
+    rec = replay_advance(replay, BME_I2C_TRACE_READ, reg_addr, len);
+    memcpy(reg_data, &replay->regs[reg_addr], len);
+    replay->transfers++;
+    return ((rec != NULL) && (rec[0] & BME_I2C_TRACE_FAILED)) ? BME68X_E_COM_FAIL : BME68X_OK;
+}
+
+/**
+ * @brief bme68x_write_fptr_t that checks every register written against the recording. intf_ptr must be the struct
+ * bme_i2c_replay
+ *
+ * @details Takes the driver's I2C write layout: the first register address as reg_addr, then its value followed by
+ * address/value pairs for every further register.
+ */
+BME68X_INTF_RET_TYPE bme_i2c_replay_write(uint8_t reg_addr, const uint8_t* reg_data, uint32_t len, void* intf_ptr)
+{
+    struct bme_i2c_replay* replay = (struct bme_i2c_replay*)intf_ptr;
+    uint8_t failed = 0;
+
+    if(len == 0)
+    {
+        return BME68X_E_COM_FAIL;
+    }
+    failed |= replay_write_reg(replay, reg_addr, reg_data[0]);
+    for(uint32_t i = 1; (i + 1) < len; i += 2)
+    {
+        failed |= replay_write_reg(replay, reg_data[i], reg_data[i + 1]);
+    }
+    replay->transfers++;
+    return failed ? BME68X_E_COM_FAIL : BME68X_OK;
+}
+
+/**
+ * @brief bme68x_delay_us_fptr_t for replay. Returns immediately, the recording already holds what the delay waited for
+ *
+ */
+void bme_i2c_replay_delay_us(uint32_t period, void* intf_ptr)
+{
+    ((struct bme_i2c_replay*)intf_ptr)->delayed_us += period;
+}
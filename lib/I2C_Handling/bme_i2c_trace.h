@@ -0,0 +1,80 @@
+#ifndef __BME_I2C_TRACE_H__
+#define __BME_I2C_TRACE_H__
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "bme68x.h"
+
+
+/*
+ * Binary trace of sensor bus traffic. Platform independent so the same code records on the ESP32 and replays on a host.
+ *
+ * Layout, little endian:
+ *   header   "BMT" 0x01
+ *   record   u8 op | BME_I2C_TRACE_FAILED, u8 reg, u16 len, u32 us since the previous record, then len payload bytes
+ * Read payloads are the bytes the device returned, write payloads the bytes the driver handed to the write callback.
+ */
+#define BME_I2C_TRACE_MAGIC         "BMT\x01"
+#define BME_I2C_TRACE_HEADER_LEN    4
+#define BME_I2C_TRACE_RECORD_LEN    8       // record header, payload excluded
+
+#define BME_I2C_TRACE_READ          0x00
+#define BME_I2C_TRACE_WRITE         0x01
+#define BME_I2C_TRACE_OP_MSK        0x7F
+#define BME_I2C_TRACE_FAILED        0x80    // the transfer returned an error
+
+
+/**
+ * @brief Append only trace being recorded
+ *
+ * @details Recording stops once buf is full, so everything below len is immutable and a reader on another task may
+ * copy it out at any time after an acquire load of len.
+ */
+struct bme_i2c_trace
+{
+    uint8_t* buf;
+    size_t cap;
+    atomic_size_t len;
+    uint64_t last_us;       // timestamp of the previous record
+    uint32_t records;
+    uint32_t dropped;       // transfers not recorded because the buffer was full
+};
+
+/**
+ * @brief Device model that serves a recorded trace back to the driver
+ *
+ * @details The recording is replayed into a register image. A driver read is served from the image, by address, once
+ * the replay has advanced through the next recorded read of any of those registers. A driver write advances through the
+ * next recorded write of each register it sets, and the value must match what the recording wrote there. So a driver
+ * that reads less often, coalesces transfers or orders them differently still replays, and only a register written
+ * with different contents is reported.
+ */
+struct bme_i2c_replay
+{
+    const uint8_t* buf;
+    size_t len;
+    size_t pos;             // offset of the next record not yet applied to regs
+    uint8_t regs[256];      // register contents as of pos, with the driver's writes applied over them
+    uint64_t now_us;        // recorded time of the last record applied
+    uint64_t delayed_us;    // sum of the delays the driver requested
+    uint32_t transfers;
+    uint32_t mismatches;    // registers the driver wrote with other contents than the recording, or never written there
+    uint8_t mismatch_reg;   // the first of them
+    uint8_t mismatch_recorded;  // its value in the recording
+    uint8_t mismatch_written;   // and the value the driver wrote
+    uint8_t exhausted;      // a transfer found no matching record left, it was served from regs as they stood
+};
+
+void bme_i2c_trace_init(struct bme_i2c_trace* trace, uint8_t* buf, size_t cap);
+void bme_i2c_trace_record(struct bme_i2c_trace* trace, uint8_t op, uint8_t reg, const uint8_t* data, uint32_t len, uint8_t failed, uint64_t now_us);
+size_t bme_i2c_trace_len(struct bme_i2c_trace* trace);
+
+int8_t bme_i2c_replay_init(struct bme_i2c_replay* replay, const uint8_t* buf, size_t len);
+void bme_i2c_replay_attach(struct bme_i2c_replay* replay, struct bme68x_dev* dev);
+BME68X_INTF_RET_TYPE bme_i2c_replay_read(uint8_t reg_addr, uint8_t* reg_data, uint32_t len, void* intf_ptr);
+BME68X_INTF_RET_TYPE bme_i2c_replay_write(uint8_t reg_addr, const uint8_t* reg_data, uint32_t len, void* intf_ptr);
+void bme_i2c_replay_delay_us(uint32_t period, void* intf_ptr);
+
+
+
+#endif /* __BME_I2C_TRACE_H__ */
@@ -1,28 +1,43 @@
 #include "esp_bme_i2c.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_bme_errors.h"
 
 
 
 
-i2c_master_bus_config_t i2c_bus_config = {
-    .clk_source = I2C_CLK_SRC_DEFAULT,
-    .scl_io_num = GPIO_NUM_22,
-    .sda_io_num = GPIO_NUM_21,
-    .i2c_port = I2C_PORT,
-    .flags.enable_internal_pullup = true,
-    .glitch_ignore_cnt = 7,
-    .intr_priority = 0
+i2c_master_bus_config_t i2c_bus_configs[BME_I2C_N_PORTS] = {
+    {
+        .clk_source = I2C_CLK_SRC_DEFAULT,
+        .scl_io_num = I2C_PORT0_SCL_IO,
+        .sda_io_num = I2C_PORT0_SDA_IO,
+        .i2c_port = I2C_NUM_0,
+        .flags.enable_internal_pullup = true,
+        .glitch_ignore_cnt = 7,
+        .intr_priority = 0
+    },
+#if I2C_PORT1_ENABLE
+    {
+        .clk_source = I2C_CLK_SRC_DEFAULT,
+        .scl_io_num = I2C_PORT1_SCL_IO,
+        .sda_io_num = I2C_PORT1_SDA_IO,
+        .i2c_port = I2C_NUM_1,
+        .flags.enable_internal_pullup = true,
+        .glitch_ignore_cnt = 7,
+        .intr_priority = 0
+    },
+#endif
 };
 
-i2c_device_config_t i2c_dev_config = {
-    .dev_addr_length = I2C_ADDR_BIT_7,
-    .device_address = DEVICE_ADDR,
-    .scl_speed_hz = I2C_FREQ_HZ,
-    .scl_wait_us = 0,
-    .flags.disable_ack_check = false
-};
+i2c_master_bus_handle_t i2c_bus_handles[BME_I2C_N_PORTS];
+
+struct bme_i2c_dev bme_i2c_devs[BME_I2C_MAX_DEVICES];
+uint8_t bme_i2c_n_devs = 0;
 
-i2c_master_bus_handle_t i2c_bus_handle;
-i2c_master_dev_handle_t i2c_dev_handle;
+struct bme_i2c_trace i2c_trace;      // recording only once initialize_i2c got a buffer for it
+
+static struct bme_i2c_stats i2c_stats;
+static portMUX_TYPE i2c_stats_lock = portMUX_INITIALIZER_UNLOCKED;
 
 
 /**
@@ -31,19 +46,34 @@ i2c_master_dev_handle_t i2c_dev_handle;
  * @param reg_addr 
  * @param reg_data 
  * @param len 
- * @param intf_ptr 
+ * @param intf_ptr the struct bme_i2c_dev of the sensor
  * @return int8_t 
  */
 int8_t bme68x_i2c_read(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, void *intf_ptr)
 {
+    struct bme_i2c_dev* dev = (struct bme_i2c_dev*)intf_ptr;
+#if BME_I2C_TRACE_BYTES > 0
+    int64_t start_us = esp_timer_get_time();
+#endif
     esp_err_t err = i2c_master_transmit_receive(
-        i2c_dev_handle,
+        dev->handle,
         &reg_addr,
         1,
         reg_data,
         len,
         pdMS_TO_TICKS(I2C_MASTER_TIMEOUT_MS)
     );
+#if BME_I2C_TRACE_BYTES > 0
+    if(dev == &bme_i2c_devs[0])
+    {
+        bme_i2c_trace_record(&i2c_trace, BME_I2C_TRACE_READ, reg_addr, reg_data, len, err != ESP_OK, start_us);
+    }
+#endif
+    portENTER_CRITICAL(&i2c_stats_lock);
+    i2c_stats.reads++;
+    i2c_stats.bytes_read += len;
+    i2c_stats.errors += (err != ESP_OK);
+    portEXIT_CRITICAL(&i2c_stats_lock);
     return (err == ESP_OK) ? BME68X_OK : BME68X_E_COM_FAIL;  
 }
 
@@ -53,25 +83,102 @@ int8_t bme68x_i2c_read(uint8_t reg_addr, uint8_t *reg_data, uint32_t len, void *
  * @param reg_addr 
  * @param reg_data 
  * @param len 
- * @param intf_ptr 
+ * @param intf_ptr the struct bme_i2c_dev of the sensor
  * @return int8_t 
  */
 int8_t bme68x_i2c_write(uint8_t reg_addr, const uint8_t *reg_data, uint32_t len, void *intf_ptr)
 {
+    struct bme_i2c_dev* dev = (struct bme_i2c_dev*)intf_ptr;
+#if BME_I2C_TRACE_BYTES > 0
+    int64_t start_us = esp_timer_get_time();
+#endif
     uint8_t tx_buf[len+1];
     tx_buf[0] = reg_addr;
     memcpy(&tx_buf[1], reg_data, len);
     esp_err_t err = i2c_master_transmit(
-        i2c_dev_handle,
+        dev->handle,
         tx_buf, 
         len+1,
         pdMS_TO_TICKS(I2C_MASTER_TIMEOUT_MS)
     );
+#if BME_I2C_TRACE_BYTES > 0
+    if(dev == &bme_i2c_devs[0])
+    {
+        bme_i2c_trace_record(&i2c_trace, BME_I2C_TRACE_WRITE, reg_addr, reg_data, len, err != ESP_OK, start_us);
+    }
+#endif
+    portENTER_CRITICAL(&i2c_stats_lock);
+    i2c_stats.writes++;
+    i2c_stats.bytes_written += len + 1;
+    i2c_stats.errors += (err != ESP_OK);
+    portEXIT_CRITICAL(&i2c_stats_lock);
     return (err == ESP_OK) ? BME68X_OK : BME68X_E_COM_FAIL;
 }
 
+/**
+ * @brief Copy out the sensor bus statistics
+ * 
+ * @param stats 
+ */
+void bme_i2c_get_stats(struct bme_i2c_stats* stats)
+{
+    portENTER_CRITICAL(&i2c_stats_lock);
+    memcpy(stats, &i2c_stats, sizeof(struct bme_i2c_stats));
+    portEXIT_CRITICAL(&i2c_stats_lock);
+}
+
+/**
+ * @brief Create the I2C buses and add a device for every sensor that answers on them
+ * 
+ * @details Both sensor addresses are probed on every enabled port. The sensors found are listed in bme_i2c_devs, port
+ * by port, the lower address first.
+ * 
+ */
 void initialize_i2c(void)
 {
-    ESP_ERROR_CHECK(i2c_new_master_bus(&i2c_bus_config, &i2c_bus_handle));
-    ESP_ERROR_CHECK(i2c_master_bus_add_device(i2c_bus_handle, &i2c_dev_config, &i2c_dev_handle));
+    static const uint8_t addrs[] = { BME68X_I2C_ADDR_LOW, BME68X_I2C_ADDR_HIGH };
+    i2c_device_config_t dev_config = {
+        .dev_addr_length = I2C_ADDR_BIT_7,
+        .scl_speed_hz = I2C_FREQ_HZ,
+        .scl_wait_us = 0,
+        .flags.disable_ack_check = false
+    };
+
+    bme_i2c_n_devs = 0;
+    for(uint8_t p = 0; p < BME_I2C_N_PORTS; p++)
+    {
+        ESP_ERROR_CHECK(i2c_new_master_bus(&i2c_bus_configs[p], &i2c_bus_handles[p]));
+        for(uint8_t a = 0; a < sizeof(addrs); a++)
+        {
+            if(i2c_master_probe(i2c_bus_handles[p], addrs[a], I2C_PROBE_TIMEOUT_MS) != ESP_OK)
+            {
+                continue;
+            }
+
+            struct bme_i2c_dev* dev = &bme_i2c_devs[bme_i2c_n_devs];
+            dev_config.device_address = addrs[a];
+            ESP_ERROR_CHECK(i2c_master_bus_add_device(i2c_bus_handles[p], &dev_config, &dev->handle));
+            dev->port = i2c_bus_configs[p].i2c_port;
+            dev->addr = addrs[a];
+            bme_i2c_n_devs++;
+            ESP_LOGI(tag, "Sensor found on I2C port %d at 0x%02x", (int)dev->port, dev->addr);
+        }
+    }
+    if(bme_i2c_n_devs == 0)
+    {
+        ESP_LOGE(tag, "No sensor answered on any I2C port");
+    }
+
+#if BME_I2C_TRACE_BYTES > 0
+    uint8_t* trace_buf = heap_caps_malloc(BME_I2C_TRACE_BYTES, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if(trace_buf != NULL)
+    {
+        bme_i2c_trace_init(&i2c_trace, trace_buf, BME_I2C_TRACE_BYTES);
+        ESP_LOGI(tag, "Recording sensor bus traffic, %u bytes of trace", (unsigned)BME_I2C_TRACE_BYTES);
+    }
+    else
+    {
+        ESP_LOGW(tag, "No PSRAM for the I2C trace, recording disabled");
+    }
+#endif
 }
\ No newline at end of file
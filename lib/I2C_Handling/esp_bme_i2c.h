@@ -3,21 +3,62 @@
 #include "driver/i2c_master.h"
 #include "driver/i2c.h"
 #include "bme68x.h"
+#include "bme_i2c_trace.h"
 
 
 #define I2C_FREQ_HZ         400000     // 400kHz
-#define I2C_PORT            I2C_NUM_0
-
-#define DEVICE_ADDR         0x76       // example device address
 #define I2C_MASTER_TIMEOUT_MS 1000
+#define I2C_PROBE_TIMEOUT_MS 50
+
+#define I2C_PORT0_SDA_IO    GPIO_NUM_21
+#define I2C_PORT0_SCL_IO    GPIO_NUM_22
+#ifndef I2C_PORT1_ENABLE
+#define I2C_PORT1_ENABLE    0           // 1 to also look for sensors on I2C_NUM_1, can be given as a build flag
+#endif
+#define I2C_PORT1_SDA_IO    GPIO_NUM_32
+#define I2C_PORT1_SCL_IO    GPIO_NUM_33
+
+#define BME_I2C_N_PORTS     (1 + I2C_PORT1_ENABLE)
+#define BME_I2C_MAX_DEVICES (2 * BME_I2C_N_PORTS)   // BME68X_I2C_ADDR_LOW and BME68X_I2C_ADDR_HIGH on each port
+
+#define BME_I2C_TRACE_BYTES 0           // PSRAM used to record sensor bus traffic, served at /i2c_trace. 0 disables recording
+
+
+/**
+ * @brief One sensor found on a bus. Its address is the intf_ptr of the driver device that talks to it
+ * 
+ */
+struct bme_i2c_dev
+{
+    i2c_master_dev_handle_t handle;
+    i2c_port_num_t port;
+    uint8_t addr;
+};
+
+extern i2c_master_bus_config_t i2c_bus_configs[BME_I2C_N_PORTS];
+extern i2c_master_bus_handle_t i2c_bus_handles[BME_I2C_N_PORTS];
+
+extern struct bme_i2c_dev bme_i2c_devs[BME_I2C_MAX_DEVICES];
+extern uint8_t bme_i2c_n_devs;
+
+extern struct bme_i2c_trace i2c_trace;      // records the traffic of bme_i2c_devs[0] only, a trace replays one device
 
-extern i2c_master_bus_config_t i2c_bus_config;
-extern i2c_device_config_t i2c_dev_config;
 
-extern i2c_master_bus_handle_t i2c_bus_handle;
-extern i2c_master_dev_handle_t i2c_dev_handle;
+/**
+ * @brief Sensor bus transfers issued through bme68x_i2c_read / bme68x_i2c_write
+ * 
+ */
+struct bme_i2c_stats
+{
+    uint32_t reads;
+    uint32_t writes;
+    uint32_t errors;            // transfers that returned an error
+    uint64_t bytes_read;
+    uint64_t bytes_written;     // register address byte included
+};
 
 
 int8_t bme68x_i2c_read(uint8_t, uint8_t*, uint32_t, void*);
 int8_t bme68x_i2c_write(uint8_t, const uint8_t*, uint32_t, void*);
+void bme_i2c_get_stats(struct bme_i2c_stats* stats);
 void initialize_i2c(void);
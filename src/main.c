@@ -13,6 +13,7 @@
 #include "project.h"
 
 
+static struct bme_sampler sensor_sampler;
 
 /**
  * @brief Task to toggle an LED to indicate system activity
@@ -56,22 +57,49 @@ void setup(void)
 }
 
 /**
- * @brief Task to sample sensor data and update the global sensor data
+ * @brief Publish the new fields of one sensor to its snapshot and sample history
+ *
+ * @details Runs on the acquisition task. Only the first sensor feeds the event stream.
+ * @param sensor
+ * @param fields
+ * @param ready_us time each field completed, the history timestamps
+ * @param n_fields
+ * @param arg unused
+ */
+static void publishFields(struct bme_sensor* sensor, const struct bme68x_data* fields, const int64_t* ready_us, uint8_t n_fields, void* arg)
+{
+    (void)arg;
+    for(uint8_t i = 0; i < n_fields; i++)
+    {
+        bme_snapshot_publish(&sensor->snapshot, &fields[i]);
+        bme_history_append(&sensor->history, &fields[i], (uint32_t)(ready_us[i] / 1000));
+        if(sensor->index == 0)
+        {
+            events_publish_sample(&sensor->snapshot);
+        }
+    }
+}
+
+/**
+ * @brief Task to sample sensor data and publish it to the sensor snapshots
  * 
- * @details This task will continously sample data from the BME sensor, and if available, update the global sensor data struct with the lastest. It uses a mutex to ensure safe access to the global data.
+ * @details This task collects fields from every BME sensor in windows of the sensor sampler, every BME_SAMPLE_PERIOD_MS. Within a window each sensor is read the moment its next field completes, and every new field is published, oldest first, to that sensor's snapshot and sample history. Each sample is timestamped in the history with the time its own field completed, as predicted from the sensor's measurement durations, not with the time it was read out. Readers copy the snapshot lock free, so nothing is held while the task waits on the sensor.
  * @param pvParameters 
  */
 void sampleDataTask(void *pvParameters)
 {
     (void)pvParameters;
+
+    if(bme_sampler_start(&sensor_sampler, xTaskGetCurrentTaskHandle(), BME_SAMPLE_PERIOD_MS) != ESP_OK)
+    {
+        ESP_LOGE(tag, "Failed to start the sensor sampler");
+        vTaskDelete(NULL);
+    }
+
     while(1)
     {
-        if(xSemaphoreTake(sensor_data_mutex, pdMS_TO_TICKS(100)) == pdTRUE)
-        {
-            measureBME680Data(&global_sensor_data);
-            xSemaphoreGive(sensor_data_mutex);
-        }
-        vTaskDelay(pdMS_TO_TICKS(100));
+        bme_sampler_wait(&sensor_sampler);
+        measureBME680Until(bme_sampler_next_deadline(&sensor_sampler), publishFields, NULL);
     }
 }
 
@@ -85,6 +113,6 @@ void app_main()
 
     start_webserver();
     xTaskCreate(aliveTask, "Alive LED Blink", 2048, NULL, tskIDLE_PRIORITY, NULL);
-    xTaskCreate(sampleDataTask, "Data Acquisition Task", 2048, NULL, tskIDLE_PRIORITY, NULL);
+    xTaskCreate(sampleDataTask, "Data Acquisition Task", 3072, NULL, tskIDLE_PRIORITY, NULL);     // driver read out and compensation run on this stack
     ESP_LOGI(tag, "Application complete");
 }
\ No newline at end of file
@@ -0,0 +1,7 @@
+#ifndef __HOST_DRIVER_I2C_H__
+#define __HOST_DRIVER_I2C_H__
+#include "driver/i2c_master.h"
+
+
+
+#endif /* __HOST_DRIVER_I2C_H__ */
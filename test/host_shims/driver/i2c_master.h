@@ -0,0 +1,59 @@
+#ifndef __HOST_DRIVER_I2C_MASTER_H__
+#define __HOST_DRIVER_I2C_MASTER_H__
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+/* Declared only: host tests talk to the simulator or a replayed trace, never to a bus */
+typedef int i2c_port_num_t;
+typedef int gpio_num_t;
+typedef struct i2c_master_bus_t* i2c_master_bus_handle_t;
+typedef struct i2c_master_dev_t* i2c_master_dev_handle_t;
+
+#define I2C_NUM_0               0
+#define I2C_NUM_1               1
+#define I2C_CLK_SRC_DEFAULT     0
+#define I2C_ADDR_BIT_7          0
+#define GPIO_NUM_21             21
+#define GPIO_NUM_22             22
+#define GPIO_NUM_32             32
+#define GPIO_NUM_33             33
+
+typedef struct
+{
+    i2c_port_num_t i2c_port;
+    gpio_num_t sda_io_num;
+    gpio_num_t scl_io_num;
+    int clk_source;
+    uint8_t glitch_ignore_cnt;
+    int intr_priority;
+    size_t trans_queue_depth;
+    struct
+    {
+        uint32_t enable_internal_pullup : 1;
+    } flags;
+} i2c_master_bus_config_t;
+
+typedef struct
+{
+    int dev_addr_length;
+    uint16_t device_address;
+    uint32_t scl_speed_hz;
+    uint32_t scl_wait_us;
+    struct
+    {
+        uint32_t disable_ack_check : 1;
+    } flags;
+} i2c_device_config_t;
+
+esp_err_t i2c_new_master_bus(const i2c_master_bus_config_t* config, i2c_master_bus_handle_t* bus);
+esp_err_t i2c_master_bus_add_device(i2c_master_bus_handle_t bus, const i2c_device_config_t* config, i2c_master_dev_handle_t* dev);
+esp_err_t i2c_master_probe(i2c_master_bus_handle_t bus, uint16_t address, int timeout_ms);
+esp_err_t i2c_master_transmit(i2c_master_dev_handle_t dev, const uint8_t* data, size_t len, int timeout_ms);
+esp_err_t i2c_master_transmit_receive(i2c_master_dev_handle_t dev, const uint8_t* tx, size_t tx_len, uint8_t* rx, size_t rx_len, int timeout_ms);
+
+
+
+#endif /* __HOST_DRIVER_I2C_MASTER_H__ */
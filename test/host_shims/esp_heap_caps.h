@@ -0,0 +1,36 @@
+#ifndef __HOST_ESP_HEAP_CAPS_H__
+#define __HOST_ESP_HEAP_CAPS_H__
+#include <stdint.h>
+#include <stdlib.h>
+
+/* The host has a single heap, every capability is served from it */
+#define MALLOC_CAP_8BIT         (1 << 2)
+#define MALLOC_CAP_SPIRAM       (1 << 10)
+#define MALLOC_CAP_INTERNAL     (1 << 11)
+
+static inline void* heap_caps_malloc(size_t size, uint32_t caps)
+{
+    (void)caps;
+    return malloc(size);
+}
+
+static inline void* heap_caps_calloc(size_t n, size_t size, uint32_t caps)
+{
+    (void)caps;
+    return calloc(n, size);
+}
+
+static inline size_t heap_caps_get_total_size(uint32_t caps)
+{
+    (void)caps;
+    return 4 * 1024 * 1024;     // as much as the WROVER's PSRAM
+}
+
+static inline void heap_caps_free(void* ptr)
+{
+    free(ptr);
+}
+
+
+
+#endif /* __HOST_ESP_HEAP_CAPS_H__ */
@@ -0,0 +1,15 @@
+#ifndef __HOST_ESP_LOG_H__
+#define __HOST_ESP_LOG_H__
+#include <stdio.h>
+#include "esp_err.h"
+
+/* Silent on the host, so test output stays readable. The arguments are still type checked */
+#define ESP_HOST_LOG(tag, ...)  do { (void)(tag); if(0) { printf(__VA_ARGS__); } } while(0)
+#define ESP_LOGE(tag, ...)      ESP_HOST_LOG(tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...)      ESP_HOST_LOG(tag, __VA_ARGS__)
+#define ESP_LOGI(tag, ...)      ESP_HOST_LOG(tag, __VA_ARGS__)
+#define ESP_LOGD(tag, ...)      ESP_HOST_LOG(tag, __VA_ARGS__)
+
+
+
+#endif /* __HOST_ESP_LOG_H__ */
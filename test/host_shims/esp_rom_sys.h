@@ -0,0 +1,14 @@
+#ifndef __HOST_ESP_ROM_SYS_H__
+#define __HOST_ESP_ROM_SYS_H__
+#include <stdint.h>
+#include <unistd.h>
+
+/* Weak, so a test on a virtual clock can advance it instead of sleeping */
+__attribute__((weak)) void esp_rom_delay_us(uint32_t us)
+{
+    usleep(us);
+}
+
+
+
+#endif /* __HOST_ESP_ROM_SYS_H__ */
@@ -0,0 +1,34 @@
+#ifndef __HOST_FREERTOS_H__
+#define __HOST_FREERTOS_H__
+/* Host build stand in for the ESP-IDF FreeRTOS headers: only what the firmware libraries use */
+#include <stdint.h>
+#include <stddef.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdTRUE                  1
+#define pdFALSE                 0
+#define pdPASS                  1
+#define portMAX_DELAY           UINT32_MAX
+#define configTICK_RATE_HZ      100
+#define portTICK_PERIOD_MS      (1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+#define tskIDLE_PRIORITY        0
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES   2
+
+/* Critical sections keep other cores and tasks out on the target. Host tests run a single writer, so they are empty */
+typedef struct
+{
+    int owner;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED    { 0 }
+#define portMUX_INITIALIZE(mux)         ((mux)->owner = 0)
+#define portENTER_CRITICAL(mux)         ((void)(mux))
+#define portEXIT_CRITICAL(mux)          ((void)(mux))
+
+
+
+#endif /* __HOST_FREERTOS_H__ */
@@ -0,0 +1,39 @@
+#ifndef __HOST_FREERTOS_SEMPHR_H__
+#define __HOST_FREERTOS_SEMPHR_H__
+#include <stdlib.h>
+#include <pthread.h>
+#include "freertos/FreeRTOS.h"
+
+/* Mutexes map onto pthread mutexes. Timeouts are not modelled, a take always waits */
+typedef pthread_mutex_t* SemaphoreHandle_t;
+
+static inline SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    SemaphoreHandle_t mutex = malloc(sizeof(pthread_mutex_t));
+    if(mutex != NULL)
+    {
+        pthread_mutex_init(mutex, NULL);
+    }
+    return mutex;
+}
+
+static inline BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t ticks)
+{
+    (void)ticks;
+    return (pthread_mutex_lock(mutex) == 0) ? pdTRUE : pdFALSE;
+}
+
+static inline BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex)
+{
+    return (pthread_mutex_unlock(mutex) == 0) ? pdTRUE : pdFALSE;
+}
+
+static inline void vSemaphoreDelete(SemaphoreHandle_t mutex)
+{
+    pthread_mutex_destroy(mutex);
+    free(mutex);
+}
+
+
+
+#endif /* __HOST_FREERTOS_SEMPHR_H__ */
@@ -0,0 +1,28 @@
+#ifndef __HOST_FREERTOS_TASK_H__
+#define __HOST_FREERTOS_TASK_H__
+#include <sched.h>
+#include <unistd.h>
+#include "freertos/FreeRTOS.h"
+
+typedef void* TaskHandle_t;
+
+#define taskYIELD()     sched_yield()
+
+/* Weak, so a test on a virtual clock can advance it instead of sleeping */
+__attribute__((weak)) void vTaskDelay(TickType_t ticks)
+{
+    usleep((useconds_t)ticks * portTICK_PERIOD_MS * 1000);
+}
+
+/* Declared only. Firmware code that needs them is not linked into the host tests */
+BaseType_t xTaskCreate(void (*task)(void*), const char* name, uint32_t stack, void* arg, UBaseType_t prio, TaskHandle_t* handle);
+void vTaskDelete(TaskHandle_t task);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+uint32_t ulTaskNotifyTakeIndexed(UBaseType_t index, BaseType_t clear, TickType_t ticks);
+BaseType_t xTaskNotifyGiveIndexed(TaskHandle_t task, UBaseType_t index);
+
+
+
+#endif /* __HOST_FREERTOS_TASK_H__ */
@@ -0,0 +1,247 @@
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include "esp_bme680.h"
+#include "bme68x_sim.h"
+
+#define WINDOW_US       250000      // BME_SAMPLE_PERIOD_MS of the firmware's sampler
+#define RUN_US          60000000
+
+
+extern int64_t virtual_now_us;
+
+/* The board: every sensor found on the buses is a simulator, reached through the firmware's own bus callbacks */
+struct bme_i2c_dev bme_i2c_devs[BME_I2C_MAX_DEVICES];
+uint8_t bme_i2c_n_devs;
+
+static struct bme68x_sim sims[BME_I2C_MAX_DEVICES];
+static int64_t completed_us[BME_I2C_MAX_DEVICES][256];     // when each meas_index last completed, per sensor
+static uint32_t n_recorded[BME_I2C_MAX_DEVICES];           // completions recorded in completed_us so far
+static uint32_t n_transfers;
+
+/**
+ * @brief What the fields of one sensor saw between completing and reaching the callback
+ *
+ */
+struct sensor_result
+{
+    uint32_t fields;
+    int64_t latency_sum_us;
+    int64_t latency_max_us;
+};
+
+static struct sensor_result results[BME_I2C_MAX_DEVICES];
+
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+/**
+ * @brief Record the completions the simulator made during a bus transfer, at the time the transfer ended
+ *
+ * @details At most one transfer time late, which is small against the waits being measured.
+ */
+static void record_completions(uint8_t index)
+{
+    struct bme68x_sim* sim = &sims[index];
+
+    while(n_recorded[index] < sim->n_measurements)
+    {
+        uint8_t meas_index = (uint8_t)(sim->meas_index - (sim->n_measurements - n_recorded[index]));
+        completed_us[index][meas_index] = (int64_t)sim->now_us;
+        n_recorded[index]++;
+    }
+}
+
+/**
+ * @brief Bring a simulator up to the virtual clock one completion at a time, so each is recorded at its exact time
+ *
+ */
+static struct bme68x_sim* sync_sim(void* intf_ptr)
+{
+    uint8_t index = (uint8_t)((struct bme_i2c_dev*)intf_ptr - bme_i2c_devs);
+    struct bme68x_sim* sim = &sims[index];
+
+    while((sim->mode != BME68X_SLEEP_MODE) && (sim->meas_end_us <= (uint64_t)virtual_now_us))
+    {
+        bme68x_sim_advance(sim, sim->meas_end_us - sim->now_us);
+        record_completions(index);
+    }
+    if(virtual_now_us > (int64_t)sim->now_us)
+    {
+        bme68x_sim_advance(sim, (uint64_t)virtual_now_us - sim->now_us);
+    }
+    return sim;
+}
+
+/* One bus for all sensors: a transfer takes the bus time the simulator charges for it */
+int8_t bme68x_i2c_read(uint8_t reg_addr, uint8_t* reg_data, uint32_t len, void* intf_ptr)
+{
+    struct bme68x_sim* sim = sync_sim(intf_ptr);
+    int8_t rslt = bme68x_sim_read(reg_addr, reg_data, len, sim);
+
+    record_completions((uint8_t)(sim - sims));
+    virtual_now_us = (int64_t)sim->now_us;
+    n_transfers++;
+    return rslt;
+}
+
+int8_t bme68x_i2c_write(uint8_t reg_addr, const uint8_t* reg_data, uint32_t len, void* intf_ptr)
+{
+    struct bme68x_sim* sim = sync_sim(intf_ptr);
+    int8_t rslt = bme68x_sim_write(reg_addr, reg_data, len, sim);
+
+    record_completions((uint8_t)(sim - sims));
+    virtual_now_us = (int64_t)sim->now_us;
+    n_transfers++;
+    return rslt;
+}
+
+/* The completion timer fires exactly on time */
+esp_err_t bme_notify_init(struct bme_notify* notify)
+{
+    memset(notify, 0, sizeof(struct bme_notify));
+    return ESP_OK;
+}
+
+uint8_t bme_notify_wait_until(struct bme_notify* notify, int64_t ready_us)
+{
+    (void)notify;
+    if(ready_us <= virtual_now_us)
+    {
+        return BME_NOTIFY_SKIPPED;
+    }
+    virtual_now_us = ready_us;
+    return BME_NOTIFY_WOKEN;
+}
+
+static void collect(struct bme_sensor* sensor, const struct bme68x_data* fields, const int64_t* ready_us, uint8_t n_fields, void* arg)
+{
+    struct sensor_result* result = &results[sensor->index];
+
+    (void)ready_us;
+    (void)arg;
+    for(uint8_t i = 0; i < n_fields; i++)
+    {
+        int64_t latency_us = virtual_now_us - completed_us[sensor->index][fields[i].meas_index];
+
+        result->fields++;
+        result->latency_sum_us += latency_us;
+        if(latency_us > result->latency_max_us)
+        {
+            result->latency_max_us = latency_us;
+        }
+    }
+}
+
+/**
+ * @brief Run n_sensors through RUN_US of sampler windows the way the acquisition task does, and print what each got
+ *
+ * @param until 1 for measureBME680Until, 0 for one measureBME680All per window
+ * @param rate_per_s samples per second of the slowest sensor
+ * @param max_latency_us largest delay of any field from completing to reaching the callback
+ */
+static void run_board(uint8_t n_sensors, uint8_t until, double* rate_per_s, int64_t* max_latency_us)
+{
+    int64_t start_us, deadline_us;
+    uint32_t transfers_before, total = 0;
+    double seconds;
+
+    memset(sims, 0, sizeof(sims));
+    memset(n_recorded, 0, sizeof(n_recorded));
+    memset(results, 0, sizeof(results));
+    virtual_now_us = 0;
+    bme_i2c_n_devs = n_sensors;
+    for(uint8_t i = 0; i < n_sensors; i++)
+    {
+        bme68x_sim_init(&sims[i], BME68X_VARIANT_GAS_LOW, &bme68x_sim_default_calib);
+    }
+    initializeBME680();
+    TEST_ASSERT_EQUAL_UINT8(n_sensors, bmeSensorCount());
+
+    start_us = virtual_now_us;
+    deadline_us = start_us;
+    transfers_before = n_transfers;
+    while(virtual_now_us < (start_us + RUN_US))
+    {
+        deadline_us += WINDOW_US;
+        if(until)
+        {
+            measureBME680Until(deadline_us, collect, NULL);
+        }
+        if(virtual_now_us < deadline_us)
+        {
+            virtual_now_us = deadline_us;   // the sampler's wait for the next window
+        }
+        if(!until)
+        {
+            measureBME680All(collect, NULL);
+        }
+    }
+    seconds = (double)(virtual_now_us - start_us) / 1e6;
+
+    *rate_per_s = 1e9;
+    *max_latency_us = 0;
+    printf("%u sensor(s), %s:", (unsigned)n_sensors, until ? "measureBME680Until" : "measureBME680All");
+    for(uint8_t i = 0; i < n_sensors; i++)
+    {
+        struct sensor_result* result = &results[i];
+
+        TEST_ASSERT_TRUE(result->fields > 0);
+        printf(" [%u] %.2f/s latency mean %.2f max %.2f ms", (unsigned)i, result->fields / seconds,
+            (result->latency_sum_us / 1000.0) / result->fields, result->latency_max_us / 1000.0);
+        total += result->fields;
+        *rate_per_s = (result->fields / seconds < *rate_per_s) ? result->fields / seconds : *rate_per_s;
+        *max_latency_us = (result->latency_max_us > *max_latency_us) ? result->latency_max_us : *max_latency_us;
+    }
+    printf(", total %.2f samples/s, %.1f transfers/s\n", total / seconds, (n_transfers - transfers_before) / seconds);
+}
+
+/**
+ * @brief Read completion driven, every sensor keeps the rate and read latency it has alone, however many share the bus
+ *
+ */
+static void test_rate_and_latency_vs_sensor_count(void)
+{
+    double single_rate, rate;
+    int64_t single_latency_us, latency_us;
+
+    run_board(1, 1, &single_rate, &single_latency_us);
+    TEST_ASSERT_TRUE(single_rate > 5.0);
+    for(uint8_t n_sensors = 2; n_sensors <= BME_MAX_SENSORS; n_sensors++)
+    {
+        run_board(n_sensors, 1, &rate, &latency_us);
+        TEST_ASSERT_DOUBLE_WITHIN(single_rate * 0.02, single_rate, rate);
+        // Sensors completing together are read one after the other, a few read outs at most
+        TEST_ASSERT_TRUE(latency_us <= single_latency_us + (n_sensors * 2000));
+    }
+}
+
+/**
+ * @brief For comparison, one read of every sensor per window: the buffered fields wait up to a whole window
+ *
+ */
+static void test_polled_rate_and_latency_vs_sensor_count(void)
+{
+    double rate;
+    int64_t latency_us;
+
+    for(uint8_t n_sensors = 1; n_sensors <= BME_MAX_SENSORS; n_sensors++)
+    {
+        run_board(n_sensors, 0, &rate, &latency_us);
+        TEST_ASSERT_TRUE(rate > 0.0);
+    }
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_rate_and_latency_vs_sensor_count);
+    RUN_TEST(test_polled_rate_and_latency_vs_sensor_count);
+    return UNITY_END();
+}
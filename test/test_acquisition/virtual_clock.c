@@ -0,0 +1,22 @@
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+
+/* The firmware's time sources, replacing the weak ones of the host shims. Time only moves when the code under test
+ * waits or, through the simulated bus, transfers. Kept apart from test_main.c, which sees the shims' definitions */
+int64_t virtual_now_us;
+
+
+int64_t esp_timer_get_time(void)
+{
+    return virtual_now_us;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    virtual_now_us += (int64_t)ticks * portTICK_PERIOD_MS * 1000;
+}
+
+void esp_rom_delay_us(uint32_t us)
+{
+    virtual_now_us += us;
+}
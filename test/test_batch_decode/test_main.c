@@ -0,0 +1,160 @@
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include "bme68x.h"
+#include "bme68x_sim.h"
+
+#define PROFILE_LEN     10
+#define N_ROUNDS        100
+
+
+static struct bme68x_sim sim;
+static struct bme68x_dev dev;
+static struct bme68x_conf conf;
+static uint16_t temp_prof[PROFILE_LEN] = { 200, 240, 280, 320, 360, 360, 320, 280, 240, 200 };
+static uint16_t dur_prof[PROFILE_LEN];
+
+
+void setUp(void)
+{
+    struct bme68x_sim_env env = { 23.5, 98765.0, 55.0, 40000.0 };
+
+    bme68x_sim_init(&sim, BME68X_VARIANT_GAS_LOW, &bme68x_sim_default_calib);
+    bme68x_sim_attach(&sim, &dev);
+    bme68x_sim_set_env(&sim, &env);
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_init(&dev));
+
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_get_conf(&conf, &dev));
+    conf.os_temp = BME68X_OS_2X;
+    conf.os_pres = BME68X_OS_16X;
+    conf.os_hum = BME68X_OS_1X;
+    conf.filter = BME68X_FILTER_OFF;
+    conf.odr = BME68X_ODR_NONE;
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_set_conf(&conf, &dev));
+}
+
+void tearDown(void)
+{
+}
+
+/**
+ * @brief Read the same sensor state both ways and require the same fields
+ *
+ * @details The simulator and device are cloned, one copy is read with bme68x_get_data, the other with
+ * bme68x_get_raw_fields and bme68x_decode_raw_fields. Without the shadow the decoder has no heater settings and leaves
+ * them 0, everything else must match to the bit.
+ *
+ * @return uint8_t number of fields read
+ */
+static uint8_t compare_paths(uint8_t op_mode, uint32_t* get_data_reads, uint32_t* raw_reads)
+{
+    static struct bme68x_sim sim_raw;
+    struct bme68x_dev dev_raw;
+    struct bme68x_data fields[BME68X_SIM_N_FIELDS] = { 0 };
+    struct bme68x_data decoded[BME68X_SIM_N_FIELDS] = { 0 };
+    struct bme68x_raw_data raw[BME68X_SIM_N_FIELDS];
+    uint8_t n_fields = 0, n_raw = 0;
+    uint32_t reads_before = sim.n_reads;
+    int8_t rslt, rslt_raw;
+
+    memcpy(&sim_raw, &sim, sizeof(sim));
+    memcpy(&dev_raw, &dev, sizeof(dev));
+    dev_raw.intf_ptr = &sim_raw;
+
+    rslt = bme68x_get_data(op_mode, fields, &n_fields, &dev);
+    rslt_raw = bme68x_get_raw_fields(op_mode, raw, &n_raw, &dev_raw);
+    if(rslt_raw == BME68X_OK)
+    {
+        rslt_raw = bme68x_decode_raw_fields(raw, decoded, n_raw, &dev_raw);
+    }
+    *get_data_reads += sim.n_reads - reads_before;
+    *raw_reads += sim_raw.n_reads - reads_before;
+
+    TEST_ASSERT_EQUAL_INT8(rslt, rslt_raw);
+    TEST_ASSERT_EQUAL_UINT8(n_fields, n_raw);
+    for(uint8_t i = 0; i < n_fields; i++)
+    {
+        if(!dev.shadow_valid)
+        {
+            TEST_ASSERT_EQUAL_UINT8(0, decoded[i].idac);
+            TEST_ASSERT_EQUAL_UINT8(0, decoded[i].res_heat);
+            TEST_ASSERT_EQUAL_UINT8(0, decoded[i].gas_wait);
+            decoded[i].idac = fields[i].idac;
+            decoded[i].res_heat = fields[i].res_heat;
+            decoded[i].gas_wait = fields[i].gas_wait;
+        }
+        TEST_ASSERT_EQUAL_MEMORY(&fields[i], &decoded[i], sizeof(struct bme68x_data));
+    }
+    return n_fields;
+}
+
+static void run_mode(uint8_t op_mode, uint8_t shadow)
+{
+    struct bme68x_heatr_conf heatr_conf = {
+        .enable = BME68X_ENABLE, .heatr_temp = 300, .heatr_dur = 100,
+        .heatr_temp_prof = temp_prof, .heatr_dur_prof = dur_prof, .profile_len = PROFILE_LEN
+    };
+    uint32_t period_us = 250000;
+    uint32_t get_data_reads = 0, raw_reads = 0, n_fields = 0;
+
+    if(shadow)
+    {
+        TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_enable_shadow(0, &dev));
+    }
+    for(uint8_t i = 0; i < PROFILE_LEN; i++)
+    {
+        dur_prof[i] = (op_mode == BME68X_PARALLEL_MODE) ? 5 : 100;
+    }
+    if(op_mode == BME68X_PARALLEL_MODE)
+    {
+        heatr_conf.shared_heatr_dur = 140 - (bme68x_get_meas_dur(BME68X_PARALLEL_MODE, &conf, &dev) / 1000);
+        period_us = 1500000;
+    }
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_set_heatr_conf(op_mode, &heatr_conf, &dev));
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_set_op_mode(op_mode, &dev));
+
+    for(uint16_t round = 0; round < N_ROUNDS; round++)
+    {
+        bme68x_sim_advance(&sim, period_us);
+        n_fields += compare_paths(op_mode, &get_data_reads, &raw_reads);
+        if(op_mode == BME68X_FORCED_MODE)
+        {
+            TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_set_op_mode(BME68X_FORCED_MODE, &dev));
+        }
+    }
+
+    printf("mode %u, shadow %u: %lu fields, bus reads get_data %lu, raw %lu\n", (unsigned)op_mode, (unsigned)shadow,
+        (unsigned long)n_fields, (unsigned long)get_data_reads, (unsigned long)raw_reads);
+    TEST_ASSERT_TRUE(n_fields >= N_ROUNDS);
+    TEST_ASSERT_TRUE(raw_reads <= get_data_reads);
+}
+
+static void test_forced_batch_decode_matches_get_data(void)
+{
+    run_mode(BME68X_FORCED_MODE, 0);
+}
+
+static void test_sequential_batch_decode_matches_get_data(void)
+{
+    run_mode(BME68X_SEQUENTIAL_MODE, 0);
+}
+
+static void test_parallel_batch_decode_matches_get_data(void)
+{
+    run_mode(BME68X_PARALLEL_MODE, 0);
+}
+
+static void test_shadowed_batch_decode_matches_get_data(void)
+{
+    run_mode(BME68X_SEQUENTIAL_MODE, 1);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_forced_batch_decode_matches_get_data);
+    RUN_TEST(test_sequential_batch_decode_matches_get_data);
+    RUN_TEST(test_parallel_batch_decode_matches_get_data);
+    RUN_TEST(test_shadowed_batch_decode_matches_get_data);
+    return UNITY_END();
+}
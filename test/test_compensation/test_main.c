@@ -0,0 +1,352 @@
+#include <unity.h>
+#include <string.h>
+#include <time.h>
+#include "bme68x.h"
+#include "bme68x_sim.h"
+
+#define BENCH_SAMPLES   4096
+#define BENCH_ROUNDS    200
+
+
+/**
+ * @brief One raw measurement and what the unmodified Bosch driver compensates it to
+ *
+ * @details The expected values were produced by calc_temperature, calc_pressure, calc_humidity and
+ * calc_gas_resistance_low/high of the driver as imported, before the calibration derived terms were cached, with the
+ * simulator's default calibration. Rows 0 to 3 of each variant are room conditions, all zero words, all ones words
+ * and a cold dry reading; the rest are pseudo random words over the sensor's working range.
+ */
+struct golden
+{
+    uint8_t variant_id;
+    uint32_t temp_adc;
+    uint32_t pres_adc;
+    uint16_t hum_adc;
+    uint16_t gas_adc;
+    uint8_t gas_range;
+#ifndef BME68X_USE_FPU
+    int16_t temperature;
+    uint32_t pressure;
+    uint32_t humidity;
+    uint32_t gas_resistance;
+#else
+    float temperature;
+    float pressure;
+    float humidity;
+    float gas_resistance;
+#endif
+};
+
+#ifndef BME68X_USE_FPU
+static const struct golden vectors[] = {
+    { 0, 500000, 400000, 25000, 512, 5, 2583, 92356, 68356, 248262 },
+    { 0, 0, 0, 0, 0, 0, -13124, 42301, 0, 12946860 },
+    { 0, 1048575, 1048575, 65535, 1023, 15, 19846, 4294949222, 100000, 177 },
+    { 0, 350000, 250000, 15000, 100, 10, -2132, 107341, 9596, 11291 },
+    { 0, 584438, 345575, 20588, 662, 12, 5238, 106108, 43595, 1757 },
+    { 0, 407618, 442511, 12013, 631, 3, -321, 81095, 0, 918437 },
+    { 0, 425508, 437487, 18226, 822, 9, 241, 82687, 25451, 12689 },
+    { 0, 586361, 504283, 23078, 488, 7, 5298, 77754, 59896, 64162 },
+    { 0, 385692, 504640, 18622, 212, 2, -1011, 70112, 26791, 2576923 },
+    { 0, 425376, 531110, 36686, 408, 2, 237, 67228, 100000, 2168285 },
+    { 0, 464734, 545663, 30235, 769, 0, 1474, 66174, 100000, 6712586 },
+    { 0, 610579, 322663, 30506, 697, 8, 6060, 109590, 100000, 27487 },
+    { 0, 458040, 337961, 39173, 648, 10, 1264, 100861, 100000, 7091 },
+    { 0, 541514, 486911, 25984, 456, 8, 3888, 79086, 77595, 32646 },
+    { 0, 417828, 381948, 38063, 336, 0, -1, 91510, 100000, 9209622 },
+    { 0, 407735, 499739, 13934, 751, 14, -318, 71734, 5453, 414 },
+    { 0, 505383, 507726, 12140, 317, 1, 2752, 74080, 0, 4681223 },
+    { 0, 401195, 544788, 38336, 355, 2, -523, 64149, 100000, 2265427 },
+    { 0, 663219, 429043, 20474, 527, 5, 7716, 94644, 46358, 245486 },
+    { 0, 631601, 376913, 25310, 453, 7, 6721, 102793, 78441, 65930 },
+    { 0, 568965, 229530, 18529, 577, 2, 4751, 4255, 30669, 1907473 },
+    { 0, 338032, 514979, 25690, 900, 12, -2508, 66716, 67086, 1515 },
+    { 0, 376199, 528815, 25255, 746, 11, -1309, 65872, 65085, 3323 },
+    { 0, 326028, 269990, 13541, 313, 13, -2885, 104837, 3648, 1149 },
+    { 1, 500000, 400000, 25000, 512, 5, 2583, 92356, 68356, 2000000 },
+    { 1, 0, 0, 0, 0, 0, -13124, 42301, 0, 102400000 },
+    { 1, 1048575, 1048575, 65535, 1023, 15, 19846, 4294949222, 100000, 1400 },
+    { 1, 350000, 250000, 15000, 100, 10, -2132, 107341, 9596, 89500 },
+    { 1, 450606, 231098, 32270, 670, 11, 1030, 3588, 100000, 28000 },
+    { 1, 529669, 361893, 29962, 9, 2, 3515, 100409, 100000, 25332800 },
+    { 1, 652764, 358718, 28211, 844, 13, 7387, 105165, 100000, 6200 },
+    { 1, 488598, 508278, 10256, 517, 13, 2224, 73355, 0, 7700 },
+    { 1, 672574, 306458, 35664, 800, 6, 8010, 115986, 100000, 825800 },
+    { 1, 439830, 545497, 16187, 907, 15, 691, 65349, 15669, 1500 },
+    { 1, 388781, 589034, 22186, 98, 8, -913, 56574, 46391, 358700 },
+    { 1, 663384, 378844, 17243, 934, 3, 7721, 104002, 26000, 6111100 },
+    { 1, 510352, 438373, 13474, 85, 0, 2908, 86221, 3947, 93123900 },
+    { 1, 664590, 320697, 32362, 873, 0, 7759, 112878, 100000, 50616700 },
+    { 1, 389047, 329536, 20263, 280, 8, -905, 98672, 35497, 301100 },
+    { 1, 607521, 443830, 25985, 87, 10, 5964, 89482, 81867, 90700 },
+    { 1, 683329, 591625, 23810, 647, 5, 8348, 65148, 70684, 1820000 },
+    { 1, 524058, 337666, 12387, 446, 1, 3339, 104352, 0, 33625400 },
+    { 1, 563702, 269708, 24455, 537, 9, 4586, 116519, 68095, 122700 },
+    { 1, 342652, 306974, 34272, 278, 15, -2363, 99876, 100000, 2300 },
+    { 1, 423213, 265136, 10346, 451, 0, 169, 109117, 0, 66993000 },
+    { 1, 556454, 413232, 24514, 357, 13, 4358, 92675, 68089, 8800 },
+    { 1, 533414, 264153, 29846, 467, 6, 3633, 115723, 100000, 1034000 },
+    { 1, 670132, 589680, 11058, 413, 14, 7933, 65108, 0, 4200 },
+};
+#else
+static const struct golden vectors[] = {
+    { 0, 500000, 400000, 25000, 512, 5, 25.8271637f, 92361.2812f, 68.3751831f, 248262.188f },
+    { 0, 0, 0, 0, 0, 0, -131.234848f, 123643.266f, 0.0f, 12946861.0f },
+    { 0, 1048575, 1048575, 65535, 1023, 15, 198.461639f, -23011.0645f, 0.0f, 176.741455f },
+    { 0, 350000, 250000, 15000, 100, 10, -21.3200893f, 109391.203f, 9.59737968f, 11291.0264f },
+    { 0, 584438, 345575, 20588, 662, 12, 52.3780937f, 106107.898f, 43.6061134f, 1756.50171f },
+    { 0, 407618, 442511, 12013, 631, 3, -3.21279144f, 81093.9844f, 0.0f, 918437.312f },
+    { 0, 425508, 437487, 18226, 822, 9, 2.4101398f, 82687.2109f, 25.4591942f, 12689.3936f },
+    { 0, 586361, 504283, 23078, 488, 7, 52.9828606f, 77757.9062f, 59.9192276f, 64162.4805f },
+    { 0, 385692, 504640, 18622, 212, 2, -10.1037846f, 70111.1328f, 26.7945309f, 2576923.0f },
+    { 0, 425376, 531110, 36686, 408, 2, 2.36864996f, 67228.9609f, 100.0f, 2168284.75f },
+    { 0, 464734, 545663, 30235, 769, 0, 14.7403212f, 66176.3594f, 100.0f, 6712586.0f },
+    { 0, 610579, 322663, 30506, 697, 8, 60.5995293f, 111643.953f, 100.0f, 27486.502f },
+    { 0, 458040, 337961, 39173, 648, 10, 12.6360321f, 100860.477f, 100.0f, 7091.33936f },
+    { 0, 541514, 486911, 25984, 456, 8, 38.8799782f, 79084.9922f, 77.6062012f, 32645.5723f },
+    { 0, 417828, 381948, 38063, 336, 0, -0.00377168646f, 91512.6328f, 100.0f, 9209622.0f },
+    { 0, 407735, 499739, 13934, 751, 14, -3.17601871f, 71734.1641f, 5.45458937f, 414.374237f },
+    { 0, 505383, 507726, 12140, 317, 1, 27.519577f, 74082.75f, 0.0f, 4681222.5f },
+    { 0, 401195, 544788, 38336, 355, 2, -5.23149252f, 64151.0117f, 100.0f, 2265427.0f },
+    { 0, 663219, 429043, 20474, 527, 5, 77.1572418f, 94648.0f, 46.3692551f, 245486.438f },
+    { 0, 631601, 376913, 25310, 453, 7, 67.2115555f, 102798.148f, 78.4771042f, 65930.3516f },
+    { 0, 568965, 229530, 18529, 577, 2, 47.5121384f, 126098.758f, 30.6736698f, 1907473.38f },
+    { 0, 338032, 514979, 25690, 900, 12, -25.0807533f, 66717.7969f, 67.1039581f, 1514.57617f },
+    { 0, 376199, 528815, 25255, 746, 11, -13.0871201f, 65870.9062f, 65.1062469f, 3323.0415f },
+    { 0, 326028, 269990, 13541, 313, 13, -28.8525753f, 104839.094f, 3.64916587f, 1148.90735f },
+    { 1, 500000, 400000, 25000, 512, 5, 25.8271637f, 92361.2812f, 68.3751831f, 2000000.0f },
+    { 1, 0, 0, 0, 0, 0, -131.234848f, 123643.266f, 0.0f, 102400000.0f },
+    { 1, 1048575, 1048575, 65535, 1023, 15, 198.461639f, -23011.0645f, 0.0f, 1421.21155f },
+    { 1, 350000, 250000, 15000, 100, 10, -21.3200893f, 109391.203f, 9.59737968f, 89510.4922f },
+    { 1, 450606, 231098, 32270, 670, 11, 10.2991762f, 118509.297f, 100.0f, 28008.752f },
+    { 1, 529669, 361893, 29962, 9, 2, 35.1554832f, 100411.383f, 100.0f, 25332818.0f },
+    { 1, 652764, 358718, 28211, 844, 13, 73.8684235f, 107217.062f, 100.0f, 6284.36768f },
+    { 1, 488598, 508278, 10256, 517, 13, 22.2424812f, 73356.9453f, 0.0f, 7783.99414f },
+    { 1, 672574, 306458, 35664, 800, 6, 80.1001434f, 118039.602f, 100.0f, 825806.438f },
+    { 1, 439830, 545497, 16187, 907, 15, 6.91187954f, 65351.457f, 15.6730919f, 1514.86462f },
+    { 1, 388781, 589034, 22186, 98, 8, -9.13299274f, 56576.6055f, 46.3938866f, 358794.688f },
+    { 1, 663384, 378844, 17243, 934, 3, 77.2091522f, 104001.102f, 26.0048466f, 6111152.5f },
+    { 1, 510352, 438373, 13474, 85, 0, 29.0818577f, 86220.0078f, 3.94803643f, 93123976.0f },
+    { 1, 664590, 320697, 32362, 873, 0, 77.5885315f, 114929.062f, 100.0f, 50616720.0f },
+    { 1, 389047, 329536, 20263, 280, 8, -9.04939461f, 98676.3828f, 35.503952f, 301176.469f },
+    { 1, 607521, 443830, 25985, 87, 10, 59.6377449f, 89486.4375f, 81.8894348f, 90747.9609f },
+    { 1, 683329, 591625, 23810, 647, 5, 83.4835663f, 65149.0039f, 70.7012558f, 1820040.0f },
+    { 1, 524058, 337666, 12387, 446, 1, 33.3912392f, 104356.75f, 0.0f, 33625448.0f },
+    { 1, 563702, 269708, 24455, 537, 9, 45.8570862f, 118570.812f, 68.1120987f, 122752.336f },
+    { 1, 342652, 306974, 34272, 278, 15, -23.6290455f, 99875.1875f, 100.0f, 2357.10083f },
+    { 1, 423213, 265136, 10346, 451, 0, 1.68878841f, 111162.727f, 0.0f, 66993100.0f },
+    { 1, 556454, 413232, 24514, 357, 13, 43.5778656f, 92675.8672f, 68.106926f, 8812.99902f },
+    { 1, 533414, 264153, 29846, 467, 6, 36.3330307f, 117775.602f, 100.0f, 1034082.31f },
+    { 1, 670132, 589680, 11058, 413, 14, 79.3319244f, 65106.7461f, 0.0f, 4211.63477f },
+};
+#endif
+
+#define N_VECTORS   (sizeof(vectors) / sizeof(vectors[0]))
+
+
+static struct bme68x_sim sim;
+static struct bme68x_dev dev;
+
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+static void init_variant(uint8_t variant_id)
+{
+    bme68x_sim_init(&sim, variant_id, &bme68x_sim_default_calib);
+    bme68x_sim_attach(&sim, &dev);
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_init(&dev));
+}
+
+/**
+ * @brief Field register image the sensor would hold for a golden row
+ *
+ */
+static void pack_field(const struct golden* g, struct bme68x_raw_data* raw)
+{
+    uint8_t gas_off = (g->variant_id == BME68X_VARIANT_GAS_HIGH) ? 15 : 13;
+
+    memset(raw, 0, sizeof(struct bme68x_raw_data));
+    raw->field[0] = BME68X_NEW_DATA_MSK;
+    raw->field[2] = (uint8_t)(g->pres_adc >> 12);
+    raw->field[3] = (uint8_t)(g->pres_adc >> 4);
+    raw->field[4] = (uint8_t)((g->pres_adc & 0x0F) << 4);
+    raw->field[5] = (uint8_t)(g->temp_adc >> 12);
+    raw->field[6] = (uint8_t)(g->temp_adc >> 4);
+    raw->field[7] = (uint8_t)((g->temp_adc & 0x0F) << 4);
+    raw->field[8] = (uint8_t)(g->hum_adc >> 8);
+    raw->field[9] = (uint8_t)g->hum_adc;
+    raw->field[gas_off] = (uint8_t)(g->gas_adc >> 2);
+    raw->field[gas_off + 1] = (uint8_t)(((g->gas_adc & 0x03) << 6) | BME68X_GASM_VALID_MSK | g->gas_range);
+}
+
+#ifndef BME68X_USE_FPU
+static void check_values(const struct golden* g, int16_t temperature, uint32_t pressure, uint32_t humidity, uint32_t gas_resistance)
+{
+    TEST_ASSERT_EQUAL_INT16(g->temperature, temperature);
+    TEST_ASSERT_EQUAL_UINT32(g->pressure, pressure);
+    TEST_ASSERT_EQUAL_UINT32(g->humidity, humidity);
+    TEST_ASSERT_EQUAL_UINT32(g->gas_resistance, gas_resistance);
+}
+#else
+/* The float build may round differently now that constant terms are folded, by a few ulp */
+#define FLOAT_MATCH(expected, actual) TEST_ASSERT_FLOAT_WITHIN(1e-5f + (((expected) < 0 ? -(expected) : (expected)) * 1e-5f), expected, actual)
+
+static void check_values(const struct golden* g, float temperature, float pressure, float humidity, float gas_resistance)
+{
+    FLOAT_MATCH(g->temperature, temperature);
+    FLOAT_MATCH(g->pressure, pressure);
+    FLOAT_MATCH(g->humidity, humidity);
+    FLOAT_MATCH(g->gas_resistance, gas_resistance);
+}
+#endif
+
+/**
+ * @brief bme68x_compensate_batch over all rows of a variant at once must give the golden values
+ *
+ */
+static void test_batch_matches_golden(void)
+{
+    for(uint8_t variant_id = BME68X_VARIANT_GAS_LOW; variant_id <= BME68X_VARIANT_GAS_HIGH; variant_id++)
+    {
+        uint32_t temp_adc[N_VECTORS], pres_adc[N_VECTORS];
+        uint16_t hum_adc[N_VECTORS], gas_adc[N_VECTORS];
+        uint8_t gas_range[N_VECTORS];
+        const struct golden* rows[N_VECTORS];
+        struct bme68x_raw_batch raw = { temp_adc, pres_adc, hum_adc, gas_adc, gas_range };
+        struct bme68x_comp_batch comp;
+        uint32_t n = 0;
+#ifndef BME68X_USE_FPU
+        int16_t temperature[N_VECTORS];
+        uint32_t pressure[N_VECTORS], humidity[N_VECTORS], gas_resistance[N_VECTORS];
+#else
+        float temperature[N_VECTORS], pressure[N_VECTORS], humidity[N_VECTORS], gas_resistance[N_VECTORS];
+#endif
+
+        init_variant(variant_id);
+        for(uint32_t i = 0; i < N_VECTORS; i++)
+        {
+            if(vectors[i].variant_id == variant_id)
+            {
+                rows[n] = &vectors[i];
+                temp_adc[n] = vectors[i].temp_adc;
+                pres_adc[n] = vectors[i].pres_adc;
+                hum_adc[n] = vectors[i].hum_adc;
+                gas_adc[n] = vectors[i].gas_adc;
+                gas_range[n] = vectors[i].gas_range;
+                n++;
+            }
+        }
+        TEST_ASSERT_TRUE(n > 0);
+
+        comp.temperature = temperature;
+        comp.pressure = pressure;
+        comp.humidity = humidity;
+        comp.gas_resistance = gas_resistance;
+        TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_compensate_batch(&raw, &comp, n, &dev));
+        for(uint32_t i = 0; i < n; i++)
+        {
+            check_values(rows[i], temperature[i], pressure[i], humidity[i], gas_resistance[i]);
+        }
+    }
+}
+
+/**
+ * @brief Each row packed into field registers and decoded on its own must give the golden values too
+ *
+ */
+static void test_decoded_field_matches_golden(void)
+{
+    for(uint32_t i = 0; i < N_VECTORS; i++)
+    {
+        struct bme68x_raw_data raw;
+        struct bme68x_data data;
+
+        if((i == 0) || (vectors[i].variant_id != vectors[i - 1].variant_id))
+        {
+            init_variant(vectors[i].variant_id);
+        }
+        pack_field(&vectors[i], &raw);
+        TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_decode_raw_fields(&raw, &data, 1, &dev));
+        TEST_ASSERT_BITS_HIGH(BME68X_NEW_DATA_MSK | BME68X_GASM_VALID_MSK, data.status);
+        check_values(&vectors[i], data.temperature, data.pressure, data.humidity, data.gas_resistance);
+    }
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ((double)ts.tv_nsec / 1e9);
+}
+
+/**
+ * @brief Time the compensation with the cached calibration terms against working them out for every sample
+ *
+ * @details bme68x_derive_calib before each sample stands in for the driver before the terms were cached. Reported,
+ * not asserted.
+ */
+static void test_compensation_benchmark(void)
+{
+    static uint32_t temp_adc[BENCH_SAMPLES], pres_adc[BENCH_SAMPLES];
+    static uint16_t hum_adc[BENCH_SAMPLES], gas_adc[BENCH_SAMPLES];
+    static uint8_t gas_range[BENCH_SAMPLES];
+#ifndef BME68X_USE_FPU
+    static int16_t temperature[BENCH_SAMPLES];
+    static uint32_t pressure[BENCH_SAMPLES], humidity[BENCH_SAMPLES], gas_resistance[BENCH_SAMPLES];
+#else
+    static float temperature[BENCH_SAMPLES], pressure[BENCH_SAMPLES], humidity[BENCH_SAMPLES], gas_resistance[BENCH_SAMPLES];
+#endif
+    struct bme68x_raw_batch raw = { temp_adc, pres_adc, hum_adc, gas_adc, gas_range };
+    struct bme68x_comp_batch comp = { temperature, pressure, humidity, gas_resistance };
+    double start_s, cached_s, derived_s;
+
+    init_variant(BME68X_VARIANT_GAS_LOW);
+    for(uint32_t i = 0; i < BENCH_SAMPLES; i++)
+    {
+        const struct golden* g = &vectors[i % N_VECTORS];
+        temp_adc[i] = g->temp_adc;
+        pres_adc[i] = g->pres_adc;
+        hum_adc[i] = g->hum_adc;
+        gas_adc[i] = g->gas_adc;
+        gas_range[i] = g->gas_range;
+    }
+
+    start_s = now_s();
+    for(uint32_t round = 0; round < BENCH_ROUNDS; round++)
+    {
+        bme68x_compensate_batch(&raw, &comp, BENCH_SAMPLES, &dev);
+    }
+    cached_s = now_s() - start_s;
+
+    start_s = now_s();
+    for(uint32_t round = 0; round < BENCH_ROUNDS; round++)
+    {
+        for(uint32_t i = 0; i < BENCH_SAMPLES; i++)
+        {
+            struct bme68x_raw_batch one = { &temp_adc[i], &pres_adc[i], &hum_adc[i], &gas_adc[i], &gas_range[i] };
+            struct bme68x_comp_batch out = { &temperature[i], &pressure[i], &humidity[i], &gas_resistance[i] };
+            bme68x_derive_calib(&dev);
+            bme68x_compensate_batch(&one, &out, 1, &dev);
+        }
+    }
+    derived_s = now_s() - start_s;
+
+    printf("compensation: cached terms, batched %.1f ns/sample, terms derived per sample %.1f ns/sample\n",
+        (cached_s * 1e9) / ((double)BENCH_SAMPLES * BENCH_ROUNDS), (derived_s * 1e9) / ((double)BENCH_SAMPLES * BENCH_ROUNDS));
+    TEST_ASSERT_TRUE(cached_s > 0);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_batch_matches_golden);
+    RUN_TEST(test_decoded_field_matches_golden);
+    RUN_TEST(test_compensation_benchmark);
+    return UNITY_END();
+}
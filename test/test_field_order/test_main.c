@@ -0,0 +1,199 @@
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "bme68x.h"
+#include "bme68x_sim.h"
+
+#define BENCH_READS     200000
+
+
+static struct bme68x_sim sim;
+static struct bme68x_dev dev;
+
+/* Every order three field buffers can be filled in */
+static const uint8_t placements[6][BME68X_N_FIELDS] = {
+    { 0, 1, 2 }, { 1, 2, 0 }, { 2, 0, 1 }, { 0, 2, 1 }, { 2, 1, 0 }, { 1, 0, 2 }
+};
+
+
+void setUp(void)
+{
+    bme68x_sim_init(&sim, BME68X_VARIANT_GAS_LOW, &bme68x_sim_default_calib);
+    bme68x_sim_attach(&sim, &dev);
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_init(&dev));
+}
+
+void tearDown(void)
+{
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ((double)ts.tv_nsec / 1e9);
+}
+
+/**
+ * @brief bme68x_read_fptr_t serving the simulator's register image as it stands, without running it or clearing the
+ * new data flags, so the field buffers hold exactly what a test put there
+ *
+ */
+static BME68X_INTF_RET_TYPE image_read(uint8_t reg_addr, uint8_t* reg_data, uint32_t len, void* intf_ptr)
+{
+    struct bme68x_sim* image = (struct bme68x_sim*)intf_ptr;
+
+    memcpy(reg_data, &image->regs[reg_addr], len);
+    return 0;
+}
+
+/**
+ * @brief Fill the field buffers with the measurements first .. first + 2, in the buffers placement gives
+ *
+ * @details Measurement k gets heater step k, so its gas_index tells it apart too. Bit k of new_mask marks it unread.
+ */
+static void stage_fields(uint8_t first, const uint8_t* placement, uint8_t new_mask)
+{
+    for(uint8_t k = 0; k < BME68X_N_FIELDS; k++)
+    {
+        uint8_t* field = &sim.regs[BME68X_REG_FIELD0 + (placement[k] * BME68X_LEN_FIELD_OFFSET)];
+
+        field[0] = k | ((new_mask & (1 << k)) ? BME68X_NEW_DATA_MSK : 0);
+        field[1] = (uint8_t)(first + k);
+    }
+}
+
+/**
+ * @brief Every starting meas_index, so every position of the 255 -> 0 overflow, in every buffer placement and for
+ * every set of unread fields. Both read paths must return the unread ones and only those, oldest first
+ *
+ */
+static void test_fields_ordered_across_wraparound(void)
+{
+    uint32_t n_cases = 0;
+
+    dev.read = image_read;
+    for(uint16_t first = 0; first < 256; first++)
+    {
+        for(uint8_t p = 0; p < 6; p++)
+        {
+            for(uint8_t new_mask = 0; new_mask < (1 << BME68X_N_FIELDS); new_mask++)
+            {
+                struct bme68x_data data[BME68X_N_FIELDS];
+                struct bme68x_raw_data raw[BME68X_N_FIELDS];
+                uint8_t n_data = 0, n_raw = 0, expected_n = 0;
+                int8_t expected_rslt = new_mask ? BME68X_OK : BME68X_W_NO_NEW_DATA;
+
+                stage_fields((uint8_t)first, placements[p], new_mask);
+                TEST_ASSERT_EQUAL_INT8(expected_rslt, bme68x_get_data(BME68X_SEQUENTIAL_MODE, data, &n_data, &dev));
+                TEST_ASSERT_EQUAL_INT8(expected_rslt, bme68x_get_raw_fields(BME68X_SEQUENTIAL_MODE, raw, &n_raw, &dev));
+
+                for(uint8_t k = 0; k < BME68X_N_FIELDS; k++)
+                {
+                    if(new_mask & (1 << k))
+                    {
+                        TEST_ASSERT_TRUE(expected_n < n_data);
+                        TEST_ASSERT_EQUAL_UINT8((uint8_t)(first + k), data[expected_n].meas_index);
+                        TEST_ASSERT_EQUAL_UINT8(k, data[expected_n].gas_index);
+                        TEST_ASSERT_EQUAL_UINT8((uint8_t)(first + k), raw[expected_n].field[1]);
+                        expected_n++;
+                    }
+                }
+                TEST_ASSERT_EQUAL_UINT8(expected_n, n_data);
+                TEST_ASSERT_EQUAL_UINT8(expected_n, n_raw);
+                n_cases++;
+            }
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(256 * 6 * 8, n_cases);
+}
+
+/**
+ * @brief The same through the simulated sensor itself, left running in sequential mode past several wraps
+ *
+ */
+static void test_sequential_mode_continuous_across_wraparound(void)
+{
+    static uint16_t temp_prof[3] = { 300, 320, 340 };
+    static uint16_t dur_prof[3] = { 30, 30, 30 };
+    struct bme68x_heatr_conf heatr_conf = {
+        .enable = BME68X_ENABLE, .heatr_temp_prof = temp_prof, .heatr_dur_prof = dur_prof, .profile_len = 3
+    };
+    int16_t last_meas = -1;
+    uint32_t n_fields = 0, n_wraps = 0, n_reads = 0;
+    uint32_t meas_dur_us;
+
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_set_heatr_conf(BME68X_SEQUENTIAL_MODE, &heatr_conf, &dev));
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_set_op_mode(BME68X_SEQUENTIAL_MODE, &dev));
+    meas_dur_us = bme68x_sim_meas_dur_us(&sim, 0);
+    while(n_fields < 1000)
+    {
+        struct bme68x_data data[BME68X_N_FIELDS];
+        uint8_t n_data = 0;
+
+        // One to three measurements per read, too few for the buffers to overrun, varying where the overflow falls
+        bme68x_sim_advance(&sim, (meas_dur_us * (10 + (n_reads++ % 20))) / 10);
+        bme68x_get_data(BME68X_SEQUENTIAL_MODE, data, &n_data, &dev);
+        for(uint8_t i = 0; i < n_data; i++)
+        {
+            if(last_meas >= 0)
+            {
+                TEST_ASSERT_EQUAL_UINT8((uint8_t)(last_meas + 1), data[i].meas_index);
+            }
+            n_wraps += (data[i].meas_index == 0) ? 1 : 0;
+            last_meas = data[i].meas_index;
+        }
+        n_fields += n_data;
+    }
+    TEST_ASSERT_TRUE(n_wraps >= 3);
+}
+
+/**
+ * @brief Time a read of three new fields that straddle the overflow, with and without decoding them. Reported, not
+ * asserted
+ *
+ */
+static void test_field_order_benchmark(void)
+{
+    struct bme68x_data data[BME68X_N_FIELDS];
+    struct bme68x_raw_data raw[BME68X_N_FIELDS];
+    volatile uint32_t sink = 0;
+    double start_s, raw_s, data_s;
+    uint8_t n_data;
+
+    dev.read = image_read;
+    stage_fields(254, placements[2], 0x07);
+
+    start_s = now_s();
+    for(uint32_t i = 0; i < BENCH_READS; i++)
+    {
+        bme68x_get_raw_fields(BME68X_SEQUENTIAL_MODE, raw, &n_data, &dev);
+        sink += raw[0].field[1];
+    }
+    raw_s = now_s() - start_s;
+
+    start_s = now_s();
+    for(uint32_t i = 0; i < BENCH_READS; i++)
+    {
+        bme68x_get_data(BME68X_SEQUENTIAL_MODE, data, &n_data, &dev);
+        sink += data[0].meas_index;
+    }
+    data_s = now_s() - start_s;
+
+    printf("3 fields: bme68x_get_raw_fields %.0f ns/read, bme68x_get_data %.0f ns/read\n",
+        (raw_s * 1e9) / BENCH_READS, (data_s * 1e9) / BENCH_READS);
+    TEST_ASSERT_EQUAL_UINT8(254, raw[0].field[1]);
+    TEST_ASSERT_EQUAL_UINT8(254, data[0].meas_index);
+    TEST_ASSERT_EQUAL_UINT8(0, data[2].meas_index);
+    TEST_ASSERT_TRUE(sink > 0);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_fields_ordered_across_wraparound);
+    RUN_TEST(test_sequential_mode_continuous_across_wraparound);
+    RUN_TEST(test_field_order_benchmark);
+    return UNITY_END();
+}
@@ -0,0 +1,107 @@
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include "bme68x.h"
+#include "bme68x_sim.h"
+
+#define N_SAMPLES       50
+
+
+static struct bme68x_sim sim;
+static struct bme68x_dev dev;
+static struct bme68x_conf conf;
+static struct bme68x_heatr_conf heatr_conf = { .enable = BME68X_ENABLE, .heatr_temp = 300, .heatr_dur = 100 };
+
+
+void setUp(void)
+{
+    memset(&dev, 0, sizeof(dev));   // the shadow survives bme68x_init, a fresh sensor must not inherit it
+    bme68x_sim_init(&sim, BME68X_VARIANT_GAS_LOW, &bme68x_sim_default_calib);
+    bme68x_sim_attach(&sim, &dev);
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_init(&dev));
+
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_get_conf(&conf, &dev));
+    conf.os_temp = BME68X_OS_2X;
+    conf.os_pres = BME68X_OS_16X;
+    conf.os_hum = BME68X_OS_1X;
+    conf.filter = BME68X_FILTER_OFF;
+    conf.odr = BME68X_ODR_NONE;
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_set_conf(&conf, &dev));
+}
+
+void tearDown(void)
+{
+}
+
+/**
+ * @brief Take forced samples and require every bme68x_get_data to cost exactly reads_per_sample bus reads
+ *
+ * @param samples receives every sample, for comparison across runs
+ */
+static void count_forced_reads(uint8_t shadow, uint32_t reads_per_sample, struct bme68x_data* samples)
+{
+    if(shadow)
+    {
+        TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_enable_shadow(0, &dev));
+    }
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_set_heatr_conf(BME68X_FORCED_MODE, &heatr_conf, &dev));
+
+    for(uint8_t i = 0; i < N_SAMPLES; i++)
+    {
+        uint32_t reads_before, writes_before;
+        uint8_t n_fields = 0;
+
+        TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_set_op_mode(BME68X_FORCED_MODE, &dev));
+        bme68x_sim_advance(&sim, bme68x_get_meas_dur(BME68X_FORCED_MODE, &conf, &dev) + (heatr_conf.heatr_dur * 1000));
+
+        reads_before = sim.n_reads;
+        writes_before = sim.n_writes;
+        TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_get_data(BME68X_FORCED_MODE, &samples[i], &n_fields, &dev));
+        TEST_ASSERT_EQUAL_UINT8(1, n_fields);
+        TEST_ASSERT_EQUAL_UINT32(reads_per_sample, sim.n_reads - reads_before);
+        TEST_ASSERT_EQUAL_UINT32(0, sim.n_writes - writes_before);
+    }
+    printf("forced bme68x_get_data, shadow %s: %lu bus read(s) per sample\n", shadow ? "on" : "off",
+        (unsigned long)reads_per_sample);
+}
+
+/**
+ * @brief Without the shadow a forced sample is the field read plus one read of the heater settings block
+ *
+ */
+static void test_forced_reads_without_shadow(void)
+{
+    struct bme68x_data samples[N_SAMPLES];
+
+    count_forced_reads(0, 2, samples);
+}
+
+/**
+ * @brief With the shadow the heater settings come from what the driver wrote, the field read is the only transfer, and
+ * the samples are those of a driver without it
+ *
+ */
+static void test_forced_reads_with_shadow(void)
+{
+    struct bme68x_data plain[N_SAMPLES], shadowed[N_SAMPLES];
+
+    count_forced_reads(0, 2, plain);
+    setUp();
+    count_forced_reads(1, 1, shadowed);
+    for(uint8_t i = 0; i < N_SAMPLES; i++)
+    {
+        TEST_ASSERT_EQUAL_UINT8(plain[i].meas_index, shadowed[i].meas_index);
+        TEST_ASSERT_EQUAL_UINT8(plain[i].res_heat, shadowed[i].res_heat);
+        TEST_ASSERT_EQUAL_UINT8(plain[i].idac, shadowed[i].idac);
+        TEST_ASSERT_EQUAL_UINT8(plain[i].gas_wait, shadowed[i].gas_wait);
+        TEST_ASSERT_EQUAL_MEMORY(&plain[i].gas_resistance, &shadowed[i].gas_resistance, sizeof(plain[i].gas_resistance));
+    }
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_forced_reads_without_shadow);
+    RUN_TEST(test_forced_reads_with_shadow);
+    return UNITY_END();
+}
@@ -0,0 +1,202 @@
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "esp_bme_format.h"
+
+#define BENCH_SAMPLES   200000
+#define JSON_LEN        128
+
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ((double)ts.tv_nsec / 1e9);
+}
+
+static void check_decimal(const char* expected, int64_t value, uint8_t in_decimals, uint8_t out_decimals)
+{
+    char buf[BME_FORMAT_DECIMAL_MAX_LEN];
+    size_t len = bme_format_decimal(buf, value, in_decimals, out_decimals);
+
+    TEST_ASSERT_EQUAL_STRING(expected, buf);
+    TEST_ASSERT_EQUAL_size_t(strlen(expected), len);
+}
+
+static void test_decimal_golden(void)
+{
+    check_decimal("0.00", 0, 2, 2);
+    check_decimal("0.01", 1, 2, 2);
+    check_decimal("-0.01", -1, 2, 2);
+    check_decimal("-12.34", -1234, 2, 2);
+    check_decimal("327.67", INT16_MAX, 2, 2);
+    check_decimal("-327.68", INT16_MIN, 2, 2);
+    check_decimal("101325.00", 101325, 0, 2);
+    check_decimal("4294967295.00", UINT32_MAX, 0, 2);
+    check_decimal("45.68", 45678, 3, 2);
+    check_decimal("45.67", 45674, 3, 2);
+    check_decimal("0.01", 5, 3, 2);             // half rounds away from zero
+    check_decimal("-0.01", -5, 3, 2);
+    check_decimal("0.00", -4, 3, 2);            // never "-0.00"
+    check_decimal("100.00", 99995, 3, 2);       // rounding carries into a new digit
+    check_decimal("12", 1234, 2, 0);
+    check_decimal("-13", -1250, 2, 0);
+    check_decimal("0.000001", 1, 6, 6);
+    check_decimal("1.000000", 1000000, 6, 9);   // decimal counts clamp to 6
+    check_decimal("-9223372036854775808", INT64_MIN, 0, 0);
+    check_decimal("9223372036854775807", INT64_MAX, 0, 0);
+}
+
+/**
+ * @brief Every temperature the integer driver can report, degree celsius x100, against printf
+ *
+ */
+static void test_decimal_temperature_range(void)
+{
+    char buf[BME_FORMAT_DECIMAL_MAX_LEN];
+    char expected[32];
+
+    for(int32_t value = INT16_MIN; value <= INT16_MAX; value++)
+    {
+        snprintf(expected, sizeof(expected), "%.2f", value / 100.0);
+        bme_format_decimal(buf, value, 2, 2);
+        TEST_ASSERT_EQUAL_STRING(expected, buf);
+    }
+}
+
+/**
+ * @brief Every humidity the integer driver can report, % x1000, rounded to two decimals half away from zero
+ *
+ */
+static void test_decimal_humidity_range(void)
+{
+    char buf[BME_FORMAT_DECIMAL_MAX_LEN];
+    char expected[32];
+
+    for(uint32_t value = 0; value <= 100000; value++)
+    {
+        uint32_t hundredths = (value + 5) / 10;
+        snprintf(expected, sizeof(expected), "%lu.%02lu", (unsigned long)(hundredths / 100), (unsigned long)(hundredths % 100));
+        bme_format_decimal(buf, value, 3, 2);
+        TEST_ASSERT_EQUAL_STRING(expected, buf);
+    }
+}
+
+static void check_uint32(uint32_t value)
+{
+    char buf[BME_FORMAT_DECIMAL_MAX_LEN];
+    char expected[32];
+
+    snprintf(expected, sizeof(expected), "%lu.00", (unsigned long)value);
+    bme_format_decimal(buf, value, 0, 2);
+    TEST_ASSERT_EQUAL_STRING(expected, buf);
+}
+
+/**
+ * @brief Pressure and gas resistance are uint32 in the integer build. Sampled over the whole range, both ends included
+ *
+ */
+static void test_decimal_uint32_range(void)
+{
+    for(uint64_t value = 0; value <= UINT32_MAX; value += 4093)
+    {
+        check_uint32((uint32_t)value);
+    }
+    check_uint32(UINT32_MAX);
+}
+
+static void make_sample(struct bme68x_data* data)
+{
+    memset(data, 0, sizeof(struct bme68x_data));
+    #ifdef BME68X_USE_FPU
+    data->temperature = -12.34f;
+    data->pressure = 101325.0f;
+    data->humidity = 45.678f;
+    data->gas_resistance = 1234567.0f;
+    #else
+    data->temperature = -1234;
+    data->pressure = 101325;
+    data->humidity = 45678;
+    data->gas_resistance = 1234567;
+    #endif
+}
+
+static void test_json_golden(void)
+{
+    static const char expected[] = "{\"temperature\": -12.34,\"pressure\": 101325.00,\"humidity\": 45.68,\"gas\": 1234567.00}";
+    struct bme68x_data data;
+    char buf[JSON_LEN];
+
+    make_sample(&data);
+    TEST_ASSERT_EQUAL_UINT16(strlen(expected), bme_format_json(buf, sizeof(buf), &data));
+    TEST_ASSERT_EQUAL_STRING(expected, buf);
+
+    // Too small by one byte: nothing is rendered
+    TEST_ASSERT_EQUAL_UINT16(0, bme_format_json(buf, strlen(expected), &data));
+    TEST_ASSERT_EQUAL_STRING("", buf);
+}
+
+/**
+ * @brief Time the JSON rendering against the snprintf("%.2f") it replaced. Reported, not asserted
+ *
+ */
+static void test_json_benchmark(void)
+{
+    struct bme68x_data data;
+    char buf[JSON_LEN];
+    volatile uint32_t sink = 0;
+    double start_s, format_s, snprintf_s;
+
+    make_sample(&data);
+    start_s = now_s();
+    for(uint32_t i = 0; i < BENCH_SAMPLES; i++)
+    {
+        #ifdef BME68X_USE_FPU
+        data.temperature = (float)(i % 8000) / 100.0f;
+        #else
+        data.temperature = (int16_t)(i % 8000);
+        #endif
+        sink += bme_format_json(buf, sizeof(buf), &data);
+    }
+    format_s = now_s() - start_s;
+
+    start_s = now_s();
+    for(uint32_t i = 0; i < BENCH_SAMPLES; i++)
+    {
+        #ifdef BME68X_USE_FPU
+        data.temperature = (float)(i % 8000) / 100.0f;
+        sink += (uint32_t)snprintf(buf, sizeof(buf), "{\"temperature\": %.2f,\"pressure\": %.2f,\"humidity\": %.2f,\"gas\": %.2f}",
+            data.temperature, data.pressure, data.humidity, data.gas_resistance);
+        #else
+        data.temperature = (int16_t)(i % 8000);
+        sink += (uint32_t)snprintf(buf, sizeof(buf), "{\"temperature\": %.2f,\"pressure\": %.2f,\"humidity\": %.2f,\"gas\": %.2f}",
+            data.temperature / 100.0, (double)data.pressure, data.humidity / 1000.0, (double)data.gas_resistance);
+        #endif
+    }
+    snprintf_s = now_s() - start_s;
+
+    printf("bme_format_json %.0f ns/sample, snprintf %.0f ns/sample\n",
+        (format_s * 1e9) / BENCH_SAMPLES, (snprintf_s * 1e9) / BENCH_SAMPLES);
+    TEST_ASSERT_TRUE(sink > 0);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_decimal_golden);
+    RUN_TEST(test_decimal_temperature_range);
+    RUN_TEST(test_decimal_humidity_range);
+    RUN_TEST(test_decimal_uint32_range);
+    RUN_TEST(test_json_golden);
+    RUN_TEST(test_json_benchmark);
+    return UNITY_END();
+}
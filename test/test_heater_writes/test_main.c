@@ -0,0 +1,181 @@
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include "bme68x.h"
+#include "bme68x_sim.h"
+#include "bme_i2c_trace.h"
+
+#define PROFILE_LEN     10
+#define TRACE_BYTES     4096
+
+
+static struct bme68x_sim sim;
+static struct bme68x_dev dev;
+static struct bme_i2c_trace trace;
+static uint8_t trace_buf[TRACE_BYTES];
+static uint16_t temp_prof[PROFILE_LEN] = { 200, 240, 280, 320, 360, 360, 320, 280, 240, 200 };
+static uint16_t dur_prof[PROFILE_LEN] = { 100, 100, 100, 100, 100, 100, 100, 100, 100, 100 };
+
+/**
+ * @brief I2C traffic of a trace, as it goes over the wire
+ *
+ */
+struct bus_cost
+{
+    uint32_t transfers;
+    uint32_t bytes;     // device address, register address and payload bytes, both directions
+};
+
+
+static BME68X_INTF_RET_TYPE recording_read(uint8_t reg_addr, uint8_t* reg_data, uint32_t len, void* intf_ptr)
+{
+    BME68X_INTF_RET_TYPE rslt = bme68x_sim_read(reg_addr, reg_data, len, intf_ptr);
+    bme_i2c_trace_record(&trace, BME_I2C_TRACE_READ, reg_addr, reg_data, len, rslt != 0, sim.now_us);
+    return rslt;
+}
+
+static BME68X_INTF_RET_TYPE recording_write(uint8_t reg_addr, const uint8_t* reg_data, uint32_t len, void* intf_ptr)
+{
+    BME68X_INTF_RET_TYPE rslt = bme68x_sim_write(reg_addr, reg_data, len, intf_ptr);
+    bme_i2c_trace_record(&trace, BME_I2C_TRACE_WRITE, reg_addr, reg_data, len, rslt != 0, sim.now_us);
+    return rslt;
+}
+
+void setUp(void)
+{
+    memset(&dev, 0, sizeof(dev));   // the shadow survives bme68x_init, a fresh sensor must not inherit it
+    bme68x_sim_init(&sim, BME68X_VARIANT_GAS_LOW, &bme68x_sim_default_calib);
+    bme68x_sim_attach(&sim, &dev);
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_init(&dev));
+    dev.read = recording_read;
+    dev.write = recording_write;
+}
+
+void tearDown(void)
+{
+}
+
+/**
+ * @brief Walk a trace and count what it cost on the bus
+ *
+ * @details A write is the device address, the first register address, then the payload. A read is the device address,
+ * the register address, the device address again after the repeated start, then the payload.
+ */
+static struct bus_cost trace_cost(void)
+{
+    struct bus_cost cost = { 0 };
+    size_t len = bme_i2c_trace_len(&trace);
+    size_t pos = BME_I2C_TRACE_HEADER_LEN;
+
+    while((pos + BME_I2C_TRACE_RECORD_LEN) <= len)
+    {
+        const uint8_t* rec = &trace_buf[pos];
+        uint16_t payload = (uint16_t)(rec[2] | (rec[3] << 8));
+
+        cost.transfers++;
+        cost.bytes += payload + (((rec[0] & BME_I2C_TRACE_OP_MSK) == BME_I2C_TRACE_READ) ? 3 : 2);
+        pos += BME_I2C_TRACE_RECORD_LEN + payload;
+    }
+    return cost;
+}
+
+/**
+ * @brief Write a heater configuration the way the driver did before bme68x_set_heatr_image: sleep, then res_heat,
+ * gas_wait and ctrl_gas with one bme68x_set_regs each
+ *
+ */
+static void set_heatr_per_block(uint8_t op_mode, const struct bme68x_heatr_conf* conf)
+{
+    struct bme68x_heatr_image image;
+    uint8_t rh_addr[BME68X_LEN_HEATR_PROF], gw_addr[BME68X_LEN_HEATR_PROF];
+    uint8_t ctrl_addr[2] = { BME68X_REG_CTRL_GAS_0, BME68X_REG_CTRL_GAS_1 };
+    uint8_t ctrl_gas[2];
+
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_compile_heatr_conf(op_mode, conf, &image, &dev));
+    for(uint8_t i = 0; i < image.len; i++)
+    {
+        rh_addr[i] = BME68X_REG_RES_HEAT0 + i;
+        gw_addr[i] = BME68X_REG_GAS_WAIT0 + i;
+    }
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_set_op_mode(BME68X_SLEEP_MODE, &dev));
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_set_regs(rh_addr, image.res_heat, image.len, &dev));
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_set_regs(gw_addr, image.gas_wait, image.len, &dev));
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_get_regs(BME68X_REG_CTRL_GAS_0, ctrl_gas, 2, &dev));
+    ctrl_gas[0] = BME68X_SET_BITS(ctrl_gas[0], BME68X_HCTRL, image.hctrl);
+    ctrl_gas[1] = BME68X_SET_BITS_POS_0(ctrl_gas[1], BME68X_NBCONV, image.nb_conv);
+    ctrl_gas[1] = BME68X_SET_BITS(ctrl_gas[1], BME68X_RUN_GAS, image.run_gas);
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_set_regs(ctrl_addr, ctrl_gas, 2, &dev));
+}
+
+/**
+ * @brief Configure the heater one way, from a fresh sensor, and return the bus cost and the heater registers it left
+ *
+ */
+static struct bus_cost measure(uint8_t op_mode, const struct bme68x_heatr_conf* conf, uint8_t shadow, uint8_t per_block, uint8_t* regs)
+{
+    struct bus_cost cost;
+
+    setUp();
+    if(shadow)
+    {
+        TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_enable_shadow(0, &dev));
+    }
+    bme_i2c_trace_init(&trace, trace_buf, sizeof(trace_buf));
+    if(per_block)
+    {
+        set_heatr_per_block(op_mode, conf);
+    }
+    else
+    {
+        TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_set_heatr_conf(op_mode, conf, &dev));
+    }
+    cost = trace_cost();
+    memcpy(regs, &sim.regs[BME68X_REG_IDAC_HEAT0], BME68X_REG_CTRL_GAS_1 - BME68X_REG_IDAC_HEAT0 + 1);
+    return cost;
+}
+
+/**
+ * @brief The heater image goes out as one transfer of address/data pairs, the only write form the sensor takes. Shadow
+ * or not, it must never cost more on the bus than the per block writes it replaced, and must leave the same registers
+ *
+ */
+static void check_heatr_writes(uint8_t op_mode, const struct bme68x_heatr_conf* conf, const char* name)
+{
+    uint8_t image_regs[BME68X_REG_CTRL_GAS_1 - BME68X_REG_IDAC_HEAT0 + 1];
+    uint8_t block_regs[sizeof(image_regs)];
+
+    for(uint8_t shadow = 0; shadow < 2; shadow++)
+    {
+        struct bus_cost image = measure(op_mode, conf, shadow, 0, image_regs);
+        struct bus_cost block = measure(op_mode, conf, shadow, 1, block_regs);
+
+        printf("%s, shadow %s: heater image %lu transfers %lu bytes, per block %lu transfers %lu bytes\n", name,
+            shadow ? "on" : "off", (unsigned long)image.transfers, (unsigned long)image.bytes,
+            (unsigned long)block.transfers, (unsigned long)block.bytes);
+        TEST_ASSERT_EQUAL_MEMORY(block_regs, image_regs, sizeof(image_regs));
+        TEST_ASSERT_TRUE(image.transfers <= block.transfers);
+        TEST_ASSERT_TRUE(image.bytes <= block.bytes);
+    }
+}
+
+static void test_forced_heatr_writes(void)
+{
+    struct bme68x_heatr_conf conf = { .enable = BME68X_ENABLE, .heatr_temp = 300, .heatr_dur = 100 };
+    check_heatr_writes(BME68X_FORCED_MODE, &conf, "forced");
+}
+
+static void test_sequential_heatr_writes(void)
+{
+    struct bme68x_heatr_conf conf = {
+        .enable = BME68X_ENABLE, .heatr_temp_prof = temp_prof, .heatr_dur_prof = dur_prof, .profile_len = PROFILE_LEN
+    };
+    check_heatr_writes(BME68X_SEQUENTIAL_MODE, &conf, "sequential");
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_forced_heatr_writes);
+    RUN_TEST(test_sequential_heatr_writes);
+    return UNITY_END();
+}
@@ -0,0 +1,281 @@
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "esp_bme_history.h"
+
+#define MAX_SENSORS     8
+
+
+static struct bme_history hists[MAX_SENSORS];
+
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+/**
+ * @brief A driver sample that converts to exactly the given history values, in either build
+ *
+ * @param temperature degree celsius x100, a multiple of 25 so the float is exact
+ * @param humidity % relative humidity x100, a multiple of 50 so the float is exact
+ */
+static struct bme68x_data make_data(int16_t temperature, uint16_t humidity, uint32_t pressure, uint32_t gas_resistance)
+{
+    struct bme68x_data data;
+
+    memset(&data, 0, sizeof(data));
+#ifdef BME68X_USE_FPU
+    data.temperature = temperature / 100.0f;
+    data.humidity = humidity / 100.0f;
+    data.pressure = (float)pressure;
+    data.gas_resistance = (float)gas_resistance;
+#else
+    data.temperature = temperature;
+    data.humidity = (uint32_t)humidity * 10;
+    data.pressure = pressure;
+    data.gas_resistance = gas_resistance;
+#endif
+    return data;
+}
+
+static void free_history(struct bme_history* hist)
+{
+    heap_caps_free(hist->raw.buf);
+    for(uint8_t t = 0; t < BME_HISTORY_N_TIERS; t++)
+    {
+        heap_caps_free(hist->tiers[t].buf);
+    }
+    vSemaphoreDelete(hist->lock);
+}
+
+/**
+ * @brief Bytes the rings of a history hold
+ *
+ */
+static size_t history_bytes(const struct bme_history* hist)
+{
+    size_t bytes = hist->raw.capacity * hist->raw.elem_size;
+
+    for(uint8_t t = 0; t < BME_HISTORY_N_TIERS; t++)
+    {
+        bytes += hist->tiers[t].capacity * hist->tiers[t].elem_size;
+    }
+    return bytes;
+}
+
+/**
+ * @brief A lone sensor gets the full capacities, more sensors get equal shares that together stay within the budget,
+ * every ring scaled down alike
+ *
+ */
+static void test_capacities_shared_by_sensor_count(void)
+{
+    for(uint8_t n_sensors = 1; n_sensors <= MAX_SENSORS; n_sensors++)
+    {
+        size_t total = 0;
+
+        for(uint8_t i = 0; i < n_sensors; i++)
+        {
+            TEST_ASSERT_EQUAL_INT(ESP_OK, bme_history_init(&hists[i], n_sensors));
+            total += history_bytes(&hists[i]);
+        }
+        printf("%u sensor(s): %u raw samples, %u/%u/%u tier records, %u kB each, %u kB in all\n", (unsigned)n_sensors,
+            (unsigned)hists[0].raw.capacity, (unsigned)hists[0].tiers[BME_HISTORY_TIER_10S].capacity,
+            (unsigned)hists[0].tiers[BME_HISTORY_TIER_1MIN].capacity, (unsigned)hists[0].tiers[BME_HISTORY_TIER_15MIN].capacity,
+            (unsigned)(history_bytes(&hists[0]) / 1024), (unsigned)(total / 1024));
+
+        TEST_ASSERT_TRUE(total <= BME_HISTORY_PSRAM_BUDGET);
+        TEST_ASSERT_TRUE(hists[0].raw.capacity <= BME_HISTORY_RAW_CAPACITY);
+        TEST_ASSERT_TRUE(hists[0].tiers[BME_HISTORY_TIER_15MIN].capacity <= BME_HISTORY_15MIN_CAPACITY);
+        // The same fraction of every ring, to within the rounding down of each
+        TEST_ASSERT_UINT32_WITHIN(1, ((uint64_t)hists[0].raw.capacity * BME_HISTORY_1MIN_CAPACITY) / BME_HISTORY_RAW_CAPACITY,
+            hists[0].tiers[BME_HISTORY_TIER_1MIN].capacity);
+        for(uint8_t i = 1; i < n_sensors; i++)
+        {
+            TEST_ASSERT_EQUAL_UINT32(hists[0].raw.capacity, hists[i].raw.capacity);
+        }
+        for(uint8_t i = 0; i < n_sensors; i++)
+        {
+            free_history(&hists[i]);
+        }
+    }
+}
+
+/**
+ * @brief A scaled down raw ring still keeps the newest samples once it is full
+ *
+ */
+static void test_scaled_ring_keeps_newest(void)
+{
+    static struct bme_history_sample out[BME_HISTORY_RAW_CAPACITY];
+    struct bme_history* hist = &hists[0];
+    struct bme68x_data data = { .temperature = 25.0, .pressure = 101325.0, .humidity = 40.0, .gas_resistance = 50000.0 };
+    uint32_t n_appended;
+    size_t n;
+
+    TEST_ASSERT_EQUAL_INT(ESP_OK, bme_history_init(hist, MAX_SENSORS));
+    TEST_ASSERT_TRUE(hist->raw.capacity < BME_HISTORY_RAW_CAPACITY);
+    n_appended = (uint32_t)hist->raw.capacity + 100;
+    for(uint32_t i = 0; i < n_appended; i++)
+    {
+        bme_history_append(hist, &data, i * 100);
+    }
+
+    n = bme_history_query_raw(hist, 0, n_appended * 100, out, BME_HISTORY_RAW_CAPACITY);
+    TEST_ASSERT_EQUAL_UINT32(hist->raw.capacity, n);
+    TEST_ASSERT_EQUAL_UINT32(100 * 100, out[0].timestamp_ms);
+    TEST_ASSERT_EQUAL_UINT32((n_appended - 1) * 100, out[n - 1].timestamp_ms);
+    free_history(hist);
+}
+
+/**
+ * @brief Every tier rolls the samples of one period up into their count, min, max and truncated mean, and a period
+ * only shows once a sample of the next one closes it
+ *
+ */
+static void test_tier_min_max_mean(void)
+{
+    static const int16_t temperature[4] = { 2125, -500, 3000, 2200 };
+    static const uint16_t humidity[4] = { 4050, 4000, 6000, 5500 };
+    static const uint32_t pressure[4] = { 101325, 99000, 100000, 101000 };
+    static const uint32_t gas[4] = { 50000, 1000, 250000, 49999 };
+    struct bme_history* hist = &hists[0];
+    struct bme_history_aggregate agg[2];
+    struct bme68x_data data;
+
+    TEST_ASSERT_EQUAL_INT(ESP_OK, bme_history_init(hist, 1));
+    for(uint8_t i = 0; i < 4; i++)
+    {
+        data = make_data(temperature[i], humidity[i], pressure[i], gas[i]);
+        bme_history_append(hist, &data, 1000 + (i * 2000));
+    }
+    for(uint8_t t = 0; t < BME_HISTORY_N_TIERS; t++)
+    {
+        TEST_ASSERT_EQUAL_size_t(0, bme_history_query_tier(hist, (enum bme_history_tier)t, 0, 3600000, agg, 2));
+    }
+
+    data = make_data(0, 0, 0, 0);
+    bme_history_append(hist, &data, 10000);
+    TEST_ASSERT_EQUAL_size_t(1, bme_history_query_tier(hist, BME_HISTORY_TIER_10S, 0, 3600000, agg, 2));
+    TEST_ASSERT_EQUAL_UINT32(0, agg[0].timestamp_ms);
+    TEST_ASSERT_EQUAL_UINT16(4, agg[0].count);
+    TEST_ASSERT_EQUAL_INT16(-500, agg[0].temperature_min);
+    TEST_ASSERT_EQUAL_INT16(3000, agg[0].temperature_max);
+    TEST_ASSERT_EQUAL_INT16((2125 - 500 + 3000 + 2200) / 4, agg[0].temperature_mean);
+    TEST_ASSERT_EQUAL_UINT16(4000, agg[0].humidity_min);
+    TEST_ASSERT_EQUAL_UINT16(6000, agg[0].humidity_max);
+    TEST_ASSERT_EQUAL_UINT16((4050 + 4000 + 6000 + 5500) / 4, agg[0].humidity_mean);
+    TEST_ASSERT_EQUAL_UINT32(99000, agg[0].pressure_min);
+    TEST_ASSERT_EQUAL_UINT32(101325, agg[0].pressure_max);
+    TEST_ASSERT_EQUAL_UINT32((101325 + 99000 + 100000 + 101000) / 4, agg[0].pressure_mean);
+    TEST_ASSERT_EQUAL_UINT32(1000, agg[0].gas_min);
+    TEST_ASSERT_EQUAL_UINT32(250000, agg[0].gas_max);
+    TEST_ASSERT_EQUAL_UINT32((50000 + 1000 + 250000 + 49999) / 4, agg[0].gas_mean);
+
+    // Still inside the first minute and quarter hour, so those tiers have nothing complete yet
+    TEST_ASSERT_EQUAL_size_t(0, bme_history_query_tier(hist, BME_HISTORY_TIER_1MIN, 0, 3600000, agg, 2));
+    TEST_ASSERT_EQUAL_size_t(0, bme_history_query_tier(hist, BME_HISTORY_TIER_15MIN, 0, 3600000, agg, 2));
+    free_history(hist);
+}
+
+/**
+ * @brief A sample on the last ms of a period and one on the first ms of the next fall into different periods of the
+ * tier they straddle, and into the same one of the coarser tiers
+ *
+ */
+static void test_tier_bucket_boundaries(void)
+{
+    static const uint32_t boundary_ms[BME_HISTORY_N_TIERS] = { 10000, 60000, 900000 };
+    struct bme_history* hist = &hists[0];
+    struct bme_history_aggregate agg[4];
+
+    for(uint8_t t = 0; t < BME_HISTORY_N_TIERS; t++)
+    {
+        uint32_t b = 3 * boundary_ms[t];
+        struct bme68x_data before = make_data(1000, 1000, 1000, 1000);
+        struct bme68x_data after = make_data(2000, 2000, 2000, 2000);
+        struct bme68x_data closing = make_data(0, 0, 0, 0);
+
+        TEST_ASSERT_EQUAL_INT(ESP_OK, bme_history_init(hist, 1));
+        bme_history_append(hist, &before, b - 1);
+        bme_history_append(hist, &after, b);
+        bme_history_append(hist, &closing, b + (uint32_t)boundary_ms[BME_HISTORY_N_TIERS - 1]);
+
+        TEST_ASSERT_EQUAL_size_t(2, bme_history_query_tier(hist, (enum bme_history_tier)t, 0, b * 2, agg, 4));
+        TEST_ASSERT_EQUAL_UINT32(b - boundary_ms[t], agg[0].timestamp_ms);
+        TEST_ASSERT_EQUAL_UINT16(1, agg[0].count);
+        TEST_ASSERT_EQUAL_INT16(1000, agg[0].temperature_mean);
+        TEST_ASSERT_EQUAL_UINT32(b, agg[1].timestamp_ms);
+        TEST_ASSERT_EQUAL_UINT16(1, agg[1].count);
+        TEST_ASSERT_EQUAL_INT16(2000, agg[1].temperature_mean);
+        for(uint8_t coarser = t + 1; coarser < BME_HISTORY_N_TIERS; coarser++)
+        {
+            if((b % boundary_ms[coarser]) != 0)
+            {
+                TEST_ASSERT_EQUAL_size_t(1, bme_history_query_tier(hist, (enum bme_history_tier)coarser, 0, b * 2, agg, 4));
+                TEST_ASSERT_EQUAL_UINT16(2, agg[0].count);
+                TEST_ASSERT_EQUAL_INT16(1500, agg[0].temperature_mean);
+            }
+        }
+        free_history(hist);
+    }
+}
+
+/**
+ * @brief Once a tier ring wraps it keeps the newest periods, oldest first, and range queries find their bounds across
+ * the wrap
+ *
+ */
+static void test_tier_ring_wraps(void)
+{
+    static struct bme_history_aggregate agg[BME_HISTORY_10S_CAPACITY];
+    struct bme_history* hist = &hists[0];
+    uint32_t n_periods, first;
+    size_t capacity, n;
+
+    TEST_ASSERT_EQUAL_INT(ESP_OK, bme_history_init(hist, UINT8_MAX));
+    capacity = hist->tiers[BME_HISTORY_TIER_10S].capacity;
+    TEST_ASSERT_TRUE(capacity < BME_HISTORY_10S_CAPACITY);
+    n_periods = (uint32_t)(capacity * 2) + 7;
+    for(uint32_t p = 0; p <= n_periods; p++)
+    {
+        struct bme68x_data data = make_data((int16_t)(p % 4000), 0, p, p);
+        bme_history_append(hist, &data, p * 10000);
+    }
+
+    first = n_periods - (uint32_t)capacity;
+    n = bme_history_query_tier(hist, BME_HISTORY_TIER_10S, 0, n_periods * 10000, agg, BME_HISTORY_10S_CAPACITY);
+    TEST_ASSERT_EQUAL_size_t(capacity, n);
+    for(size_t i = 0; i < n; i++)
+    {
+        TEST_ASSERT_EQUAL_UINT32((first + i) * 10000, agg[i].timestamp_ms);
+        TEST_ASSERT_EQUAL_UINT32(first + i, agg[i].pressure_mean);
+    }
+
+    // A window in the middle of the ring, its bounds on a period start and inside a period
+    n = bme_history_query_tier(hist, BME_HISTORY_TIER_10S, (first + 3) * 10000, ((first + 9) * 10000) + 5000, agg, BME_HISTORY_10S_CAPACITY);
+    TEST_ASSERT_EQUAL_size_t(7, n);
+    TEST_ASSERT_EQUAL_UINT32((first + 3) * 10000, agg[0].timestamp_ms);
+    TEST_ASSERT_EQUAL_UINT32((first + 9) * 10000, agg[6].timestamp_ms);
+    // max_out caps the copy, oldest first
+    n = bme_history_query_tier(hist, BME_HISTORY_TIER_10S, 0, n_periods * 10000, agg, 3);
+    TEST_ASSERT_EQUAL_size_t(3, n);
+    TEST_ASSERT_EQUAL_UINT32(first * 10000, agg[0].timestamp_ms);
+    free_history(hist);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_capacities_shared_by_sensor_count);
+    RUN_TEST(test_scaled_ring_keeps_newest);
+    RUN_TEST(test_tier_min_max_mean);
+    RUN_TEST(test_tier_bucket_boundaries);
+    RUN_TEST(test_tier_ring_wraps);
+    return UNITY_END();
+}
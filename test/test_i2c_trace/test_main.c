@@ -0,0 +1,237 @@
+#include <unity.h>
+#include <string.h>
+#include "bme68x.h"
+#include "bme68x_sim.h"
+#include "bme_i2c_trace.h"
+
+#define N_MEAS          8
+#define TRACE_BYTES     16384
+
+
+static struct bme68x_sim sim;
+static struct bme_i2c_trace trace;
+static uint8_t trace_buf[TRACE_BYTES];
+static struct bme68x_data recorded[N_MEAS];
+
+/* A different environment for every measurement, so a replay that serves the wrong one shows */
+static const struct bme68x_sim_env envs[N_MEAS] = {
+    { 25.0, 101325.0, 40.0, 50000.0 },
+    { 24.0, 100000.0, 45.0, 40000.0 },
+    { 23.0, 99000.0, 50.0, 30000.0 },
+    { 22.0, 98000.0, 55.0, 20000.0 },
+    { 21.0, 97000.0, 60.0, 10000.0 },
+    { 20.0, 96000.0, 65.0, 9000.0 },
+    { 19.0, 95000.0, 70.0, 8000.0 },
+    { 18.0, 94000.0, 75.0, 7000.0 },
+};
+
+
+/* The simulated sensor behind the bus callbacks of the firmware, recording every transfer the way they do */
+static BME68X_INTF_RET_TYPE recording_read(uint8_t reg_addr, uint8_t* reg_data, uint32_t len, void* intf_ptr)
+{
+    BME68X_INTF_RET_TYPE rslt = bme68x_sim_read(reg_addr, reg_data, len, intf_ptr);
+    bme_i2c_trace_record(&trace, BME_I2C_TRACE_READ, reg_addr, reg_data, len, rslt != 0, sim.now_us);
+    return rslt;
+}
+
+static BME68X_INTF_RET_TYPE recording_write(uint8_t reg_addr, const uint8_t* reg_data, uint32_t len, void* intf_ptr)
+{
+    BME68X_INTF_RET_TYPE rslt = bme68x_sim_write(reg_addr, reg_data, len, intf_ptr);
+    bme_i2c_trace_record(&trace, BME_I2C_TRACE_WRITE, reg_addr, reg_data, len, rslt != 0, sim.now_us);
+    return rslt;
+}
+
+/**
+ * @brief Bring up a sensor and take N_MEAS forced measurements
+ *
+ * @param sim the simulator to change the environment of between measurements, NULL on replay
+ * @param os_temp temperature oversampling to configure
+ * @param raw_path read with bme68x_get_raw_fields and bme68x_decode_raw_fields instead of bme68x_get_data
+ */
+static void run_session(struct bme68x_dev* dev, struct bme68x_sim* sim, uint8_t os_temp, uint8_t raw_path, struct bme68x_data* data)
+{
+    struct bme68x_heatr_conf heatr_conf = { .enable = BME68X_ENABLE, .heatr_temp = 300, .heatr_dur = 100 };
+    struct bme68x_conf conf;
+
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_init(dev));
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_get_conf(&conf, dev));
+    conf.os_temp = os_temp;
+    conf.os_pres = BME68X_OS_16X;
+    conf.os_hum = BME68X_OS_1X;
+    conf.filter = BME68X_FILTER_OFF;
+    conf.odr = BME68X_ODR_NONE;
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_set_conf(&conf, dev));
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_set_heatr_conf(BME68X_FORCED_MODE, &heatr_conf, dev));
+
+    for(uint8_t i = 0; i < N_MEAS; i++)
+    {
+        uint8_t n_fields = 0;
+
+        if(sim != NULL)
+        {
+            bme68x_sim_set_env(sim, &envs[i]);
+        }
+        TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_set_op_mode(BME68X_FORCED_MODE, dev));
+        dev->delay_us(bme68x_get_meas_dur(BME68X_FORCED_MODE, &conf, dev) + (heatr_conf.heatr_dur * 1000), dev->intf_ptr);
+        if(raw_path)
+        {
+            struct bme68x_raw_data raw;
+            TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_get_raw_fields(BME68X_FORCED_MODE, &raw, &n_fields, dev));
+            TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_decode_raw_fields(&raw, &data[i], n_fields, dev));
+        }
+        else
+        {
+            TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_get_data(BME68X_FORCED_MODE, &data[i], &n_fields, dev));
+        }
+        TEST_ASSERT_EQUAL_UINT8(1, n_fields);
+    }
+}
+
+void setUp(void)
+{
+    struct bme68x_dev dev;
+
+    memset(&dev, 0, sizeof(dev));   // the shadow survives bme68x_init, the recording must not start from stack leftovers
+    bme68x_sim_init(&sim, BME68X_VARIANT_GAS_LOW, &bme68x_sim_default_calib);
+    bme68x_sim_attach(&sim, &dev);
+    dev.read = recording_read;
+    dev.write = recording_write;
+    bme_i2c_trace_init(&trace, trace_buf, sizeof(trace_buf));
+    run_session(&dev, &sim, BME68X_OS_2X, 0, recorded);
+    TEST_ASSERT_EQUAL_UINT32(0, trace.dropped);
+}
+
+void tearDown(void)
+{
+}
+
+/**
+ * @brief Compare two measurements member by member, the padding of struct bme68x_data holds whatever the stack did
+ *
+ * @param heater also compare the heater settings, which the raw path leaves out
+ */
+static void assert_same_data(const struct bme68x_data* expected, const struct bme68x_data* actual, uint8_t heater)
+{
+    TEST_ASSERT_EQUAL_HEX8(expected->status, actual->status);
+    TEST_ASSERT_EQUAL_UINT8(expected->gas_index, actual->gas_index);
+    TEST_ASSERT_EQUAL_UINT8(expected->meas_index, actual->meas_index);
+    if(heater)
+    {
+        TEST_ASSERT_EQUAL_UINT8(expected->res_heat, actual->res_heat);
+        TEST_ASSERT_EQUAL_UINT8(expected->idac, actual->idac);
+        TEST_ASSERT_EQUAL_UINT8(expected->gas_wait, actual->gas_wait);
+    }
+    TEST_ASSERT_EQUAL_MEMORY(&expected->temperature, &actual->temperature, sizeof(expected->temperature));
+    TEST_ASSERT_EQUAL_MEMORY(&expected->pressure, &actual->pressure, sizeof(expected->pressure));
+    TEST_ASSERT_EQUAL_MEMORY(&expected->humidity, &actual->humidity, sizeof(expected->humidity));
+    TEST_ASSERT_EQUAL_MEMORY(&expected->gas_resistance, &actual->gas_resistance, sizeof(expected->gas_resistance));
+}
+
+static void start_replay(struct bme_i2c_replay* replay, struct bme68x_dev* dev)
+{
+    memset(dev, 0, sizeof(struct bme68x_dev));
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme_i2c_replay_init(replay, trace_buf, bme_i2c_trace_len(&trace)));
+    bme_i2c_replay_attach(replay, dev);
+    dev->amb_temp = 25;
+}
+
+static void test_replay_same_session(void)
+{
+    static struct bme_i2c_replay replay;
+    struct bme68x_dev dev;
+    struct bme68x_data data[N_MEAS];
+
+    start_replay(&replay, &dev);
+    run_session(&dev, NULL, BME68X_OS_2X, 0, data);
+
+    TEST_ASSERT_EQUAL_UINT32(0, replay.mismatches);
+    TEST_ASSERT_FALSE(replay.exhausted);
+    TEST_ASSERT_EQUAL_UINT32(trace.records, replay.transfers);
+    for(uint8_t i = 0; i < N_MEAS; i++)
+    {
+        assert_same_data(&recorded[i], &data[i], 1);
+    }
+}
+
+/**
+ * @brief A driver that reads less often than the recorded one still gets every measurement, and nothing is reported
+ *
+ * @details The raw path leaves out the heater settings read of every bme68x_get_data.
+ */
+static void test_replay_fewer_reads(void)
+{
+    static struct bme_i2c_replay replay;
+    struct bme68x_dev dev;
+    struct bme68x_data data[N_MEAS];
+
+    start_replay(&replay, &dev);
+    run_session(&dev, NULL, BME68X_OS_2X, 1, data);
+
+    TEST_ASSERT_EQUAL_UINT32(0, replay.mismatches);
+    TEST_ASSERT_TRUE(replay.transfers < trace.records);
+    for(uint8_t i = 0; i < N_MEAS; i++)
+    {
+        assert_same_data(&recorded[i], &data[i], 0);
+    }
+}
+
+/**
+ * @brief Writes grouped into other transfers, repeated or of contents the register already holds are not differences
+ *
+ */
+static void test_replay_regrouped_writes(void)
+{
+    static struct bme_i2c_replay replay;
+    struct bme68x_dev dev;
+    struct bme68x_conf conf;
+    uint8_t ctrl_gas_1 = 0;
+    uint8_t reg = BME68X_REG_CTRL_GAS_1;
+
+    start_replay(&replay, &dev);
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_init(&dev));
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_get_conf(&conf, &dev));
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_get_conf(&conf, &dev));
+    conf.os_temp = BME68X_OS_2X;
+    conf.os_pres = BME68X_OS_16X;
+    conf.os_hum = BME68X_OS_1X;
+    conf.filter = BME68X_FILTER_OFF;
+    conf.odr = BME68X_ODR_NONE;
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_set_conf(&conf, &dev));
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_set_conf(&conf, &dev));
+
+    // Whatever the recording wrote to ctrl_gas_1, written again on its own
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_get_regs(reg, &ctrl_gas_1, 1, &dev));
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_set_regs(&reg, &ctrl_gas_1, 1, &dev));
+
+    TEST_ASSERT_EQUAL_UINT32(0, replay.mismatches);
+}
+
+/**
+ * @brief A driver that configures the sensor differently is reported, with the register and both contents
+ *
+ */
+static void test_replay_reports_changed_contents(void)
+{
+    static struct bme_i2c_replay replay;
+    struct bme68x_dev dev;
+    struct bme68x_data data[N_MEAS];
+    uint8_t expected = (uint8_t)(BME68X_OS_2X << BME68X_OST_POS);
+
+    start_replay(&replay, &dev);
+    run_session(&dev, NULL, BME68X_OS_4X, 0, data);
+
+    TEST_ASSERT_TRUE(replay.mismatches > 0);
+    TEST_ASSERT_EQUAL_HEX8(BME68X_REG_CTRL_MEAS, replay.mismatch_reg);
+    TEST_ASSERT_EQUAL_HEX8(expected, replay.mismatch_recorded & BME68X_OST_MSK);
+    TEST_ASSERT_EQUAL_HEX8((uint8_t)(BME68X_OS_4X << BME68X_OST_POS), replay.mismatch_written & BME68X_OST_MSK);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_replay_same_session);
+    RUN_TEST(test_replay_fewer_reads);
+    RUN_TEST(test_replay_regrouped_writes);
+    RUN_TEST(test_replay_reports_changed_contents);
+    return UNITY_END();
+}
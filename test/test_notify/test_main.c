@@ -0,0 +1,155 @@
+#include <unity.h>
+#include <string.h>
+#include "esp_bme_notify.h"
+
+#define WAIT_US         123456
+
+
+extern int64_t virtual_now_us;
+
+/* The esp_timer and task notification behind the notifier, each failure selectable */
+static struct esp_timer { int armed; } timer;
+static int create_fails, start_fails, alarm_lost;
+static int64_t alarm_us;
+
+
+void setUp(void)
+{
+    memset(&timer, 0, sizeof(timer));
+    create_fails = 0;
+    start_fails = 0;
+    alarm_lost = 0;
+    virtual_now_us = 1000000;
+}
+
+void tearDown(void)
+{
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* out)
+{
+    (void)args;
+    *out = create_fails ? NULL : &timer;
+    return create_fails ? ESP_ERR_NO_MEM : ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t handle, uint64_t timeout_us)
+{
+    TEST_ASSERT_EQUAL_PTR(&timer, handle);
+    if(start_fails)
+    {
+        return ESP_FAIL;
+    }
+    handle->armed = 1;
+    alarm_us = virtual_now_us + (int64_t)timeout_us;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t handle)
+{
+    TEST_ASSERT_EQUAL_PTR(&timer, handle);
+    handle->armed = 0;
+    return ESP_OK;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return NULL;
+}
+
+/* Blocks until the alarm fires, or for ticks if it does not */
+uint32_t ulTaskNotifyTakeIndexed(UBaseType_t index, BaseType_t clear, TickType_t ticks)
+{
+    (void)clear;
+    TEST_ASSERT_EQUAL_UINT32(BME_NOTIFY_INDEX, index);
+    if((ticks > 0) && timer.armed && !alarm_lost)
+    {
+        timer.armed = 0;
+        virtual_now_us = alarm_us;
+        return 1;
+    }
+    virtual_now_us += (int64_t)ticks * portTICK_PERIOD_MS * 1000;
+    return 0;
+}
+
+BaseType_t xTaskNotifyGiveIndexed(TaskHandle_t task, UBaseType_t index)
+{
+    (void)task;
+    (void)index;
+    return pdTRUE;
+}
+
+/**
+ * @brief Wait WAIT_US ahead on a freshly initialised notifier and return how long the task was blocked
+ *
+ */
+static int64_t wait_ahead(uint8_t expected)
+{
+    struct bme_notify notify;
+    int64_t start_us;
+
+    TEST_ASSERT_EQUAL_INT(create_fails ? ESP_ERR_NO_MEM : ESP_OK, bme_notify_init(&notify));
+    start_us = virtual_now_us;
+    TEST_ASSERT_EQUAL_UINT8(expected, bme_notify_wait_until(&notify, start_us + WAIT_US));
+    TEST_ASSERT_FALSE(timer.armed);
+    return virtual_now_us - start_us;
+}
+
+static void test_woken_by_the_alarm(void)
+{
+    TEST_ASSERT_EQUAL_INT64(WAIT_US, wait_ahead(BME_NOTIFY_WOKEN));
+}
+
+static void test_skipped_when_due(void)
+{
+    struct bme_notify notify;
+
+    TEST_ASSERT_EQUAL_INT(ESP_OK, bme_notify_init(&notify));
+    TEST_ASSERT_EQUAL_UINT8(BME_NOTIFY_SKIPPED, bme_notify_wait_until(&notify, virtual_now_us));
+    TEST_ASSERT_EQUAL_INT64(1000000, virtual_now_us);
+}
+
+/**
+ * @brief An alarm that never fires is given up a few ticks late, the timer stopped
+ *
+ */
+static void test_lost_alarm_given_up(void)
+{
+    int64_t waited_us;
+
+    alarm_lost = 1;
+    waited_us = wait_ahead(BME_NOTIFY_TIMEOUT);
+    TEST_ASSERT_TRUE(waited_us >= WAIT_US);
+    TEST_ASSERT_TRUE(waited_us <= WAIT_US + ((BME_NOTIFY_SLACK_TICKS + 1) * portTICK_PERIOD_MS * 1000));
+}
+
+/**
+ * @brief Without a timer, or with one that cannot be armed, the task still sleeps until the field is ready, at most a
+ * tick late, instead of returning at once and leaving its caller to poll the sensor
+ *
+ */
+static void test_no_alarm_sleeps_on_ticks(void)
+{
+    int64_t waited_us;
+
+    create_fails = 1;
+    waited_us = wait_ahead(BME_NOTIFY_TIMEOUT);
+    TEST_ASSERT_TRUE(waited_us >= WAIT_US);
+    TEST_ASSERT_TRUE(waited_us < WAIT_US + (portTICK_PERIOD_MS * 1000));
+
+    setUp();
+    start_fails = 1;
+    waited_us = wait_ahead(BME_NOTIFY_TIMEOUT);
+    TEST_ASSERT_TRUE(waited_us >= WAIT_US);
+    TEST_ASSERT_TRUE(waited_us < WAIT_US + (portTICK_PERIOD_MS * 1000));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_woken_by_the_alarm);
+    RUN_TEST(test_skipped_when_due);
+    RUN_TEST(test_lost_alarm_given_up);
+    RUN_TEST(test_no_alarm_sleeps_on_ticks);
+    return UNITY_END();
+}
@@ -0,0 +1,227 @@
+#include <unity.h>
+#include "bme68x.h"
+#include "bme68x_sim.h"
+
+#define PROFILE_LEN     10
+#define N_ROUNDS        60      // read outs per mode test, several times around the heater profile and meas_index
+
+#ifdef BME68X_USE_FPU
+#define PRESSURE_TOLERANCE_PA   1.0
+#else
+#define PRESSURE_TOLERANCE_PA   10.0    // the integer formula's resolution
+#endif
+
+
+static struct bme68x_sim sim;
+static struct bme68x_dev dev;
+static struct bme68x_conf conf;
+static uint16_t temp_prof[PROFILE_LEN] = { 200, 240, 280, 320, 360, 360, 320, 280, 240, 200 };
+static uint16_t dur_prof[PROFILE_LEN];
+
+
+void setUp(void)
+{
+    bme68x_sim_init(&sim, BME68X_VARIANT_GAS_LOW, &bme68x_sim_default_calib);
+    bme68x_sim_attach(&sim, &dev);
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_init(&dev));
+
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_get_conf(&conf, &dev));
+    conf.os_temp = BME68X_OS_2X;
+    conf.os_pres = BME68X_OS_16X;
+    conf.os_hum = BME68X_OS_1X;
+    conf.filter = BME68X_FILTER_OFF;
+    conf.odr = BME68X_ODR_NONE;
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_set_conf(&conf, &dev));
+}
+
+void tearDown(void)
+{
+}
+
+/**
+ * @brief Compensated fields in common units, whichever build of the driver is under test
+ *
+ */
+static double field_temperature(const struct bme68x_data* data)
+{
+    #ifdef BME68X_USE_FPU
+    return data->temperature;
+    #else
+    return data->temperature / 100.0;
+    #endif
+}
+
+static double field_humidity(const struct bme68x_data* data)
+{
+    #ifdef BME68X_USE_FPU
+    return data->humidity;
+    #else
+    return data->humidity / 1000.0;
+    #endif
+}
+
+/**
+ * @brief Read every field the sensor has buffered and check they continue the sequence seen so far
+ *
+ * @details Fields must come oldest first, meas_index must count up by one across reads, wrapping at 255, and gas_index
+ * must step through the heater profile in the same order.
+ */
+static uint8_t read_in_order(uint8_t op_mode, int16_t* last_meas, int16_t* last_gas)
+{
+    struct bme68x_data fields[BME68X_SIM_N_FIELDS];
+    uint8_t n_fields = 0;
+
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_get_data(op_mode, fields, &n_fields, &dev));
+    for(uint8_t i = 0; i < n_fields; i++)
+    {
+        TEST_ASSERT_BITS_HIGH(BME68X_NEW_DATA_MSK, fields[i].status);
+        TEST_ASSERT_BITS_HIGH(BME68X_GASM_VALID_MSK | BME68X_HEAT_STAB_MSK, fields[i].status);
+        if(*last_meas >= 0)
+        {
+            TEST_ASSERT_EQUAL_UINT8((uint8_t)(*last_meas + 1), fields[i].meas_index);
+            TEST_ASSERT_EQUAL_UINT8((*last_gas + 1) % PROFILE_LEN, fields[i].gas_index);
+        }
+        *last_meas = fields[i].meas_index;
+        *last_gas = fields[i].gas_index;
+    }
+    return n_fields;
+}
+
+/**
+ * @brief Run a heater profile mode, reading at the rate given, and check that no field is lost or reordered
+ *
+ */
+static void check_profile_mode(uint8_t op_mode, const struct bme68x_heatr_conf* heatr_conf, uint32_t read_period_us)
+{
+    int16_t last_meas = -1;
+    int16_t last_gas = -1;
+    uint32_t n_read = 0;
+    uint32_t measured_before;
+
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_set_heatr_conf(op_mode, heatr_conf, &dev));
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_set_op_mode(op_mode, &dev));
+    measured_before = sim.n_measurements;
+
+    for(uint16_t round = 0; round < N_ROUNDS; round++)
+    {
+        bme68x_sim_advance(&sim, read_period_us);
+        n_read += read_in_order(op_mode, &last_meas, &last_gas);
+    }
+
+    TEST_ASSERT_TRUE(n_read > PROFILE_LEN);
+    // Only the measurement still running at the end may be missing
+    TEST_ASSERT_UINT32_WITHIN(1, sim.n_measurements - measured_before, n_read);
+}
+
+static void test_forced_mode_one_field_per_trigger(void)
+{
+    struct bme68x_heatr_conf heatr_conf = { .enable = BME68X_ENABLE, .heatr_temp = 300, .heatr_dur = 100 };
+    int16_t last_meas = -1;
+
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_set_heatr_conf(BME68X_FORCED_MODE, &heatr_conf, &dev));
+    for(uint16_t round = 0; round < 300; round++)
+    {
+        struct bme68x_data data;
+        uint8_t n_fields = 0;
+
+        TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_set_op_mode(BME68X_FORCED_MODE, &dev));
+        bme68x_sim_advance(&sim, bme68x_get_meas_dur(BME68X_FORCED_MODE, &conf, &dev) + (heatr_conf.heatr_dur * 1000));
+        TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_get_data(BME68X_FORCED_MODE, &data, &n_fields, &dev));
+        TEST_ASSERT_EQUAL_UINT8(1, n_fields);
+        TEST_ASSERT_EQUAL_UINT8(0, data.gas_index);
+        TEST_ASSERT_BITS_HIGH(BME68X_GASM_VALID_MSK | BME68X_HEAT_STAB_MSK, data.status);
+        if(last_meas >= 0)
+        {
+            TEST_ASSERT_EQUAL_UINT8((uint8_t)(last_meas + 1), data.meas_index);
+        }
+        last_meas = data.meas_index;
+    }
+}
+
+static void test_forced_mode_no_data_before_completion(void)
+{
+    struct bme68x_heatr_conf heatr_conf = { .enable = BME68X_ENABLE, .heatr_temp = 300, .heatr_dur = 100 };
+    struct bme68x_data data;
+    uint8_t n_fields = 0;
+
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_set_heatr_conf(BME68X_FORCED_MODE, &heatr_conf, &dev));
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_set_op_mode(BME68X_FORCED_MODE, &dev));
+    bme68x_sim_advance(&sim, 1000);
+    TEST_ASSERT_EQUAL_INT8(BME68X_W_NO_NEW_DATA, bme68x_get_data(BME68X_FORCED_MODE, &data, &n_fields, &dev));
+    TEST_ASSERT_EQUAL_UINT8(0, n_fields);
+}
+
+static void test_sequential_mode_in_order(void)
+{
+    struct bme68x_heatr_conf heatr_conf = {
+        .enable = BME68X_ENABLE, .heatr_temp_prof = temp_prof, .heatr_dur_prof = dur_prof, .profile_len = PROFILE_LEN
+    };
+
+    for(uint8_t i = 0; i < PROFILE_LEN; i++)
+    {
+        dur_prof[i] = 100;
+    }
+    // Slower than one field per read, so most reads find the buffer holding two or three of them
+    check_profile_mode(BME68X_SEQUENTIAL_MODE, &heatr_conf, 250000);
+}
+
+static void test_parallel_mode_in_order(void)
+{
+    struct bme68x_heatr_conf heatr_conf = {
+        .enable = BME68X_ENABLE, .heatr_temp_prof = temp_prof, .heatr_dur_prof = dur_prof, .profile_len = PROFILE_LEN
+    };
+
+    for(uint8_t i = 0; i < PROFILE_LEN; i++)
+    {
+        dur_prof[i] = 5;
+    }
+    heatr_conf.shared_heatr_dur = 140 - (bme68x_get_meas_dur(BME68X_PARALLEL_MODE, &conf, &dev) / 1000);
+    check_profile_mode(BME68X_PARALLEL_MODE, &heatr_conf, 1500000);
+}
+
+/**
+ * @brief The driver must read back the environment the simulated part was set to measure
+ *
+ * @details The simulator inverts the datasheet formulas to produce the ADC words, so any difference left is the ADC
+ * quantisation and the integer build's rounding.
+ */
+static void test_compensation_matches_environment(void)
+{
+    static const struct bme68x_sim_env envs[] = {
+        { 25.0, 101325.0, 40.0, 50000.0 },
+        { -30.0, 80000.0, 5.0, 3000.0 },
+        { 60.0, 100000.0, 95.0, 1000000.0 },
+        { 0.0, 95000.0, 50.0, 200.0 },
+        { 40.0, 105000.0, 20.0, 20000.0 },
+    };
+    struct bme68x_heatr_conf heatr_conf = { .enable = BME68X_ENABLE, .heatr_temp = 300, .heatr_dur = 100 };
+
+    TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_set_heatr_conf(BME68X_FORCED_MODE, &heatr_conf, &dev));
+    for(uint8_t i = 0; i < (sizeof(envs) / sizeof(envs[0])); i++)
+    {
+        struct bme68x_data data;
+        uint8_t n_fields = 0;
+
+        bme68x_sim_set_env(&sim, &envs[i]);
+        TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_set_op_mode(BME68X_FORCED_MODE, &dev));
+        bme68x_sim_advance(&sim, bme68x_get_meas_dur(BME68X_FORCED_MODE, &conf, &dev) + (heatr_conf.heatr_dur * 1000));
+        TEST_ASSERT_EQUAL_INT8(BME68X_OK, bme68x_get_data(BME68X_FORCED_MODE, &data, &n_fields, &dev));
+        TEST_ASSERT_EQUAL_UINT8(1, n_fields);
+
+        TEST_ASSERT_DOUBLE_WITHIN(0.02, envs[i].temperature, field_temperature(&data));
+        TEST_ASSERT_DOUBLE_WITHIN(PRESSURE_TOLERANCE_PA, envs[i].pressure, (double)data.pressure);
+        TEST_ASSERT_DOUBLE_WITHIN(0.1, envs[i].humidity, field_humidity(&data));
+        TEST_ASSERT_DOUBLE_WITHIN(envs[i].gas_resistance * 0.01, envs[i].gas_resistance, (double)data.gas_resistance);
+    }
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_forced_mode_one_field_per_trigger);
+    RUN_TEST(test_forced_mode_no_data_before_completion);
+    RUN_TEST(test_sequential_mode_in_order);
+    RUN_TEST(test_parallel_mode_in_order);
+    RUN_TEST(test_compensation_matches_environment);
+    return UNITY_END();
+}
@@ -0,0 +1,201 @@
+#include <unity.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <unistd.h>
+#include "esp_bme_snapshot.h"
+#include "esp_bme_format.h"
+
+#define N_READERS       4
+#define N_PUBLISHES     200000
+
+
+static struct bme_snapshot snap;
+static atomic_int writer_done;
+
+
+void setUp(void)
+{
+    bme_snapshot_init(&snap);
+    atomic_store(&writer_done, 0);
+}
+
+void tearDown(void)
+{
+}
+
+/**
+ * @brief The sample published as number id. Every field derives from id, so a torn copy shows as a mismatch
+ *
+ */
+static void make_sample(uint32_t id, struct bme68x_data* data)
+{
+    memset(data, 0, sizeof(struct bme68x_data));
+    data->status = BME68X_NEW_DATA_MSK;
+    data->meas_index = (uint8_t)id;
+    #ifdef BME68X_USE_FPU
+    data->temperature = (float)(id % 10000) / 100.0f;
+    data->pressure = (float)id;
+    data->humidity = (float)(id % 100);
+    data->gas_resistance = (float)id;
+    #else
+    data->temperature = (int16_t)(id % 10000);
+    data->pressure = id;
+    data->humidity = (id % 100) * 1000;
+    data->gas_resistance = id;
+    #endif
+}
+
+/**
+ * @brief What one reader thread saw. Unity asserts only on the main thread, so readers count instead
+ *
+ */
+struct reader_result
+{
+    uint32_t checked;
+    uint32_t torn;          // copies that were not one whole published sample
+    uint32_t backwards;     // sample numbers lower than one seen before, including a failed read after a good one
+};
+
+/**
+ * @brief Reader thread: every copy must be one whole published sample, and sample numbers must never go backwards
+ *
+ */
+static void* reader(void* arg)
+{
+    struct reader_result* result = arg;
+    uint32_t last_id = 0;
+    uint8_t use_json = 0;
+
+    while(!atomic_load(&writer_done))
+    {
+        struct bme68x_data data, expected;
+        char json[BME_SNAPSHOT_JSON_LEN];
+        char expected_json[BME_SNAPSHOT_JSON_LEN];
+        size_t json_len;
+        uint32_t id;
+
+        if(use_json)
+        {
+            id = bme_snapshot_read_json(&snap, json, sizeof(json), &json_len);
+            if(id != 0)
+            {
+                make_sample(id, &expected);
+                bme_format_json(expected_json, sizeof(expected_json), &expected);
+                result->torn += ((strcmp(expected_json, json) != 0) || (strlen(expected_json) != json_len)) ? 1 : 0;
+            }
+        }
+        else
+        {
+            id = bme_snapshot_read(&snap, &data);
+            if(id != 0)
+            {
+                make_sample(id, &expected);
+                result->torn += (memcmp(&expected, &data, sizeof(struct bme68x_data)) != 0) ? 1 : 0;
+            }
+        }
+        result->backwards += (id < last_id) ? 1 : 0;
+        last_id = id;
+        use_json = !use_json;
+        result->checked++;
+    }
+    return NULL;
+}
+
+static void* read_once(void* arg)
+{
+    struct bme68x_data data;
+    *(uint32_t*)arg = bme_snapshot_read(&snap, &data);
+    return NULL;
+}
+
+static void test_read_before_first_publish(void)
+{
+    struct bme68x_data data;
+    char json[BME_SNAPSHOT_JSON_LEN];
+    size_t json_len = 1;
+
+    TEST_ASSERT_EQUAL_UINT32(0, bme_snapshot_read(&snap, &data));
+    TEST_ASSERT_EQUAL_UINT32(0, bme_snapshot_read_json(&snap, json, sizeof(json), &json_len));
+    TEST_ASSERT_EQUAL_size_t(0, json_len);
+    TEST_ASSERT_EQUAL_STRING("", json);
+}
+
+static void test_publish_numbers_samples(void)
+{
+    struct bme68x_data data, out;
+
+    for(uint32_t id = 1; id <= 3; id++)
+    {
+        make_sample(id, &data);
+        TEST_ASSERT_EQUAL_UINT32(id, bme_snapshot_publish(&snap, &data));
+        TEST_ASSERT_EQUAL_UINT32(id, bme_snapshot_read(&snap, &out));
+        TEST_ASSERT_EQUAL_MEMORY(&data, &out, sizeof(struct bme68x_data));
+    }
+}
+
+/**
+ * @brief A reader that finds the writer held mid publish waits for it instead of failing
+ *
+ * @details Recreates a writer preempted between making seq odd and even again, longer than any number of spins.
+ */
+static void test_reader_waits_out_stalled_writer(void)
+{
+    pthread_t thread;
+    uint32_t id = 0;
+    struct bme68x_data data;
+
+    make_sample(1, &data);
+    bme_snapshot_publish(&snap, &data);
+    atomic_store(&snap.seq, 3);     // publish of sample 2 started
+
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&thread, NULL, read_once, &id));
+    usleep(50000);
+    make_sample(2, &data);
+    memcpy(&snap.data, &data, sizeof(struct bme68x_data));
+    atomic_store(&snap.seq, 4);     // and finished
+    TEST_ASSERT_EQUAL_INT(0, pthread_join(thread, NULL));
+
+    TEST_ASSERT_EQUAL_UINT32(2, id);
+}
+
+/**
+ * @brief Readers on other threads race a writer publishing back to back. None may see a torn sample or give up
+ *
+ * @details On the host nothing keeps the writer from being preempted mid publish, so readers regularly find seq odd
+ * and have to wait it out, the case that used to end in a failed read.
+ */
+static void test_concurrent_readers_never_torn(void)
+{
+    pthread_t threads[N_READERS];
+    struct reader_result results[N_READERS] = { 0 };
+    struct bme68x_data data;
+
+    for(uint8_t i = 0; i < N_READERS; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&threads[i], NULL, reader, &results[i]));
+    }
+    for(uint32_t id = 1; id <= N_PUBLISHES; id++)
+    {
+        make_sample(id, &data);
+        bme_snapshot_publish(&snap, &data);
+    }
+    atomic_store(&writer_done, 1);
+    for(uint8_t i = 0; i < N_READERS; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(0, pthread_join(threads[i], NULL));
+        TEST_ASSERT_TRUE(results[i].checked > 0);
+        TEST_ASSERT_EQUAL_UINT32(0, results[i].torn);
+        TEST_ASSERT_EQUAL_UINT32(0, results[i].backwards);
+    }
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_read_before_first_publish);
+    RUN_TEST(test_publish_numbers_samples);
+    RUN_TEST(test_reader_waits_out_stalled_writer);
+    RUN_TEST(test_concurrent_readers_never_torn);
+    return UNITY_END();
+}
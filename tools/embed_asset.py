@@ -0,0 +1,46 @@
+#!/usr/bin/env python3
+"""Embed a web asset in the firmware as a gzip blob.
+
+Writes a C file defining <name>_gz[], <name>_gz_len and <name>_etag, where the
+ETag is a quoted hash of the uncompressed asset. The gzip header carries no
+mtime or file name, so identical input always produces an identical blob.
+
+usage: embed_asset.py <input> <output.c> <symbol name>
+"""
+import gzip
+import hashlib
+import sys
+
+
+def main():
+    if len(sys.argv) != 4:
+        sys.exit(__doc__)
+    src, dst, name = sys.argv[1:]
+
+    with open(src, "rb") as f:
+        raw = f.read()
+    blob = gzip.compress(raw, compresslevel=9, mtime=0)
+    etag = '"' + hashlib.sha1(raw).hexdigest()[:16] + '"'
+
+    lines = [
+        "/* Generated by tools/embed_asset.py from %s. Do not edit. */" % src.replace("\\", "/").split("/")[-1],
+        "#include <stddef.h>",
+        "#include <stdint.h>",
+        "",
+        "const uint8_t %s_gz[] = {" % name,
+    ]
+    for i in range(0, len(blob), 16):
+        lines.append("    " + ", ".join("0x%02x" % b for b in blob[i:i + 16]) + ",")
+    lines += [
+        "};",
+        "const size_t %s_gz_len = %d;    /* %d bytes uncompressed */" % (name, len(blob), len(raw)),
+        'const char %s_etag[] = "%s";' % (name, etag.replace('"', '\\"')),
+        "",
+    ]
+
+    with open(dst, "w", newline="\n") as f:
+        f.write("\n".join(lines))
+
+
+if __name__ == "__main__":
+    main()